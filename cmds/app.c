@@ -14,7 +14,7 @@
  */
 
 #include "cmd.h"
-#include "elf.h"
+#include "load.h"
 
 #include <lib/lib.h>
 #include <hal/hal.h>
@@ -28,74 +28,15 @@ static void cmd_appInfo(void)
 }
 
 
-static int cmd_cp2ent(handler_t handler, const mapent_t *entry)
-{
-	ssize_t len;
-	u8 buff[SIZE_MSG_BUFF];
-	size_t offs, sz = entry->end - entry->start;
-
-	for (offs = 0; offs < sz; offs += len) {
-		if ((len = phfs_read(handler, offs, buff, min(SIZE_MSG_BUFF, sz - offs))) < 0) {
-			log_error("\nCan't read data");
-			return len;
-		}
-		hal_memcpy((void *)(entry->start + offs), buff, len);
-	}
-
-	return EOK;
-}
-
-
-static int cmd_mapsAdd2Prog(u8 *mapIDs, size_t nb, const char *mapNames)
-{
-	u8 id;
-	int res, i;
-
-	for (i = 0; i < nb; ++i) {
-		if ((res = syspage_mapNameResolve(mapNames, &id)) < 0) {
-			log_error("\nCan't add map %s", mapNames);
-			return res;
-		}
-
-		mapIDs[i] = id;
-		mapNames += hal_strlen(mapNames) + 1; /* name + '\0' */
-	}
-
-	return EOK;
-}
-
-
-static size_t cmd_mapsParse(char *maps, char sep)
-{
-	size_t nb = 0;
-
-	while (*maps != '\0') {
-		if (*maps == sep) {
-			*maps = '\0';
-			++nb;
-		}
-		maps++;
-	}
-
-	return ++nb;
-}
-
-
 static int cmd_appLoad(handler_t handler, size_t size, const char *name, char *imaps, char *dmaps, const char *appArgv, u32 flags)
 {
 	int res;
 	Elf32_Ehdr hdr;
-
-	unsigned int attr;
 	size_t dmapSz, imapSz;
-	addr_t start, end, offs, addr;
-
-	syspage_prog_t *prog;
 	const mapent_t *entry;
 
 	/* Check ELF header */
-	if ((res = phfs_read(handler, 0, &hdr, sizeof(Elf32_Ehdr))) < 0) {
-		log_error("\nCan't read data");
+	if ((res = cmd_loadCopy(handler, 0, &hdr, sizeof(Elf32_Ehdr))) < 0) {
 		return res;
 	}
 
@@ -108,58 +49,14 @@ static int cmd_appLoad(handler_t handler, size_t size, const char *name, char *i
 	imapSz = cmd_mapsParse(imaps, ';');
 	dmapSz = cmd_mapsParse(dmaps, ';');
 
-	if (syspage_mapAttrResolve(imaps, &attr) < 0 ||
-			syspage_mapRangeResolve(imaps, &start, &end) < 0) {
-		log_error("\n%s does not exist", imaps);
-		return -EINVAL;
-	}
-
-	if (phfs_aliasAddrResolve(handler, &offs) < 0)
-		offs = 0;
-
-	/* Check whether map's range coincides with device's address space */
-	if ((res = phfs_map(handler, offs, size, mAttrRead | mAttrExec, start, end - start, attr, &addr)) < 0) {
-		log_error("\nDevice is not mappable in %s", imaps);
+	if ((res = cmd_loadImage(handler, 0, size, imaps, mAttrRead | mAttrExec, flags, &entry)) < 0) {
 		return res;
 	}
 
-	if (res == dev_isMappable || (res == dev_isNotMappable && (flags & flagSyspageNoCopy) != 0)) {
-		if ((entry = syspage_entryAdd(NULL, addr + offs, size, SIZE_PAGE)) == NULL) {
-			log_error("\nCannot allocate memory for %s", name);
-			return -ENOMEM;
-		}
-	}
-	else if (res == dev_isNotMappable) {
-		if ((entry = syspage_entryAdd(imaps, (addr_t)-1, size, SIZE_PAGE)) == NULL) {
-			log_error("\nCannot allocate memory for %s", name);
-			return -ENOMEM;
-		}
-
-		/* Copy elf file to selected entry */
-		if ((res = cmd_cp2ent(handler, entry)) < 0)
-			return res;
-	}
-	else {
-		log_error("\nDevice mappable routine failed");
-		return -ENOMEM;
-	}
-
-	if ((prog = syspage_progAdd(appArgv, flags)) == NULL ||
-			(prog->imaps = syspage_alloc(imapSz * sizeof(u8))) == NULL ||
-			(prog->dmaps = syspage_alloc(dmapSz * sizeof(u8))) == NULL) {
-		log_error("\nCannot allocate memory for %s", name);
-		return -ENOMEM;
-	}
-
-
-	if ((res = cmd_mapsAdd2Prog(prog->imaps, imapSz, imaps)) < 0 ||
-			(res = cmd_mapsAdd2Prog(prog->dmaps, dmapSz, dmaps)) < 0)
+	if ((res = cmd_loadProg(appArgv, flags, imaps, imapSz, dmaps, dmapSz, entry)) < 0) {
+		log_error("\nCannot add %s to syspage", name);
 		return res;
-
-	prog->imapSz = imapSz;
-	prog->dmapSz = dmapSz;
-	prog->start = entry->start;
-	prog->end = entry->end;
+	}
 
 	return EOK;
 }
@@ -0,0 +1,299 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Memory bandwidth and latency benchmark
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <hal/hal.h>
+#include <lib/lib.h>
+#include <syspage.h>
+
+#include "cmd.h"
+
+
+#define BENCH_MAX_REGIONS 8
+#define BENCH_MAX_SIZE    (16u * 1024u * 1024u) /* Default limit of the tested area */
+#define BENCH_MIN_SIZE    (16u * 1024u)
+#define BENCH_MIN_WSET    1024u
+#define BENCH_LINE        64u   /* Pointer chasing stride, at least a cache line on supported targets */
+#define BENCH_MIN_TIME    100   /* Minimal duration of a single measurement in ms */
+#define BENCH_CHASE_STEPS 4096u /* Loads between timer reads */
+#define BENCH_SCALAR      3u
+
+#define BENCH_CSV (1u << 0)
+
+
+typedef struct {
+	const char *name; /* NULL for address range */
+	addr_t start;
+	size_t size;
+} bench_region_t;
+
+
+static struct {
+	bench_region_t regions[BENCH_MAX_REGIONS];
+	size_t nregions;
+	size_t maxSize;
+	u32 flags;
+	u32 seed;
+} benchmem_common;
+
+
+static void cmd_benchMemInfo(void)
+{
+	lib_printf("measures memory bandwidth and latency, usage: bench-mem [-c] [-s <size>] -m <map> | -a <addr>:<size>");
+}
+
+
+static void cmd_benchMemUsage(void)
+{
+	lib_printf(
+		"Usage: bench-mem [options]\n"
+		"\t-m map        Benchmark free area of the map (can be repeated)\n"
+		"\t-a addr:size  Benchmark memory range, its content is destroyed (can be repeated)\n"
+		"\t-s size       Maximal size of the tested area (default=%u)\n"
+		"\t-c            CSV output\n",
+		BENCH_MAX_SIZE);
+}
+
+
+static void cmd_benchMemResult(const bench_region_t *r, const char *test, size_t size, u32 value, const char *unit)
+{
+	if ((benchmem_common.flags & BENCH_CSV) != 0u) {
+		lib_printf("\n%s,%s,%zu,%u,%s", (r->name != NULL) ? r->name : "-", test, size, value, unit);
+	}
+	else {
+		lib_printf("\n%-8s %9zu B %8u %s", test, size, value, unit);
+	}
+}
+
+
+/* Returns MB/s for 'bytes' transferred 'passes' times in 'elapsed' ms */
+static u32 cmd_benchMemRate(u64 bytes, u32 passes, time_t elapsed)
+{
+	return (u32)((bytes * passes * 1000u) / ((u64)elapsed * 1000000u));
+}
+
+
+/* STREAM-like kernels on word arrays, floating point is not available on all targets */
+static void cmd_benchMemStream(const bench_region_t *r)
+{
+	static const char *const names[] = { "copy", "scale", "add", "triad" };
+	static const unsigned int words[] = { 2, 2, 3, 3 }; /* Words transferred per element */
+	size_t n = r->size / (3u * sizeof(u32)), i;
+	u32 *a = (u32 *)r->start, *b = a + n, *c = b + n;
+	unsigned int k, passes;
+	time_t start, elapsed;
+
+	for (i = 0; i < n; i++) {
+		a[i] = 1;
+		b[i] = 2;
+		c[i] = 0;
+	}
+
+	for (k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+		passes = 0;
+		start = hal_timerGet();
+		do {
+			switch (k) {
+				case 0:
+					hal_memcpy(c, a, n * sizeof(u32));
+					break;
+
+				case 1:
+					for (i = 0; i < n; i++) {
+						b[i] = BENCH_SCALAR * c[i];
+					}
+					break;
+
+				case 2:
+					for (i = 0; i < n; i++) {
+						c[i] = a[i] + b[i];
+					}
+					break;
+
+				default:
+					for (i = 0; i < n; i++) {
+						a[i] = b[i] + BENCH_SCALAR * c[i];
+					}
+					break;
+			}
+			hal_cpuDataMemoryBarrier();
+			passes++;
+			elapsed = hal_timerGet() - start;
+		} while (elapsed < BENCH_MIN_TIME);
+
+		cmd_benchMemResult(r, names[k], n * sizeof(u32), cmd_benchMemRate((u64)n * words[k] * sizeof(u32), passes, elapsed), "MB/s");
+	}
+}
+
+
+/* Dependent loads over a random cyclic permutation of lines defeat prefetching */
+static void cmd_benchMemChase(const bench_region_t *r)
+{
+	size_t wset, lines, i, j;
+	void *volatile *p;
+	void *tmp;
+	u64 loads;
+	time_t start, elapsed;
+
+	for (wset = BENCH_MIN_WSET; wset <= r->size; wset <<= 1) {
+		lines = wset / BENCH_LINE;
+
+		/* Sattolo's algorithm, each line points to the next one in a single cycle */
+		for (i = 0; i < lines; i++) {
+			*(void **)(r->start + i * BENCH_LINE) = (void *)(r->start + i * BENCH_LINE);
+		}
+		for (i = lines - 1; i > 0; i--) {
+			j = lib_rand(&benchmem_common.seed) % i;
+			tmp = *(void **)(r->start + i * BENCH_LINE);
+			*(void **)(r->start + i * BENCH_LINE) = *(void **)(r->start + j * BENCH_LINE);
+			*(void **)(r->start + j * BENCH_LINE) = tmp;
+		}
+
+		p = (void *volatile *)r->start;
+		loads = 0;
+		start = hal_timerGet();
+		do {
+			for (i = 0; i < BENCH_CHASE_STEPS; i++) {
+				p = (void *volatile *)*p;
+			}
+			loads += BENCH_CHASE_STEPS;
+			elapsed = hal_timerGet() - start;
+		} while (elapsed < BENCH_MIN_TIME);
+
+		cmd_benchMemResult(r, "latency", wset, (u32)(((u64)elapsed * 1000000u) / loads), "ns");
+	}
+}
+
+
+static int cmd_benchMemRegion(bench_region_t *r)
+{
+	unsigned int attr = 0;
+	int res;
+
+	if (r->name != NULL) {
+		/* Test the largest free area up to the limit, loaded images are left intact */
+		for (r->size = benchmem_common.maxSize; r->size >= BENCH_MIN_SIZE; r->size >>= 1) {
+			res = syspage_mapFreeArea(r->name, r->size, BENCH_LINE, &r->start);
+			if (res == EOK) {
+				break;
+			}
+			if (res == -EINVAL) {
+				return res;
+			}
+		}
+		if (r->size < BENCH_MIN_SIZE) {
+			log_error("\nNot enough free memory in %s", r->name);
+			return -ENOMEM;
+		}
+		(void)syspage_mapAttrResolve(r->name, &attr);
+	}
+	else {
+		(void)syspage_mapRangeCheck(r->start, r->start + r->size, &attr);
+	}
+
+	if ((benchmem_common.flags & BENCH_CSV) == 0u) {
+		lib_printf("\nbench-mem: %s 0x%p-0x%p%s%s", (r->name != NULL) ? r->name : "range", (void *)r->start, (void *)(r->start + r->size),
+			((attr & mAttrCacheable) != 0u) ? " cacheable" : "", ((attr & mAttrBufferable) != 0u) ? " bufferable" : "");
+	}
+
+	cmd_benchMemStream(r);
+	cmd_benchMemChase(r);
+
+	return EOK;
+}
+
+
+static int cmd_benchMem(int argc, char *argv[])
+{
+	int opt;
+	size_t i;
+	char *endptr;
+	bench_region_t *r;
+
+	hal_memset(&benchmem_common, 0, sizeof(benchmem_common));
+	benchmem_common.maxSize = BENCH_MAX_SIZE;
+	benchmem_common.seed = LIB_RAND_SEED;
+
+	for (;;) {
+		opt = lib_getopt(argc, argv, "m:a:s:ch");
+		if (opt < 0) {
+			break;
+		}
+
+		switch (opt) {
+			case 'm':
+			case 'a':
+				if (benchmem_common.nregions >= BENCH_MAX_REGIONS) {
+					log_error("\nToo many regions");
+					return CMD_EXIT_FAILURE;
+				}
+				r = &benchmem_common.regions[benchmem_common.nregions++];
+				if (opt == 'm') {
+					r->name = optarg;
+					break;
+				}
+
+				r->start = lib_strtoul(optarg, &endptr, 0);
+				if (*endptr != ':') {
+					log_error("\nInvalid range");
+					return CMD_EXIT_FAILURE;
+				}
+				r->size = lib_strtoul(endptr + 1, &endptr, 0);
+				if ((*endptr != '\0') || (r->size < BENCH_MIN_WSET) || ((r->start + r->size) < r->start)) {
+					log_error("\nInvalid range");
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			case 's':
+				benchmem_common.maxSize = lib_strtoul(optarg, &endptr, 0);
+				if ((*endptr != '\0') || (benchmem_common.maxSize < BENCH_MIN_SIZE)) {
+					log_error("\nInvalid size");
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			case 'c':
+				benchmem_common.flags |= BENCH_CSV;
+				break;
+
+			case 'h':
+			default:
+				cmd_benchMemUsage();
+				return CMD_EXIT_SUCCESS;
+		}
+	}
+
+	if (benchmem_common.nregions == 0) {
+		cmd_benchMemUsage();
+		return CMD_EXIT_FAILURE;
+	}
+
+	if ((benchmem_common.flags & BENCH_CSV) != 0u) {
+		lib_printf("\nregion,test,size,value,unit");
+	}
+
+	for (i = 0; i < benchmem_common.nregions; i++) {
+		if (cmd_benchMemRegion(&benchmem_common.regions[i]) < 0) {
+			return CMD_EXIT_FAILURE;
+		}
+	}
+	lib_printf("\n");
+
+	return CMD_EXIT_SUCCESS;
+}
+
+
+static const cmd_t benchmem_cmd __attribute__((section("commands"), used)) = {
+	.name = "bench-mem", .run = cmd_benchMem, .info = cmd_benchMemInfo
+};
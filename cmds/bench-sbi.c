@@ -0,0 +1,117 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * SBI trap and call cost benchmark
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <hal/hal.h>
+#include <hal/riscv64/csr.h>
+#include <lib/lib.h>
+
+#include "cmd.h"
+
+
+#define BENCH_DEF_ITERS 100000u
+
+
+/* Counter reads trap to SBI only on harts without the counters implemented (e.g. QEMU with zicntr=false) */
+enum { bench_rdtime, bench_rdcycle, bench_rdinstret, bench_ecallTime, bench_ecallBase, bench_count };
+
+
+static void cmd_benchSbiInfo(void)
+{
+	lib_printf("measures cost of counter reads and SBI calls, usage: bench-sbi [iterations]");
+}
+
+
+static void cmd_benchSbiRun(unsigned int test, u32 iters)
+{
+	u32 i;
+
+	switch (test) {
+		case bench_rdtime:
+			for (i = 0; i < iters; i++) {
+				(void)csr_read(CSR_TIME);
+			}
+			break;
+
+		case bench_rdcycle:
+			for (i = 0; i < iters; i++) {
+				(void)csr_read(CSR_CYCLE);
+			}
+			break;
+
+		case bench_rdinstret:
+			for (i = 0; i < iters; i++) {
+				(void)csr_read(CSR_INSTRET);
+			}
+			break;
+
+		/* TIME is dispatched directly, plo doesn't use the timer interrupt */
+		case bench_ecallTime:
+			for (i = 0; i < iters; i++) {
+				sbi_setTimer((u64)-1);
+			}
+			break;
+
+		/* Base extension is found by the EID lookup */
+		default:
+			for (i = 0; i < iters; i++) {
+				(void)sbi_getSpecVersion();
+			}
+			break;
+	}
+}
+
+
+static int cmd_benchSbi(int argc, char *argv[])
+{
+	static const char *const names[] = { "rdtime", "rdcycle", "rdinstret", "ecall-time", "ecall-base" };
+	unsigned int test;
+	u64 time, cycles;
+	u32 iters = BENCH_DEF_ITERS;
+	char *endptr;
+
+	if (argc > 2) {
+		log_error("\n%s: Wrong argument count", argv[0]);
+		return CMD_EXIT_FAILURE;
+	}
+
+	if (argc == 2) {
+		iters = lib_strtoul(argv[1], &endptr, 0);
+		if ((*endptr != '\0') || (iters == 0)) {
+			log_error("\n%s: Wrong number of iterations", argv[0]);
+			return CMD_EXIT_FAILURE;
+		}
+	}
+
+	lib_printf("\n%-10s %10s %10s", "test", "ns/op", "cycles/op");
+
+	for (test = 0; test < bench_count; test++) {
+		/* Counters are read once per run, their own cost is amortized over iterations */
+		cycles = csr_read(CSR_CYCLE);
+		time = csr_read(CSR_TIME);
+		cmd_benchSbiRun(test, iters);
+		time = csr_read(CSR_TIME) - time;
+		cycles = csr_read(CSR_CYCLE) - cycles;
+
+		lib_printf("\n%-10s %10u %10u", names[test], (u32)((time * 1000000000u) / ((u64)TIMER_FREQ * iters)), (u32)(cycles / iters));
+	}
+
+	lib_printf("\n");
+
+	return CMD_EXIT_SUCCESS;
+}
+
+
+static const cmd_t benchsbi_cmd __attribute__((section("commands"), used)) = {
+	.name = "bench-sbi", .run = cmd_benchSbi, .info = cmd_benchSbiInfo
+};
@@ -0,0 +1,333 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Load boot bundle (kernel, applications and blobs in a single image)
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "cmd.h"
+#include "load.h"
+#include "bundle.h"
+
+#include <lib/lib.h>
+#include <hal/hal.h>
+#include <phfs/phfs.h>
+#include <syspage.h>
+
+
+#define BUNDLE_MAX_PHDRS 16
+
+
+static struct {
+	bundle_ent_t toc[BUNDLE_MAX_ENTRIES];
+	ELF_PHDR phdrs[BUNDLE_MAX_PHDRS];
+} bundle_common;
+
+
+static void cmd_bundleInfo(void)
+{
+	lib_printf("loads boot bundle, usage: bundle [<dev> <name>]");
+}
+
+
+static int cmd_bundleElfCheck(const void *ehdr)
+{
+	const u8 *ident = ehdr;
+
+	if ((ident[0] != 0x7f) || (ident[1] != 'E') || (ident[2] != 'L') || (ident[3] != 'F')) {
+		log_error("\nImage isn't an ELF object");
+		return -EIO;
+	}
+
+	return EOK;
+}
+
+
+static int cmd_bundleKernel(handler_t handler, size_t fileSz, const bundle_ent_t *ent)
+{
+	int res;
+	ELF_WORD i;
+	ELF_EHDR hdr;
+	const ELF_PHDR *phdr;
+	addr_t paddr, kernelPAddr = (addr_t)-1;
+	const mapent_t *entry;
+
+	res = cmd_loadCopy(handler, ent->offs, &hdr, sizeof(hdr));
+	if (res < 0) {
+		return res;
+	}
+
+	res = cmd_bundleElfCheck(&hdr);
+	if (res < 0) {
+		return res;
+	}
+
+	if ((hdr.e_phnum > BUNDLE_MAX_PHDRS) || (hdr.e_phoff > ent->size) || ((hdr.e_phnum * sizeof(ELF_PHDR)) > (ent->size - hdr.e_phoff))) {
+		log_error("\nInvalid kernel program headers");
+		return -EINVAL;
+	}
+
+	/* Program headers are read at once, before the segments */
+	res = cmd_loadCopy(handler, ent->offs + hdr.e_phoff, bundle_common.phdrs, hdr.e_phnum * sizeof(ELF_PHDR));
+	if (res < 0) {
+		return res;
+	}
+
+	for (i = 0; i < hdr.e_phnum; i++) {
+		phdr = &bundle_common.phdrs[i];
+		if (phdr->p_type != (ELF_WORD)PHT_LOAD) {
+			continue;
+		}
+
+		if ((phdr->p_offset > ent->size) || (phdr->p_filesz > (ent->size - phdr->p_offset)) || (phdr->p_filesz > phdr->p_memsz)) {
+			log_error("\nInvalid kernel segment %u", (unsigned int)i);
+			return -EINVAL;
+		}
+
+		paddr = hal_kernelGetAddress((addr_t)phdr->p_vaddr);
+		entry = syspage_entryAdd(NULL, paddr, phdr->p_memsz, phdr->p_align);
+		if (entry == NULL) {
+			log_error("\nCannot allocate memory for kernel");
+			return -ENOMEM;
+		}
+
+		/* Save kernel's beginning address */
+		if ((phdr->p_flags & (ELF_WORD)PHF_X) != 0) {
+			kernelPAddr = entry->start;
+		}
+
+		/* Read-only segment already in place on a mappable device (XIP) */
+		if (cmd_loadXip(handler, fileSz, ent->offs, phdr, paddr) != 0) {
+			continue;
+		}
+
+		res = cmd_loadCopy(handler, ent->offs + phdr->p_offset, (void *)entry->start, phdr->p_filesz);
+		if (res < 0) {
+			return res;
+		}
+	}
+
+	hal_kernelEntryPoint(hal_kernelGetAddress(hdr.e_entry));
+	syspage_kernelPAddrAdd(kernelPAddr);
+
+	return EOK;
+}
+
+
+static int cmd_bundleApp(handler_t handler, bundle_ent_t *ent)
+{
+	int res;
+	u32 flags = 0;
+	size_t imapSz, dmapSz;
+	Elf32_Ehdr hdr;
+	const mapent_t *entry;
+
+	if ((ent->flags & BUNDLE_FLAG_EXEC) != 0) {
+		flags |= flagSyspageExec;
+	}
+
+	if ((ent->flags & BUNDLE_FLAG_NOCOPY) != 0) {
+		flags |= flagSyspageExec | flagSyspageNoCopy;
+	}
+
+	res = cmd_loadCopy(handler, ent->offs, &hdr, sizeof(hdr));
+	if (res < 0) {
+		return res;
+	}
+
+	res = cmd_bundleElfCheck(&hdr);
+	if (res < 0) {
+		return res;
+	}
+
+	/* First instance in imap is a map for the instructions */
+	imapSz = cmd_mapsParse(ent->imaps, ';');
+	dmapSz = cmd_mapsParse(ent->dmaps, ';');
+
+	res = cmd_loadImage(handler, ent->offs, ent->size, ent->imaps, mAttrRead | mAttrExec, flags, &entry);
+	if (res < 0) {
+		return res;
+	}
+
+	return cmd_loadProg(ent->argv, flags, ent->imaps, imapSz, ent->dmaps, dmapSz, entry);
+}
+
+
+static int cmd_bundleBlob(handler_t handler, bundle_ent_t *ent)
+{
+	int res;
+	syspage_prog_t *prog;
+	const mapent_t *entry;
+
+	res = cmd_loadImage(handler, ent->offs, ent->size, ent->imaps, mAttrRead, 0, &entry);
+	if (res < 0) {
+		return res;
+	}
+
+	prog = syspage_progAdd(ent->argv, 0);
+	if (prog == NULL) {
+		return -ENOMEM;
+	}
+
+	prog->imaps = NULL;
+	prog->imapSz = 0;
+	prog->dmaps = NULL;
+	prog->dmapSz = 0;
+	prog->start = entry->start;
+	prog->end = entry->end;
+
+	return EOK;
+}
+
+
+static int cmd_bundleTocCheck(const bundle_hdr_t *hdr)
+{
+	unsigned int i;
+	const bundle_ent_t *ent;
+	size_t tocSz = hdr->count * sizeof(bundle_ent_t);
+	addr_t prevEnd = sizeof(bundle_hdr_t) + tocSz;
+
+	if ((~lib_crc32((const u8 *)bundle_common.toc, tocSz, 0xffffffff)) != hdr->tocCrc) {
+		log_error("\nTOC checksum mismatch");
+		return -EINVAL;
+	}
+
+	/* Images have to be laid out in TOC order to be loaded in a single pass */
+	for (i = 0; i < hdr->count; i++) {
+		ent = &bundle_common.toc[i];
+
+		if ((ent->offs < prevEnd) || (ent->offs > hdr->size) || (ent->size > (hdr->size - ent->offs))) {
+			log_error("\nInvalid layout of entry %u", i);
+			return -EINVAL;
+		}
+		prevEnd = ent->offs + ent->size;
+
+		/* Strings are parsed in place */
+		if ((ent->argv[sizeof(ent->argv) - 1] != '\0') || (ent->imaps[sizeof(ent->imaps) - 1] != '\0') ||
+				(ent->dmaps[sizeof(ent->dmaps) - 1] != '\0')) {
+			log_error("\nEntry %u is not NULL terminated", i);
+			return -EINVAL;
+		}
+	}
+
+	return EOK;
+}
+
+
+static int cmd_bundleLoad(handler_t handler, size_t fileSz)
+{
+	int res;
+	unsigned int i;
+	bundle_hdr_t hdr;
+	bundle_ent_t *ent;
+
+	res = cmd_loadCopy(handler, 0, &hdr, sizeof(hdr));
+	if (res < 0) {
+		return res;
+	}
+
+	if ((hdr.magic != BUNDLE_MAGIC) || (hdr.version != BUNDLE_VERSION)) {
+		log_error("\nFile isn't a bundle (version %u)", BUNDLE_VERSION);
+		return -EINVAL;
+	}
+
+	if ((hdr.count > BUNDLE_MAX_ENTRIES) || (hdr.size > fileSz)) {
+		log_error("\nBundle header is invalid");
+		return -EINVAL;
+	}
+
+	/* TOC is read once, right after the header */
+	res = cmd_loadCopy(handler, sizeof(hdr), bundle_common.toc, hdr.count * sizeof(bundle_ent_t));
+	if (res < 0) {
+		return res;
+	}
+
+	res = cmd_bundleTocCheck(&hdr);
+	if (res < 0) {
+		return res;
+	}
+
+	for (i = 0; i < hdr.count; i++) {
+		ent = &bundle_common.toc[i];
+
+		switch (ent->type) {
+			case BUNDLE_TYPE_KERNEL:
+				res = cmd_bundleKernel(handler, fileSz, ent);
+				break;
+
+			case BUNDLE_TYPE_APP:
+				res = cmd_bundleApp(handler, ent);
+				break;
+
+			case BUNDLE_TYPE_BLOB:
+				res = cmd_bundleBlob(handler, ent);
+				break;
+
+			default:
+				log_error("\nUnknown type of entry %u", i);
+				res = -EINVAL;
+				break;
+		}
+
+		if (res < 0) {
+			log_error("\nCan't load entry %u (%d)", i, res);
+			return res;
+		}
+
+		log_info("\nLoaded %s", (ent->type == BUNDLE_TYPE_KERNEL) ? "kernel" : ent->argv);
+	}
+
+	return EOK;
+}
+
+
+static int cmd_bundle(int argc, char *argv[])
+{
+	int res;
+	handler_t handler;
+	phfs_stat_t stat;
+
+	if (argc == 1) {
+		syspage_progShow();
+		return CMD_EXIT_SUCCESS;
+	}
+
+	if (argc != 3) {
+		log_error("\n%s: Wrong argument count", argv[0]);
+		return CMD_EXIT_FAILURE;
+	}
+
+	res = phfs_open(argv[1], argv[2], 0, &handler);
+	if (res < 0) {
+		log_error("\nCan't open %s on %s (%d)", argv[2], argv[1], res);
+		return CMD_EXIT_FAILURE;
+	}
+
+	res = phfs_stat(handler, &stat);
+	if (res < 0) {
+		log_error("\nCan't get stat from %s (%d)", argv[2], res);
+		phfs_close(handler);
+		return CMD_EXIT_FAILURE;
+	}
+
+	res = cmd_bundleLoad(handler, stat.size);
+	phfs_close(handler);
+	if (res < 0) {
+		log_error("\nCan't load bundle %s via %s (%d)", argv[2], argv[1], res);
+		return CMD_EXIT_FAILURE;
+	}
+
+	return CMD_EXIT_SUCCESS;
+}
+
+
+static const cmd_t bundle_cmd __attribute__((section("commands"), used)) = {
+	.name = "bundle", .run = cmd_bundle, .info = cmd_bundleInfo
+};
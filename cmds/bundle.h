@@ -0,0 +1,67 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Boot bundle definitions
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _BUNDLE_H_
+#define _BUNDLE_H_
+
+#include <hal/hal.h>
+
+
+/*
+ * Bundle layout (little endian):
+ *
+ *   bundle_hdr_t
+ *   bundle_ent_t [count]
+ *   images, stored in TOC order with non-decreasing offsets
+ *
+ * Images are loaded in TOC order. Kernel program headers are read at once
+ * before its segments, which may precede them in the file.
+ */
+
+#define BUNDLE_MAGIC       0x424f4c50 /* "PLOB" */
+#define BUNDLE_VERSION     1
+#define BUNDLE_MAX_ENTRIES 16
+
+/* Entry types */
+#define BUNDLE_TYPE_KERNEL 1
+#define BUNDLE_TYPE_APP    2
+#define BUNDLE_TYPE_BLOB   3
+
+/* Entry flags */
+#define BUNDLE_FLAG_EXEC   (1 << 0) /* app: same as 'app -x' */
+#define BUNDLE_FLAG_NOCOPY (1 << 1) /* app: same as 'app -xn' */
+
+
+typedef struct {
+	u32 magic;
+	u16 version;
+	u16 count;  /* Number of TOC entries */
+	u32 size;   /* Total bundle size including header and TOC */
+	u32 tocCrc; /* CRC32 (IEEE 802.3) of the TOC */
+} __attribute__((packed)) bundle_hdr_t;
+
+
+typedef struct {
+	u8 type;
+	u8 flags;
+	u16 reserved;
+	u32 offs;       /* Image offset from the bundle start */
+	u32 size;       /* Image size */
+	char argv[84];  /* app: name;arg1;arg2..., blob: name, kernel: unused */
+	char imaps[32]; /* app: imap1;imap2..., blob: target map, kernel: unused */
+	char dmaps[32]; /* app: dmap1;dmap2..., unused otherwise */
+} __attribute__((packed)) bundle_ent_t;
+
+
+#endif
@@ -103,6 +103,7 @@ int cmd_parse(const char *script)
 	const cmd_t *cmd;
 	unsigned int found;
 	int ret, argc;
+	time_t start;
 
 	for (;;) {
 		argc = cmd_parseArgLine(&script, argline, SIZE_CMD_ARG_LINE, argv, SIZE_CMD_ARGV);
@@ -126,7 +127,10 @@ int cmd_parse(const char *script)
 			if (hal_strcmp(argv[0], cmd->name) == 0) {
 				lib_getoptReset();
 
+				start = hal_timerGet();
+				lib_perfEvent(PERF_EV_CMD_START, 0, start, argc, 0, 0, cmd->name);
 				ret = cmd->run(argc, argv);
+				lib_perfEvent(PERF_EV_CMD_END, 0, start, ret, hal_timerGet() - start, 0, cmd->name);
 				if (ret != CMD_EXIT_SUCCESS) {
 					return (ret < 0) ? ret : -EINVAL;
 				}
@@ -23,17 +23,42 @@
 
 static void cmd_goInfo(void)
 {
-	lib_printf("starts Phoenix-RTOS loaded into memory");
+	lib_printf("starts Phoenix-RTOS loaded into memory, usage: go! [-f]");
 }
 
 
 static int cmd_go(int argc, char *argv[])
 {
-	if (argc != 1) {
+	int opt, flat = 0;
+
+	for (;;) {
+		opt = lib_getopt(argc, argv, "f");
+		if (opt < 0) {
+			break;
+		}
+
+		switch (opt) {
+			case 'f':
+				/* Flat syspage layout is understood only by recent kernels */
+				flat = 1;
+				break;
+
+			default:
+				log_error("\n%s: Invalid option", argv[0]);
+				return CMD_EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc) {
 		log_error("\n%s: Command does not accept arguments", argv[0]);
 		return CMD_EXIT_FAILURE;
 	}
 
+	if ((flat != 0) && (syspage_flatten() < 0)) {
+		log_error("\n%s: Cannot create flat syspage", argv[0]);
+		return CMD_EXIT_FAILURE;
+	}
+
 	log_info("\nRunning Phoenix-RTOS\n");
 	lib_printf(CONSOLE_NORMAL CONSOLE_CURSOR_SHOW);
 
@@ -27,6 +27,9 @@
 
 #define MIN_CLEANMARKER_SIZE 12u
 
+/* Progress is reported every PROGRESS_STEP blocks */
+#define PROGRESS_STEP 64u
+
 
 struct jffs2_cleanmarker_node {
 	u16 magic;
@@ -50,7 +53,8 @@ static void cmd_jffs2Usage(void)
 
 static int cmd_jffs2(int argc, char *argv[])
 {
-	int major = -1, minor = -1, opt, err, cleanmarkers = 0, erase = 0;
+	int major = -1, minor = -1, opt, cleanmarkers = 0, erase = 0;
+	ssize_t err;
 	unsigned long blockSize = -1, numBlocks = -1, startBlock = -1, cleanmarkerSize = -1, i;
 	char *endptr;
 	struct jffs2_cleanmarker_node cleanmarker;
@@ -145,20 +149,31 @@ static int cmd_jffs2(int argc, char *argv[])
 
 	cleanmarker.hdr_crc = lib_crc32((const u8 *)&cleanmarker, sizeof(struct jffs2_cleanmarker_node) - 4u, 0);
 
+	if (erase != 0) {
+		/* Erase whole range at once, blocks already erased are skipped by the device */
+		err = devs_erase(major, minor, startBlock * blockSize, numBlocks * blockSize, DEV_ERASE_SKIPBLANK);
+		if (err < 0) {
+			log_error("\nError erasing %d\n", (int)err);
+			return CMD_EXIT_FAILURE;
+		}
+	}
+
 	lib_printf("\n");
 	for (i = 0; i < numBlocks; i++) {
-		/* FIXME should be: log_info("\rjffs2: block %lu/%lu", i, numBlocks); */
-		lib_printf("\rjffs2: block %lu/%lu", i, numBlocks);
+		if (((i % PROGRESS_STEP) == 0) || ((i + 1) == numBlocks)) {
+			/* FIXME should be: log_info("\rjffs2: block %lu/%lu", i, numBlocks); */
+			lib_printf("\rjffs2: block %lu/%lu", i + 1, numBlocks);
+		}
 
 		if (erase != 0) {
-			err = devs_erase(major, minor, (startBlock + i) * blockSize, blockSize, 0);
-			if (err < 0) {
-				log_error("\nError erasing %d\n", err);
-			}
+			/* Block is erased, program the cleanmarker directly without read-modify-write */
+			err = devs_program(major, minor, (startBlock + i) * blockSize, (const void *)&cleanmarker, sizeof(cleanmarker));
+		}
+		else {
+			err = devs_write(major, minor, (startBlock + i) * blockSize, (const void *)&cleanmarker, sizeof(cleanmarker));
 		}
-		err = devs_write(major, minor, (startBlock + i) * blockSize, (const void *)&cleanmarker, sizeof(cleanmarker));
 		if (err < 0) {
-			log_error("\nError writing %d\n", err);
+			log_error("\nError writing %d\n", (int)err);
 		}
 	}
 
@@ -14,7 +14,7 @@
  */
 
 #include "cmd.h"
-#include "elf.h"
+#include "load.h"
 
 #include <hal/hal.h>
 #include <lib/lib.h>
@@ -22,17 +22,6 @@
 #include <syspage.h>
 
 
-#if defined(__TARGET_RISCV64) || defined(__aarch64__)
-#define ELF_WORD Elf64_Word
-#define ELF_EHDR Elf64_Ehdr
-#define ELF_PHDR Elf64_Phdr
-#else
-#define ELF_WORD Elf32_Word
-#define ELF_EHDR Elf32_Ehdr
-#define ELF_PHDR Elf32_Phdr
-#endif
-
-
 static void cmd_kernelInfo(void)
 {
 	lib_printf("loads Phoenix-RTOS, usage: kernel [<dev> [name]]");
@@ -48,6 +37,8 @@ static int cmd_kernel(int argc, char *argv[])
 	handler_t handler;
 
 	size_t elfOffs = 0, segOffs;
+	phfs_stat_t stat;
+	addr_t paddr;
 
 	ELF_WORD i;
 	ELF_EHDR hdr;
@@ -69,6 +60,11 @@ static int cmd_kernel(int argc, char *argv[])
 		return CMD_EXIT_FAILURE;
 	}
 
+	/* Size is needed only to check whether the device is mappable */
+	if (phfs_stat(handler, &stat) < 0) {
+		stat.size = 0;
+	}
+
 	/* Read ELF header */
 	res = phfs_read(handler, elfOffs, &hdr, sizeof(ELF_EHDR));
 	if (res < 0) {
@@ -94,7 +90,8 @@ static int cmd_kernel(int argc, char *argv[])
 		}
 
 		if (phdr.p_type == (ELF_WORD)PHT_LOAD) {
-			entry = syspage_entryAdd(NULL, hal_kernelGetAddress((addr_t)phdr.p_vaddr), phdr.p_memsz, phdr.p_align);
+			paddr = hal_kernelGetAddress((addr_t)phdr.p_vaddr);
+			entry = syspage_entryAdd(NULL, paddr, phdr.p_memsz, phdr.p_align);
 			if (entry == NULL) {
 				log_error("\nCannot allocate memory for '%s'", kname);
 				phfs_close(handler);
@@ -106,6 +103,11 @@ static int cmd_kernel(int argc, char *argv[])
 				kernelPAddr = entry->start;
 			}
 
+			/* Read-only segment already in place on a mappable device (XIP) */
+			if (cmd_loadXip(handler, stat.size, 0, &phdr, paddr) != 0) {
+				continue;
+			}
+
 			elfOffs = phdr.p_offset;
 
 			for (segOffs = 0; segOffs < phdr.p_filesz; elfOffs += res, segOffs += res) {
@@ -0,0 +1,180 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Common routines of commands loading images
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <lib/lib.h>
+
+#include "load.h"
+
+
+int cmd_loadCopy(handler_t handler, addr_t offs, void *dst, size_t sz)
+{
+	ssize_t len;
+	size_t pos;
+
+	/* phfs_read may return less than requested */
+	for (pos = 0; pos < sz; pos += len) {
+		len = phfs_read(handler, offs + pos, (u8 *)dst + pos, sz - pos);
+		if (len <= 0) {
+			log_error("\nCan't read data");
+			return (len < 0) ? (int)len : -EIO;
+		}
+	}
+
+	return EOK;
+}
+
+
+size_t cmd_mapsParse(char *maps, char sep)
+{
+	size_t nb = 0;
+
+	while (*maps != '\0') {
+		if (*maps == sep) {
+			*maps = '\0';
+			++nb;
+		}
+		maps++;
+	}
+
+	return ++nb;
+}
+
+
+int cmd_mapsAdd2Prog(u8 *mapIDs, size_t nb, const char *mapNames)
+{
+	u8 id;
+	int res;
+	size_t i;
+
+	for (i = 0; i < nb; ++i) {
+		res = syspage_mapNameResolve(mapNames, &id);
+		if (res < 0) {
+			log_error("\nCan't add map %s", mapNames);
+			return res;
+		}
+
+		mapIDs[i] = id;
+		mapNames += hal_strlen(mapNames) + 1; /* name + '\0' */
+	}
+
+	return EOK;
+}
+
+
+int cmd_loadImage(handler_t handler, addr_t offs, size_t size, const char *map, int mode, u32 flags, const mapent_t **entry)
+{
+	int res;
+	unsigned int attr;
+	addr_t start, end, devOffs, addr;
+
+	if ((syspage_mapAttrResolve(map, &attr) < 0) || (syspage_mapRangeResolve(map, &start, &end) < 0)) {
+		log_error("\n%s does not exist", map);
+		return -EINVAL;
+	}
+
+	if (phfs_aliasAddrResolve(handler, &devOffs) < 0) {
+		devOffs = 0;
+	}
+	devOffs += offs;
+
+	/* Check whether map's range coincides with device's address space */
+	res = phfs_map(handler, devOffs, size, mode, start, end - start, attr, &addr);
+	if (res < 0) {
+		log_error("\nDevice is not mappable in %s", map);
+		return res;
+	}
+
+	if ((res == dev_isMappable) || ((res == dev_isNotMappable) && ((flags & flagSyspageNoCopy) != 0))) {
+		*entry = syspage_entryAdd(NULL, addr + devOffs, size, SIZE_PAGE);
+		if (*entry == NULL) {
+			log_error("\nCannot allocate memory in %s", map);
+			return -ENOMEM;
+		}
+	}
+	else if (res == dev_isNotMappable) {
+		*entry = syspage_entryAdd(map, (addr_t)-1, size, SIZE_PAGE);
+		if (*entry == NULL) {
+			log_error("\nCannot allocate memory in %s", map);
+			return -ENOMEM;
+		}
+
+		res = cmd_loadCopy(handler, offs, (void *)(*entry)->start, size);
+		if (res < 0) {
+			return res;
+		}
+	}
+	else {
+		log_error("\nDevice mappable routine failed");
+		return -ENOMEM;
+	}
+
+	return EOK;
+}
+
+
+int cmd_loadProg(const char *argv, u32 flags, const char *imaps, size_t imapSz, const char *dmaps, size_t dmapSz, const mapent_t *entry)
+{
+	int res;
+	syspage_prog_t *prog;
+
+	prog = syspage_progAdd(argv, flags);
+	if (prog == NULL) {
+		return -ENOMEM;
+	}
+
+	prog->imaps = syspage_alloc(imapSz * sizeof(u8));
+	prog->dmaps = syspage_alloc(dmapSz * sizeof(u8));
+	if ((prog->imaps == NULL) || (prog->dmaps == NULL)) {
+		return -ENOMEM;
+	}
+
+	res = cmd_mapsAdd2Prog(prog->imaps, imapSz, imaps);
+	if (res < 0) {
+		return res;
+	}
+
+	res = cmd_mapsAdd2Prog(prog->dmaps, dmapSz, dmaps);
+	if (res < 0) {
+		return res;
+	}
+
+	prog->imapSz = imapSz;
+	prog->dmapSz = dmapSz;
+	prog->start = entry->start;
+	prog->end = entry->end;
+
+	return EOK;
+}
+
+
+int cmd_loadXip(handler_t handler, size_t fsz, addr_t base, const ELF_PHDR *phdr, addr_t paddr)
+{
+	addr_t offs, addr;
+
+	/* Writable segments and segments with bss have to be placed in RAM */
+	if (((phdr->p_flags & (ELF_WORD)PHF_W) != 0) || (phdr->p_filesz != phdr->p_memsz) || (fsz == 0)) {
+		return 0;
+	}
+
+	if (phfs_aliasAddrResolve(handler, &offs) < 0) {
+		offs = 0;
+	}
+
+	if (phfs_map(handler, offs, fsz, mAttrRead | mAttrExec, paddr, phdr->p_memsz, mAttrRead | mAttrExec, &addr) != dev_isMappable) {
+		return 0;
+	}
+
+	/* Segment has to be linked at its location on the device */
+	return (addr + offs + base + phdr->p_offset) == paddr;
+}
@@ -0,0 +1,60 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Common routines of commands loading images
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _CMD_LOAD_H_
+#define _CMD_LOAD_H_
+
+#include <hal/hal.h>
+#include <phfs/phfs.h>
+#include <syspage.h>
+
+#include "elf.h"
+
+
+#if defined(__TARGET_RISCV64) || defined(__aarch64__)
+#define ELF_WORD Elf64_Word
+#define ELF_EHDR Elf64_Ehdr
+#define ELF_PHDR Elf64_Phdr
+#else
+#define ELF_WORD Elf32_Word
+#define ELF_EHDR Elf32_Ehdr
+#define ELF_PHDR Elf32_Phdr
+#endif
+
+
+/* Reads sz bytes from offs directly into the destination */
+extern int cmd_loadCopy(handler_t handler, addr_t offs, void *dst, size_t sz);
+
+
+/* Splits list of maps in place, returns number of maps */
+extern size_t cmd_mapsParse(char *maps, char sep);
+
+
+/* Resolves nb consecutive NULL separated map names to IDs */
+extern int cmd_mapsAdd2Prog(u8 *mapIDs, size_t nb, const char *mapNames);
+
+
+/* Places image (size bytes at offs in the file) in the map - in place if the device is mappable */
+extern int cmd_loadImage(handler_t handler, addr_t offs, size_t size, const char *map, int mode, u32 flags, const mapent_t **entry);
+
+
+/* Adds program located in entry, imaps and dmaps have to be split by cmd_mapsParse */
+extern int cmd_loadProg(const char *argv, u32 flags, const char *imaps, size_t imapSz, const char *dmaps, size_t dmapSz, const mapent_t *entry);
+
+
+/* Checks whether segment of ELF located at base in the file (fsz bytes) can be executed in place */
+extern int cmd_loadXip(handler_t handler, size_t fsz, addr_t base, const ELF_PHDR *phdr, addr_t paddr);
+
+
+#endif
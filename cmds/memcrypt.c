@@ -19,8 +19,11 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 
-/* TODO: platform-independent OTP */
+/* Keys stored in OTP are available only on platforms providing otp_read */
+#if defined(__CPU_STM32N6)
 #include <hal/armv8m/stm32/n6/otp.h>
+#define MEMCRYPT_HAS_OTP 1
+#endif
 
 #define CONST_STR_LEN(x)          (sizeof(x) - 1)
 #define MEMCRYPT_AES256           "aes256:"
@@ -362,6 +365,7 @@ static int cmd_memcrypt_parseArgs(int argc, char *argv[], cmd_memcrypt_params_t
 
 static int cmd_memcrypt_readOtpBuffer(int fuse, u8 *out, size_t keysize)
 {
+#ifdef MEMCRYPT_HAS_OTP
 	int ret;
 	u32 val = 0;
 	size_t i = 0;
@@ -384,6 +388,13 @@ static int cmd_memcrypt_readOtpBuffer(int fuse, u8 *out, size_t keysize)
 	}
 
 	return EOK;
+#else
+	(void)fuse;
+	(void)out;
+	(void)keysize;
+
+	return -ENOSYS;
+#endif
 }
 
 
@@ -409,7 +420,11 @@ static int cmd_memcrypt_readBuffer(cmd_memcrypt_buffer_t *buf, size_t expectedSi
 
 		case buffer_otp:
 			ret = cmd_memcrypt_readOtpBuffer(buf->offset, buf->data, buf->size);
-			if (ret < 0) {
+			if (ret == -ENOSYS) {
+				log_error("\nOTP keys are not supported on this platform");
+				return CMD_EXIT_FAILURE;
+			}
+			else if (ret < 0) {
 				log_error("\nFailed to read OTP fuse");
 				return CMD_EXIT_FAILURE;
 			}
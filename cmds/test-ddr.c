@@ -53,6 +53,15 @@ static void cmd_ddrInfo(void)
 }
 
 
+/* Byte lanes (data masks) are shared by the whole memory, a small region is enough */
+#define BYTE_TEST_SIZE (1024u * 1024u)
+
+/* Words in a cache line burst, all targets have at least 64-byte lines */
+#define BURST_WORDS 8
+
+static const u64 marchPatterns[] = { 0x0000000000000000ULL, 0x5555555555555555ULL, 0x3333333333333333ULL, 0x0f0f0f0f0f0f0f0fULL };
+
+
 static int cmd_ddrByteAccessibility(addr_t ddrAddr, size_t size)
 {
 	size_t i;
@@ -64,6 +73,8 @@ static int cmd_ddrByteAccessibility(addr_t ddrAddr, size_t size)
 	for (i = 0, val = 0; i < size; ++i, ++val)
 		ddr[i] = val;
 
+	hal_cpuFlushDataCache(ddrAddr, size);
+
 	for (i = 0, val = 0; i < size; ++i, ++val) {
 		if (ddr[i] != val)
 			++errs;
@@ -73,21 +84,125 @@ static int cmd_ddrByteAccessibility(addr_t ddrAddr, size_t size)
 }
 
 
-static int cmd_ddrWordAccessibility(addr_t ddrAddr, size_t size)
+static int cmd_ddrCountErrors(volatile u64 *line, u64 expected)
+{
+	int i, errs = 0;
+
+	for (i = 0; i < BURST_WORDS; ++i) {
+		if (line[i] != expected)
+			++errs;
+	}
+
+	return errs;
+}
+
+
+/* Read, compare and write whole cache lines, direction < 0 walks the memory downwards */
+static int cmd_ddrMarch(addr_t ddrAddr, size_t size, u64 expected, u64 value, int direction)
 {
-	volatile u32 *ddr = (u32 *)ddrAddr;
+	volatile u64 *ddr = (u64 *)ddrAddr;
+	volatile u64 *line;
+	size_t i, lines = size / (BURST_WORDS * sizeof(u64));
+	u64 diff;
+	int errs = 0;
+
+	for (i = 0; i < lines; ++i) {
+		line = ddr + ((direction < 0) ? (lines - 1 - i) : i) * BURST_WORDS;
+
+		diff = (line[0] ^ expected) | (line[1] ^ expected) | (line[2] ^ expected) | (line[3] ^ expected) |
+			(line[4] ^ expected) | (line[5] ^ expected) | (line[6] ^ expected) | (line[7] ^ expected);
+		if (diff != 0)
+			errs += cmd_ddrCountErrors(line, expected);
+
+		line[0] = value;
+		line[1] = value;
+		line[2] = value;
+		line[3] = value;
+		line[4] = value;
+		line[5] = value;
+		line[6] = value;
+		line[7] = value;
+	}
+
+	/* Write back the tail remaining in the cache, the next pass reads from memory */
+	hal_cpuFlushDataCache(ddrAddr, size);
+
+	return errs;
+}
+
+
+static void cmd_ddrFill(addr_t ddrAddr, size_t size, u64 value)
+{
+	volatile u64 *ddr = (u64 *)ddrAddr;
 	size_t i;
-	u32 val;
+
+	for (i = 0; i < size / sizeof(u64); i += BURST_WORDS) {
+		ddr[i] = value;
+		ddr[i + 1] = value;
+		ddr[i + 2] = value;
+		ddr[i + 3] = value;
+		ddr[i + 4] = value;
+		ddr[i + 5] = value;
+		ddr[i + 6] = value;
+		ddr[i + 7] = value;
+	}
+
+	hal_cpuFlushDataCache(ddrAddr, size);
+}
+
+
+/* Moving inversions: fill p, up (r p, w ~p), down (r ~p, w p), up (r p) */
+static int cmd_ddrMovingInversions(addr_t ddrAddr, size_t size)
+{
+	size_t i;
+	u64 p;
 	int errs = 0;
 
-	for (i = 0; i < (size >> 2); ++i) {
-		val = i << 2;
-		ddr[i] = val;
+	for (i = 0; i < sizeof(marchPatterns) / sizeof(marchPatterns[0]); ++i) {
+		p = marchPatterns[i];
+
+		cmd_ddrFill(ddrAddr, size, p);
+		errs += cmd_ddrMarch(ddrAddr, size, p, ~p, 1);
+		errs += cmd_ddrMarch(ddrAddr, size, ~p, p, -1);
+		errs += cmd_ddrMarch(ddrAddr, size, p, p, 1);
 	}
 
-	for (i = 0; i < (size >> 2); ++i) {
-		val = i << 2;
-		if (ddr[i] != val)
+	return errs;
+}
+
+
+/* Address with its complement folded into the upper half, distinct for every address (also above 4 GB) */
+static inline u64 cmd_ddrAddrPattern(u64 a)
+{
+	return a ^ (~a << 32);
+}
+
+
+/* Each word holds its own address and its complement, detects address line faults */
+static int cmd_ddrAddressInAddress(addr_t ddrAddr, size_t size)
+{
+	volatile u64 *ddr = (u64 *)ddrAddr;
+	size_t i, n = size / sizeof(u64);
+	u64 a;
+	int errs = 0;
+
+	for (i = 0; i < n; i += BURST_WORDS) {
+		a = (u64)(ddrAddr + i * sizeof(u64));
+		ddr[i] = cmd_ddrAddrPattern(a);
+		ddr[i + 1] = cmd_ddrAddrPattern(a + 8);
+		ddr[i + 2] = cmd_ddrAddrPattern(a + 16);
+		ddr[i + 3] = cmd_ddrAddrPattern(a + 24);
+		ddr[i + 4] = cmd_ddrAddrPattern(a + 32);
+		ddr[i + 5] = cmd_ddrAddrPattern(a + 40);
+		ddr[i + 6] = cmd_ddrAddrPattern(a + 48);
+		ddr[i + 7] = cmd_ddrAddrPattern(a + 56);
+	}
+
+	hal_cpuFlushDataCache(ddrAddr, size);
+
+	for (i = 0; i < n; ++i) {
+		a = (u64)(ddrAddr + i * sizeof(u64));
+		if (ddr[i] != cmd_ddrAddrPattern(a))
 			++errs;
 	}
 
@@ -98,9 +213,16 @@ static int cmd_ddrWordAccessibility(addr_t ddrAddr, size_t size)
 int cmd_ddrAccessibility(addr_t ddrAddr, size_t size)
 {
 	int errs;
+	time_t start = hal_timerGet();
+
+	errs = cmd_ddrByteAccessibility(ddrAddr, min(size, BYTE_TEST_SIZE));
+
+	/* Remaining tests operate on whole cache lines */
+	size &= ~(size_t)(BURST_WORDS * sizeof(u64) - 1);
+	errs += cmd_ddrAddressInAddress(ddrAddr, size);
+	errs += cmd_ddrMovingInversions(ddrAddr, size);
 
-	errs = cmd_ddrByteAccessibility(ddrAddr, size);
-	errs += cmd_ddrWordAccessibility(ddrAddr, size);
+	lib_printf("\n- accessibility: %u MB in %u ms", (u32)(size >> 20), (u32)(hal_timerGet() - start));
 
 	return errs;
 }
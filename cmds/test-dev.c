@@ -94,6 +94,13 @@ static int cmd_testDevRead(int major, int minor, addr_t addr, size_t length, u8
 static int cmd_testDevErase(int major, int minor, addr_t addr, size_t length)
 {
 	ssize_t res;
+	size_t blockSz = 0;
+
+	/* Erase starting inside of a block would destroy data before addr */
+	if ((devs_control(major, minor, DEV_CONTROL_GETPROP_BLOCKSZ, &blockSz) == EOK) && (blockSz != 0u) && ((addr % blockSz) != 0u)) {
+		log_error("\nStart address 0x%x is not aligned to erase block size 0x%zx\n", (u32)addr, blockSz);
+		return -EINVAL;
+	}
 
 	res = devs_erase(major, minor, addr, length, 0);
 	if (res < 0) {
@@ -286,6 +293,401 @@ static int cmd_testDev(int argc, char *argv[])
 }
 
 
+/* Device benchmark */
+
+#define BENCH_BUF_SIZE   4096u /* Default buffer, larger requests need a buffer given with -b */
+#define BENCH_MIN_REQ    512u
+#define BENCH_MAX_REQ    (1024u * 1024u)
+#define BENCH_OPS        64u  /* Default number of requests per test */
+#define BENCH_HIST_SIZE  64u  /* Latency histogram, 1 ms buckets, the last one is open-ended */
+#define BENCH_SWEEP_SIZE 2048u
+
+#define BENCH_WRITE (1u << 0)
+#define BENCH_ERASE (1u << 1)
+#define BENCH_SWEEP (1u << 2)
+#define BENCH_CSV   (1u << 3)
+
+#define BENCH_SEQ  0
+#define BENCH_RAND 1
+
+enum { bench_read = 0, bench_write, bench_erase };
+
+
+typedef struct {
+	u32 ops;
+	u64 bytes;
+	time_t total;
+	time_t min;
+	u32 hist[BENCH_HIST_SIZE];
+} bench_stats_t;
+
+
+static struct {
+	int major;
+	int minor;
+	addr_t start;
+	size_t length;
+	u8 *buf;
+	size_t bufSz;
+	u32 ops;
+	u32 flags;
+	u32 seed;
+	bench_stats_t stats;
+} bench_common;
+
+
+/* Misalignment of both device offset and memory buffer, must fit in BENCH_BUF_SIZE - BENCH_SWEEP_SIZE */
+static const size_t bench_misalign[] = { 0, 1, 2, 3, 4, 8, 16, 64, 256 };
+
+static const char *const bench_names[2][3] = {
+	{ "seq-read", "seq-write", "seq-erase" },
+	{ "rand-read", "rand-write", "rand-erase" },
+};
+
+
+static void cmd_benchDevInfo(void)
+{
+	lib_consolePuts("benchmarks dev read/write/erase, usage: bench-dev [-w] [-e] [-a] [-c] -d <dev> [-s <addr>] -l length");
+}
+
+
+static void cmd_benchDevUsage(void)
+{
+	/* clang-format off */
+	lib_consolePuts("Usage: bench-dev [-w] [-e] [-a] [-c] -d <major>.<minor> [-s <addr>] -l <length> [-n <requests>] [-b <addr>:<size>]\n"
+	"  -w       Benchmark writes (destroys data in the region)\n"
+	"  -e       Benchmark erases (destroys data in the region)\n"
+	"  -a       Misalignment sweep\n"
+	"  -c       CSV output\n"
+	"  -s       Start address, default: 0\n"
+	"  -l       Length of the tested region\n"
+	"  -n       Requests per test, default: 64\n"
+	"  -b       Memory buffer for requests larger than 4096 bytes\n"
+	"Latency resolution is 1 ms, request sizes are 512 B to 1 MB\n"
+	);
+	/* clang-format on */
+}
+
+
+static int cmd_benchRun(int type, int pattern, size_t sz, size_t misalign)
+{
+	ssize_t res;
+	size_t slots;
+	time_t t;
+	addr_t offs;
+	u32 i;
+	u8 *buf = bench_common.buf + misalign;
+	bench_stats_t *st = &bench_common.stats;
+
+	hal_memset(st, 0, sizeof(*st));
+
+	slots = (bench_common.length - misalign) / sz;
+	for (i = 0; i < bench_common.ops; i++) {
+		if (pattern == BENCH_SEQ) {
+			offs = bench_common.start + misalign + (i % slots) * sz;
+		}
+		else {
+			offs = bench_common.start + misalign + (lib_rand(&bench_common.seed) % slots) * sz;
+		}
+
+		t = hal_timerGet();
+		switch (type) {
+			case bench_read:
+				res = devs_read(bench_common.major, bench_common.minor, offs, buf, sz, TEST_DEV_TIMEOUT_MS);
+				break;
+
+			case bench_write:
+				res = devs_write(bench_common.major, bench_common.minor, offs, buf, sz);
+				break;
+
+			default:
+				res = devs_erase(bench_common.major, bench_common.minor, offs, sz, 0);
+				break;
+		}
+		t = hal_timerGet() - t;
+
+		if (res < 0) {
+			log_error("\n%s failed at 0x%x: %zd\n", bench_names[pattern][type], (u32)offs, res);
+			return res;
+		}
+
+		if ((st->ops == 0) || (t < st->min)) {
+			st->min = t;
+		}
+		st->hist[(t < BENCH_HIST_SIZE) ? t : (BENCH_HIST_SIZE - 1)]++;
+		st->total += t;
+		st->bytes += sz;
+		st->ops++;
+	}
+
+	/* Buffered data has to reach the device to be counted */
+	if (type != bench_read) {
+		t = hal_timerGet();
+		res = devs_sync(bench_common.major, bench_common.minor);
+		if ((res < 0) && (res != -ENOSYS)) {
+			log_error("\nSync failed %zd\n", res);
+			return res;
+		}
+		st->total += hal_timerGet() - t;
+	}
+
+	return EOK;
+}
+
+
+static void cmd_benchReport(int type, int pattern, size_t sz, size_t misalign)
+{
+	const bench_stats_t *st = &bench_common.stats;
+	time_t total = (st->total > 0) ? st->total : 1;
+	u64 bps = (st->bytes * 1000u) / (u64)total;
+	u32 iops = (u32)(((u64)st->ops * 1000u) / (u64)total);
+	u32 avg = (u32)(((u64)st->total * 1000u) / st->ops);
+	u32 p99, cnt = 0, need = (st->ops * 99u + 99u) / 100u;
+
+	for (p99 = 0; p99 < (BENCH_HIST_SIZE - 1); p99++) {
+		cnt += st->hist[p99];
+		if (cnt >= need) {
+			break;
+		}
+	}
+
+	if ((bench_common.flags & BENCH_CSV) != 0u) {
+		lib_printf("\n%s,%zu,%zu,%u,%u,%u.%02u,%u,%u,%u,%u", bench_names[pattern][type], sz, misalign, st->ops, (u32)st->total,
+			(u32)(bps / 1000000u), (u32)((bps / 10000u) % 100u), iops, (u32)st->min * 1000u, avg, p99 * 1000u);
+	}
+	else {
+		lib_printf("\n%-10s %7zu %3zu %5u.%02u MB/s %7u IOPS  latency min %u ms, avg %u us, p99 %s%u ms", bench_names[pattern][type], sz, misalign,
+			(u32)(bps / 1000000u), (u32)((bps / 10000u) % 100u), iops, (u32)st->min, avg, (p99 == (BENCH_HIST_SIZE - 1)) ? ">=" : "", p99);
+	}
+}
+
+
+static int cmd_benchTest(int type, int pattern, size_t sz, size_t misalign)
+{
+	int res = cmd_benchRun(type, pattern, sz, misalign);
+
+	if (res == EOK) {
+		cmd_benchReport(type, pattern, sz, misalign);
+	}
+
+	return res;
+}
+
+
+static int cmd_doBenchDev(void)
+{
+	int res, pattern;
+	size_t sz, blockSz = 0, i;
+
+	res = devs_check(bench_common.major, bench_common.minor);
+	if (res < 0) {
+		log_error("\nInvalid device %d\n", res);
+		return -EINVAL;
+	}
+
+	if ((bench_common.flags & BENCH_ERASE) != 0u) {
+		res = devs_control(bench_common.major, bench_common.minor, DEV_CONTROL_GETPROP_BLOCKSZ, &blockSz);
+		if ((res < 0) || (blockSz == 0u)) {
+			log_error("\nCan't get device block size %d\n", res);
+			return -EINVAL;
+		}
+
+		/* Erase requests are multiples of the block size placed from the start */
+		if ((bench_common.start % blockSz) != 0u) {
+			log_error("\nStart address 0x%x is not aligned to erase block size 0x%zx\n", (u32)bench_common.start, blockSz);
+			return -EINVAL;
+		}
+	}
+
+	/* Write pattern, the same data is written in all tests */
+	for (i = 0; i < bench_common.bufSz; i++) {
+		bench_common.buf[i] = (i & 0xffu);
+	}
+
+	if ((bench_common.flags & BENCH_CSV) != 0u) {
+		lib_printf("\ntest,size,misalign,ops,time_ms,MBps,iops,lat_min_us,lat_avg_us,lat_p99_us");
+	}
+	else {
+		lib_printf("\nbench-dev: device %d.%d, region 0x%x-0x%x, %u requests per test", bench_common.major, bench_common.minor,
+			(u32)bench_common.start, (u32)(bench_common.start + bench_common.length), bench_common.ops);
+		lib_printf("\n%-10s %7s %3s %15s %12s", "test", "size", "mis", "throughput", "rate");
+	}
+
+	for (sz = BENCH_MIN_REQ; (sz <= BENCH_MAX_REQ) && (sz <= bench_common.bufSz) && (sz <= bench_common.length); sz <<= 1) {
+		for (pattern = BENCH_SEQ; pattern <= BENCH_RAND; pattern++) {
+			res = cmd_benchTest(bench_read, pattern, sz, 0);
+			if (res < 0) {
+				return res;
+			}
+
+			if ((bench_common.flags & BENCH_ERASE) != 0u) {
+				/* Only whole blocks can be erased */
+				if ((sz % blockSz) == 0u) {
+					res = cmd_benchTest(bench_erase, pattern, sz, 0);
+					if (res < 0) {
+						return res;
+					}
+				}
+			}
+
+			if ((bench_common.flags & BENCH_WRITE) != 0u) {
+				res = cmd_benchTest(bench_write, pattern, sz, 0);
+				if (res < 0) {
+					return res;
+				}
+			}
+		}
+	}
+
+	if ((bench_common.flags & BENCH_SWEEP) != 0u) {
+		if ((bench_common.bufSz < (BENCH_SWEEP_SIZE + bench_misalign[(sizeof(bench_misalign) / sizeof(bench_misalign[0])) - 1])) ||
+				(bench_common.length < (2u * BENCH_SWEEP_SIZE))) {
+			log_error("\nRegion or buffer too small for misalignment sweep\n");
+			return -EINVAL;
+		}
+
+		for (i = 0; i < sizeof(bench_misalign) / sizeof(bench_misalign[0]); i++) {
+			res = cmd_benchTest(bench_read, BENCH_SEQ, BENCH_SWEEP_SIZE, bench_misalign[i]);
+			if ((res == EOK) && ((bench_common.flags & BENCH_WRITE) != 0u)) {
+				res = cmd_benchTest(bench_write, BENCH_SEQ, BENCH_SWEEP_SIZE, bench_misalign[i]);
+			}
+			if (res < 0) {
+				return res;
+			}
+		}
+	}
+
+	lib_printf("\n");
+
+	return EOK;
+}
+
+
+static int cmd_benchDev(int argc, char *argv[])
+{
+	static u8 buf[BENCH_BUF_SIZE];
+	int opt, err;
+	char *endptr;
+
+	hal_memset(&bench_common, 0, sizeof(bench_common));
+	bench_common.major = -1;
+	bench_common.length = (size_t)-1;
+	bench_common.buf = buf;
+	bench_common.bufSz = sizeof(buf);
+	bench_common.ops = BENCH_OPS;
+	bench_common.seed = LIB_RAND_SEED;
+
+	for (;;) {
+		opt = lib_getopt(argc, argv, "weacd:s:l:n:b:");
+		if (opt < 0) {
+			break;
+		}
+		switch (opt) {
+			case 'w':
+				bench_common.flags |= BENCH_WRITE;
+				break;
+
+			case 'e':
+				bench_common.flags |= BENCH_ERASE;
+				break;
+
+			case 'a':
+				bench_common.flags |= BENCH_SWEEP;
+				break;
+
+			case 'c':
+				bench_common.flags |= BENCH_CSV;
+				break;
+
+			case 'd':
+				bench_common.major = lib_strtoul(optarg, &endptr, 0);
+				if (*endptr != '.') {
+					log_error("\nInvalid device.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				bench_common.minor = lib_strtoul(endptr + 1, &endptr, 0);
+				if (*endptr != '\0') {
+					log_error("\nInvalid device.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			case 's':
+				bench_common.start = lib_strtoul(optarg, &endptr, 0);
+				if (*endptr != '\0') {
+					log_error("\nInvalid start.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			case 'l':
+				bench_common.length = lib_strtoul(optarg, &endptr, 0);
+				if ((*endptr != '\0') || (bench_common.length < BENCH_MIN_REQ)) {
+					log_error("\nInvalid length.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			case 'n':
+				bench_common.ops = lib_strtoul(optarg, &endptr, 0);
+				if ((*endptr != '\0') || (bench_common.ops == 0u)) {
+					log_error("\nInvalid number of requests.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			case 'b':
+				bench_common.buf = (u8 *)lib_strtoul(optarg, &endptr, 0);
+				if (*endptr != ':') {
+					log_error("\nInvalid buffer.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				bench_common.bufSz = lib_strtoul(endptr + 1, &endptr, 0);
+				if ((*endptr != '\0') || (bench_common.bufSz < BENCH_MIN_REQ)) {
+					log_error("\nInvalid buffer size.\n");
+					cmd_benchDevUsage();
+					return CMD_EXIT_FAILURE;
+				}
+				break;
+
+			default:
+				cmd_benchDevUsage();
+				return CMD_EXIT_FAILURE;
+		}
+	}
+	if (bench_common.major == -1) {
+		log_error("\nDevice missing.\n");
+		return CMD_EXIT_FAILURE;
+	}
+	if (bench_common.length == (size_t)-1) {
+		log_error("\nLength missing.\n");
+		return CMD_EXIT_FAILURE;
+	}
+	if ((bench_common.start + bench_common.length) < bench_common.start) {
+		log_error("\nStart + length causes overflow.\n");
+		return CMD_EXIT_FAILURE;
+	}
+
+	err = cmd_doBenchDev();
+	if (err < 0) {
+		log_error("\nError: %d\n", err);
+		return CMD_EXIT_FAILURE;
+	}
+	return CMD_EXIT_SUCCESS;
+}
+
+
 static const cmd_t testdev_cmd __attribute__((section("commands"), used)) = {
 	.name = "test-dev", .run = cmd_testDev, .info = cmd_testDevInfo
 };
+
+
+static const cmd_t benchdev_cmd __attribute__((section("commands"), used)) = {
+	.name = "bench-dev", .run = cmd_benchDev, .info = cmd_benchDevInfo
+};
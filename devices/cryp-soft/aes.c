@@ -0,0 +1,228 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * AES block cipher - table based implementation
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <lib/errno.h>
+
+#include "aes.h"
+
+
+/* Columns are stored as little endian words, row 0 in the least significant byte */
+#define ROTL8(x, n) ((u8)(((x) << (n)) | ((x) >> (8 - (n)))))
+#define ROTL(x, n)  (((x) << (n)) | ((x) >> (32 - (n))))
+#define BYTE(x, n)  (((x) >> (8 * (n))) & 0xffu)
+
+
+/* Tables are generated at runtime to keep the read-only image small */
+static struct {
+	u8 sbox[256];
+	u8 isbox[256];
+	u32 te[256]; /* MixColumns(sbox[x]) */
+	u32 td[256]; /* InvMixColumns(isbox[x]) */
+} aes_common;
+
+
+static u8 aes_mul(u8 a, u8 b)
+{
+	u8 res = 0;
+
+	while (b != 0) {
+		if ((b & 1u) != 0) {
+			res ^= a;
+		}
+		a = (u8)((a << 1) ^ (((a & 0x80u) != 0) ? 0x1bu : 0u));
+		b >>= 1;
+	}
+
+	return res;
+}
+
+
+void aes_init(void)
+{
+	u8 p = 1, q = 1, x, s;
+	unsigned int i;
+
+	/* p walks over all non-zero field elements, q is its multiplicative inverse */
+	do {
+		p = (u8)(p ^ (p << 1) ^ (((p & 0x80u) != 0) ? 0x1bu : 0u));
+
+		q ^= (u8)(q << 1);
+		q ^= (u8)(q << 2);
+		q ^= (u8)(q << 4);
+		if ((q & 0x80u) != 0) {
+			q ^= 0x09u;
+		}
+
+		x = q ^ ROTL8(q, 1) ^ ROTL8(q, 2) ^ ROTL8(q, 3) ^ ROTL8(q, 4);
+		aes_common.sbox[p] = x ^ 0x63u;
+	} while (p != 1);
+	aes_common.sbox[0] = 0x63;
+
+	for (i = 0; i < 256; i++) {
+		aes_common.isbox[aes_common.sbox[i]] = (u8)i;
+	}
+
+	for (i = 0; i < 256; i++) {
+		s = aes_common.sbox[i];
+		aes_common.te[i] = (u32)aes_mul(s, 2) | ((u32)s << 8) | ((u32)s << 16) | ((u32)aes_mul(s, 3) << 24);
+
+		s = aes_common.isbox[i];
+		aes_common.td[i] = (u32)aes_mul(s, 14) | ((u32)aes_mul(s, 9) << 8) | ((u32)aes_mul(s, 13) << 16) | ((u32)aes_mul(s, 11) << 24);
+	}
+}
+
+
+static u32 aes_subWord(u32 w)
+{
+	return (u32)aes_common.sbox[BYTE(w, 0)] | ((u32)aes_common.sbox[BYTE(w, 1)] << 8) |
+		((u32)aes_common.sbox[BYTE(w, 2)] << 16) | ((u32)aes_common.sbox[BYTE(w, 3)] << 24);
+}
+
+
+static u32 aes_load(const u8 *p)
+{
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+
+static void aes_store(u8 *p, u32 w)
+{
+	p[0] = (u8)w;
+	p[1] = (u8)(w >> 8);
+	p[2] = (u8)(w >> 16);
+	p[3] = (u8)(w >> 24);
+}
+
+
+int aes_setKey(aes_ctx_t *ctx, const u8 *key, size_t keyLen)
+{
+	unsigned int i, j, nk, total;
+	u32 t;
+	u8 rcon = 1;
+
+	if ((keyLen != 16) && (keyLen != 32)) {
+		return -EINVAL;
+	}
+
+	nk = keyLen / 4;
+	ctx->rounds = nk + 6;
+	total = 4 * (ctx->rounds + 1);
+
+	for (i = 0; i < nk; i++) {
+		ctx->ek[i] = aes_load(key + 4 * i);
+	}
+
+	for (; i < total; i++) {
+		t = ctx->ek[i - 1];
+		if ((i % nk) == 0) {
+			/* RotWord moves byte 1 to row 0 */
+			t = aes_subWord(ROTL(t, 24)) ^ rcon;
+			rcon = aes_mul(rcon, 2);
+		}
+		else if ((nk > 6) && ((i % nk) == 4)) {
+			t = aes_subWord(t);
+		}
+		ctx->ek[i] = ctx->ek[i - nk] ^ t;
+	}
+
+	/* Decryption keys in reverse round order, inner ones passed through InvMixColumns */
+	for (i = 0; i <= ctx->rounds; i++) {
+		for (j = 0; j < 4; j++) {
+			t = ctx->ek[4 * (ctx->rounds - i) + j];
+			if ((i != 0) && (i != ctx->rounds)) {
+				t = aes_common.td[aes_common.sbox[BYTE(t, 0)]] ^ ROTL(aes_common.td[aes_common.sbox[BYTE(t, 1)]], 8) ^
+					ROTL(aes_common.td[aes_common.sbox[BYTE(t, 2)]], 16) ^ ROTL(aes_common.td[aes_common.sbox[BYTE(t, 3)]], 24);
+			}
+			ctx->dk[4 * i + j] = t;
+		}
+	}
+
+	return EOK;
+}
+
+
+void aes_encrypt(const aes_ctx_t *ctx, const u8 *in, u8 *out)
+{
+	const u32 *rk = ctx->ek;
+	const u32 *te = aes_common.te;
+	const u8 *sbox = aes_common.sbox;
+	u32 s0, s1, s2, s3, t0, t1, t2, t3;
+	unsigned int r;
+
+	s0 = aes_load(in) ^ rk[0];
+	s1 = aes_load(in + 4) ^ rk[1];
+	s2 = aes_load(in + 8) ^ rk[2];
+	s3 = aes_load(in + 12) ^ rk[3];
+
+	for (r = 1; r < ctx->rounds; r++) {
+		rk += 4;
+		t0 = te[BYTE(s0, 0)] ^ ROTL(te[BYTE(s1, 1)], 8) ^ ROTL(te[BYTE(s2, 2)], 16) ^ ROTL(te[BYTE(s3, 3)], 24) ^ rk[0];
+		t1 = te[BYTE(s1, 0)] ^ ROTL(te[BYTE(s2, 1)], 8) ^ ROTL(te[BYTE(s3, 2)], 16) ^ ROTL(te[BYTE(s0, 3)], 24) ^ rk[1];
+		t2 = te[BYTE(s2, 0)] ^ ROTL(te[BYTE(s3, 1)], 8) ^ ROTL(te[BYTE(s0, 2)], 16) ^ ROTL(te[BYTE(s1, 3)], 24) ^ rk[2];
+		t3 = te[BYTE(s3, 0)] ^ ROTL(te[BYTE(s0, 1)], 8) ^ ROTL(te[BYTE(s1, 2)], 16) ^ ROTL(te[BYTE(s2, 3)], 24) ^ rk[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	rk += 4;
+	t0 = (u32)sbox[BYTE(s0, 0)] | ((u32)sbox[BYTE(s1, 1)] << 8) | ((u32)sbox[BYTE(s2, 2)] << 16) | ((u32)sbox[BYTE(s3, 3)] << 24);
+	t1 = (u32)sbox[BYTE(s1, 0)] | ((u32)sbox[BYTE(s2, 1)] << 8) | ((u32)sbox[BYTE(s3, 2)] << 16) | ((u32)sbox[BYTE(s0, 3)] << 24);
+	t2 = (u32)sbox[BYTE(s2, 0)] | ((u32)sbox[BYTE(s3, 1)] << 8) | ((u32)sbox[BYTE(s0, 2)] << 16) | ((u32)sbox[BYTE(s1, 3)] << 24);
+	t3 = (u32)sbox[BYTE(s3, 0)] | ((u32)sbox[BYTE(s0, 1)] << 8) | ((u32)sbox[BYTE(s1, 2)] << 16) | ((u32)sbox[BYTE(s2, 3)] << 24);
+
+	aes_store(out, t0 ^ rk[0]);
+	aes_store(out + 4, t1 ^ rk[1]);
+	aes_store(out + 8, t2 ^ rk[2]);
+	aes_store(out + 12, t3 ^ rk[3]);
+}
+
+
+void aes_decrypt(const aes_ctx_t *ctx, const u8 *in, u8 *out)
+{
+	const u32 *rk = ctx->dk;
+	const u32 *td = aes_common.td;
+	const u8 *isbox = aes_common.isbox;
+	u32 s0, s1, s2, s3, t0, t1, t2, t3;
+	unsigned int r;
+
+	s0 = aes_load(in) ^ rk[0];
+	s1 = aes_load(in + 4) ^ rk[1];
+	s2 = aes_load(in + 8) ^ rk[2];
+	s3 = aes_load(in + 12) ^ rk[3];
+
+	for (r = 1; r < ctx->rounds; r++) {
+		rk += 4;
+		t0 = td[BYTE(s0, 0)] ^ ROTL(td[BYTE(s3, 1)], 8) ^ ROTL(td[BYTE(s2, 2)], 16) ^ ROTL(td[BYTE(s1, 3)], 24) ^ rk[0];
+		t1 = td[BYTE(s1, 0)] ^ ROTL(td[BYTE(s0, 1)], 8) ^ ROTL(td[BYTE(s3, 2)], 16) ^ ROTL(td[BYTE(s2, 3)], 24) ^ rk[1];
+		t2 = td[BYTE(s2, 0)] ^ ROTL(td[BYTE(s1, 1)], 8) ^ ROTL(td[BYTE(s0, 2)], 16) ^ ROTL(td[BYTE(s3, 3)], 24) ^ rk[2];
+		t3 = td[BYTE(s3, 0)] ^ ROTL(td[BYTE(s2, 1)], 8) ^ ROTL(td[BYTE(s1, 2)], 16) ^ ROTL(td[BYTE(s0, 3)], 24) ^ rk[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	rk += 4;
+	t0 = (u32)isbox[BYTE(s0, 0)] | ((u32)isbox[BYTE(s3, 1)] << 8) | ((u32)isbox[BYTE(s2, 2)] << 16) | ((u32)isbox[BYTE(s1, 3)] << 24);
+	t1 = (u32)isbox[BYTE(s1, 0)] | ((u32)isbox[BYTE(s0, 1)] << 8) | ((u32)isbox[BYTE(s3, 2)] << 16) | ((u32)isbox[BYTE(s2, 3)] << 24);
+	t2 = (u32)isbox[BYTE(s2, 0)] | ((u32)isbox[BYTE(s1, 1)] << 8) | ((u32)isbox[BYTE(s0, 2)] << 16) | ((u32)isbox[BYTE(s3, 3)] << 24);
+	t3 = (u32)isbox[BYTE(s3, 0)] | ((u32)isbox[BYTE(s2, 1)] << 8) | ((u32)isbox[BYTE(s1, 2)] << 16) | ((u32)isbox[BYTE(s0, 3)] << 24);
+
+	aes_store(out, t0 ^ rk[0]);
+	aes_store(out + 4, t1 ^ rk[1]);
+	aes_store(out + 8, t2 ^ rk[2]);
+	aes_store(out + 12, t3 ^ rk[3]);
+}
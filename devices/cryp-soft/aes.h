@@ -0,0 +1,44 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * AES block cipher
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _AES_H_
+#define _AES_H_
+
+#include <hal/hal.h>
+
+#define AES_BLOCK_SIZE 16
+
+
+typedef struct {
+	u32 ek[60]; /* Encryption round keys */
+	u32 dk[60]; /* Decryption round keys (equivalent inverse cipher) */
+	unsigned int rounds;
+} aes_ctx_t;
+
+
+/* Generates lookup tables, has to be called before other functions */
+extern void aes_init(void);
+
+
+/* Expands 16 or 32 byte key */
+extern int aes_setKey(aes_ctx_t *ctx, const u8 *key, size_t keyLen);
+
+
+extern void aes_encrypt(const aes_ctx_t *ctx, const u8 *in, u8 *out);
+
+
+extern void aes_decrypt(const aes_ctx_t *ctx, const u8 *in, u8 *out);
+
+
+#endif
@@ -0,0 +1,500 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Software encrypted storage - wraps storage device DEV_STORAGE.n as DEV_CRYP_STORAGE.n
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <hal/hal.h>
+#include <lib/lib.h>
+#include <devices/devs.h>
+
+#include "aes.h"
+
+
+#ifndef CRYPSOFT_NO
+#define CRYPSOFT_NO 1
+#endif
+
+#define CRYPSOFT_REGIONS 4
+
+/* Encryption modes (dev_memcrypt_args_t.mode) */
+#define CRYPSOFT_MODE_CTR 1 /* iv: initial counter block, 16 bytes */
+#define CRYPSOFT_MODE_XTS 2 /* iv: tweak key, same size as the key */
+
+/* XTS data unit, regions are aligned to it and units are numbered from the start of the region */
+#define CRYPSOFT_UNIT_SIZE 512u
+
+/* Reads are decrypted in chunks, while data is still in cache */
+#define CRYPSOFT_CHUNK_SIZE 4096u
+
+
+typedef struct {
+	addr_t start;
+	addr_t end;
+	u32 mode;
+	int enabled;
+	u8 iv[AES_BLOCK_SIZE];
+	aes_ctx_t key;
+	aes_ctx_t tweak;
+} crypsoft_region_t;
+
+
+static struct {
+	crypsoft_region_t region[CRYPSOFT_NO][CRYPSOFT_REGIONS];
+	u8 buf[CRYPSOFT_UNIT_SIZE];
+} crypsoft_common;
+
+
+static void crypsoft_xor(u8 *dst, const u8 *src, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		dst[i] ^= src[i];
+	}
+}
+
+
+/* Multiplies XTS tweak by the primitive element of GF(2^128) */
+static void crypsoft_xtsNext(u8 *t)
+{
+	unsigned int i;
+	u8 carry = 0, c;
+
+	for (i = 0; i < AES_BLOCK_SIZE; i++) {
+		c = t[i] >> 7;
+		t[i] = (u8)((t[i] << 1) | carry);
+		carry = c;
+	}
+
+	if (carry != 0) {
+		t[0] ^= 0x87u;
+	}
+}
+
+
+static void crypsoft_xtsTweak(const crypsoft_region_t *r, u64 unit, u8 *t)
+{
+	unsigned int i;
+
+	for (i = 0; i < AES_BLOCK_SIZE; i++) {
+		t[i] = (i < sizeof(unit)) ? (u8)(unit >> (8 * i)) : 0;
+	}
+
+	aes_encrypt(&r->tweak, t, t);
+}
+
+
+static void crypsoft_xtsBlock(const crypsoft_region_t *r, const u8 *t, u8 *block, int decrypt)
+{
+	crypsoft_xor(block, t, AES_BLOCK_SIZE);
+	if (decrypt != 0) {
+		aes_decrypt(&r->key, block, block);
+	}
+	else {
+		aes_encrypt(&r->key, block, block);
+	}
+	crypsoft_xor(block, t, AES_BLOCK_SIZE);
+}
+
+
+/* CTR keystream doesn't depend on direction, any offset and length is allowed */
+static void crypsoft_ctr(const crypsoft_region_t *r, addr_t pos, u8 *data, size_t len)
+{
+	u8 ctr[AES_BLOCK_SIZE], ks[AES_BLOCK_SIZE];
+	u64 blk = (pos - r->start) / AES_BLOCK_SIZE, carry;
+	size_t offs = (pos - r->start) % AES_BLOCK_SIZE, n;
+	int i;
+
+	/* Counter block is the big endian sum of iv and block index */
+	hal_memcpy(ctr, r->iv, sizeof(ctr));
+	carry = blk;
+	for (i = AES_BLOCK_SIZE - 1; (i >= 0) && (carry != 0); i--) {
+		carry += ctr[i];
+		ctr[i] = (u8)carry;
+		carry >>= 8;
+	}
+
+	while (len > 0) {
+		aes_encrypt(&r->key, ctr, ks);
+
+		n = min(len, AES_BLOCK_SIZE - offs);
+		crypsoft_xor(data, ks + offs, n);
+		data += n;
+		len -= n;
+		offs = 0;
+
+		for (i = AES_BLOCK_SIZE - 1; i >= 0; i--) {
+			if (++ctr[i] != 0) {
+				break;
+			}
+		}
+	}
+}
+
+
+/* Transforms data of [pos, pos + len) in place. Partial cipher blocks at the edges are
+ * completed from the underlying storage, only the requested bytes are returned */
+static int crypsoft_xts(unsigned int minor, const crypsoft_region_t *r, addr_t pos, u8 *data, size_t len, int decrypt)
+{
+	u8 t[AES_BLOCK_SIZE], block[AES_BLOCK_SIZE];
+	addr_t rel = pos - r->start, blk = rel & ~(addr_t)(AES_BLOCK_SIZE - 1), end = rel + len;
+	size_t offs, n, i;
+	ssize_t res;
+
+	crypsoft_xtsTweak(r, blk / CRYPSOFT_UNIT_SIZE, t);
+	for (i = 0; i < (blk % CRYPSOFT_UNIT_SIZE) / AES_BLOCK_SIZE; i++) {
+		crypsoft_xtsNext(t);
+	}
+
+	while (blk < end) {
+		if ((blk >= rel) && ((blk + AES_BLOCK_SIZE) <= end)) {
+			crypsoft_xtsBlock(r, t, data + (blk - rel), decrypt);
+		}
+		else {
+			res = devs_read(DEV_STORAGE, minor, r->start + blk, block, AES_BLOCK_SIZE, 0);
+			if (res < 0) {
+				return res;
+			}
+
+			offs = (blk < rel) ? (rel - blk) : 0;
+			n = min((size_t)(end - blk), (size_t)AES_BLOCK_SIZE) - offs;
+
+			/* Stored block is the ciphertext, update the requested part of the plaintext */
+			crypsoft_xtsBlock(r, t, block, 1);
+			if (decrypt == 0) {
+				hal_memcpy(block + offs, data + (blk + offs - rel), n);
+				crypsoft_xtsBlock(r, t, block, 0);
+			}
+			hal_memcpy(data + (blk + offs - rel), block + offs, n);
+		}
+
+		blk += AES_BLOCK_SIZE;
+		if ((blk % CRYPSOFT_UNIT_SIZE) == 0) {
+			crypsoft_xtsTweak(r, blk / CRYPSOFT_UNIT_SIZE, t);
+		}
+		else {
+			crypsoft_xtsNext(t);
+		}
+	}
+
+	return EOK;
+}
+
+
+static int crypsoft_transform(unsigned int minor, addr_t offs, u8 *data, size_t len, int decrypt)
+{
+	const crypsoft_region_t *r;
+	addr_t s, e;
+	unsigned int i;
+	int res;
+
+	for (i = 0; i < CRYPSOFT_REGIONS; i++) {
+		r = &crypsoft_common.region[minor][i];
+		if (r->enabled == 0) {
+			continue;
+		}
+
+		s = max(offs, r->start);
+		e = min(offs + len, r->end);
+		if (s >= e) {
+			continue;
+		}
+
+		if (r->mode == CRYPSOFT_MODE_CTR) {
+			crypsoft_ctr(r, s, data + (s - offs), e - s);
+		}
+		else {
+			res = crypsoft_xts(minor, r, s, data + (s - offs), e - s, decrypt);
+			if (res < 0) {
+				return res;
+			}
+		}
+	}
+
+	return EOK;
+}
+
+
+static int crypsoft_isEncrypted(unsigned int minor, addr_t offs, size_t len)
+{
+	const crypsoft_region_t *r;
+	unsigned int i;
+
+	for (i = 0; i < CRYPSOFT_REGIONS; i++) {
+		r = &crypsoft_common.region[minor][i];
+		if ((r->enabled != 0) && (r->start < (offs + len)) && (offs < r->end)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+static int crypsoft_memcrypt(unsigned int minor, const dev_memcrypt_args_t *args)
+{
+	crypsoft_region_t *r = NULL;
+	size_t keyLen;
+	unsigned int i;
+	int res;
+
+	switch (args->algo) {
+		case DEV_MEMCRYPT_ALGO_AES128:
+			keyLen = 16;
+			break;
+
+		case DEV_MEMCRYPT_ALGO_AES256:
+			keyLen = 32;
+			break;
+
+		default:
+			return -ENOSYS;
+	}
+
+	if ((args->start >= args->end) || (args->key == NULL)) {
+		return -EINVAL;
+	}
+
+	switch (args->mode) {
+		case CRYPSOFT_MODE_CTR:
+			if ((args->iv != NULL) && (args->ivSize != AES_BLOCK_SIZE)) {
+				return -EINVAL;
+			}
+			break;
+
+		case CRYPSOFT_MODE_XTS:
+			if ((args->iv == NULL) || (args->ivSize != keyLen) || ((args->start % CRYPSOFT_UNIT_SIZE) != 0) ||
+					(((args->end - args->start) % CRYPSOFT_UNIT_SIZE) != 0)) {
+				return -EINVAL;
+			}
+			break;
+
+		default:
+			return -EINVAL;
+	}
+
+	if (crypsoft_isEncrypted(minor, args->start, args->end - args->start) != 0) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < CRYPSOFT_REGIONS; i++) {
+		if (crypsoft_common.region[minor][i].enabled == 0) {
+			r = &crypsoft_common.region[minor][i];
+			break;
+		}
+	}
+
+	if (r == NULL) {
+		return -ENOMEM;
+	}
+
+	hal_memset(r, 0, sizeof(*r));
+	res = aes_setKey(&r->key, args->key, keyLen);
+	if ((res == EOK) && (args->mode == CRYPSOFT_MODE_XTS)) {
+		res = aes_setKey(&r->tweak, args->iv, keyLen);
+	}
+	if (res < 0) {
+		hal_memset(r, 0, sizeof(*r));
+		return res;
+	}
+
+	if ((args->mode == CRYPSOFT_MODE_CTR) && (args->iv != NULL)) {
+		hal_memcpy(r->iv, args->iv, AES_BLOCK_SIZE);
+	}
+
+	r->start = args->start;
+	r->end = args->end;
+	r->mode = args->mode;
+	r->enabled = 1;
+
+	return EOK;
+}
+
+
+/* Device interface */
+
+static ssize_t crypsoft_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
+{
+	ssize_t res;
+	size_t chunk, done = 0;
+	int err;
+
+	if (minor >= CRYPSOFT_NO) {
+		return -EINVAL;
+	}
+
+	while (done < len) {
+		chunk = min(len - done, CRYPSOFT_CHUNK_SIZE - (size_t)((offs + done) % CRYPSOFT_CHUNK_SIZE));
+
+		res = devs_read(DEV_STORAGE, minor, offs + done, (u8 *)buff + done, chunk, timeout);
+		if (res <= 0) {
+			return (done > 0) ? (ssize_t)done : res;
+		}
+
+		err = crypsoft_transform(minor, offs + done, (u8 *)buff + done, (size_t)res, 1);
+		if (err < 0) {
+			return err;
+		}
+
+		done += (size_t)res;
+		if ((size_t)res < chunk) {
+			break;
+		}
+	}
+
+	return (ssize_t)done;
+}
+
+
+static ssize_t crypsoft_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
+{
+	ssize_t res;
+	size_t chunk, done = 0;
+	addr_t pos, bs, be;
+	int err;
+
+	if (minor >= CRYPSOFT_NO) {
+		return -EINVAL;
+	}
+
+	if (crypsoft_isEncrypted(minor, offs, len) == 0) {
+		return devs_write(DEV_STORAGE, minor, offs, buff, len);
+	}
+
+	/* Caller's buffer is const, encrypt through a bounce buffer */
+	while (done < len) {
+		pos = offs + done;
+		chunk = min(len - done, CRYPSOFT_UNIT_SIZE - (size_t)(pos % CRYPSOFT_UNIT_SIZE));
+
+		/* XTS ciphertext can be only replaced in whole blocks, complete partial ones with the current plaintext */
+		bs = pos & ~(addr_t)(AES_BLOCK_SIZE - 1);
+		be = (pos + chunk + AES_BLOCK_SIZE - 1) & ~(addr_t)(AES_BLOCK_SIZE - 1);
+		if ((bs != pos) || (be != (pos + chunk))) {
+			res = crypsoft_read(minor, bs, crypsoft_common.buf, be - bs, 0);
+			if (res < 0) {
+				return res;
+			}
+			if ((size_t)res != (be - bs)) {
+				return -EIO;
+			}
+		}
+		hal_memcpy(crypsoft_common.buf + (pos - bs), (const u8 *)buff + done, chunk);
+
+		err = crypsoft_transform(minor, bs, crypsoft_common.buf, be - bs, 0);
+		if (err < 0) {
+			return err;
+		}
+
+		res = devs_write(DEV_STORAGE, minor, bs, crypsoft_common.buf, be - bs);
+		if (res < 0) {
+			return res;
+		}
+
+		done += chunk;
+	}
+
+	return (ssize_t)done;
+}
+
+
+static ssize_t crypsoft_erase(unsigned int minor, addr_t offs, size_t len, unsigned int flags)
+{
+	return devs_erase(DEV_STORAGE, minor, offs, len, flags);
+}
+
+
+static int crypsoft_sync(unsigned int minor)
+{
+	return devs_sync(DEV_STORAGE, minor);
+}
+
+
+static int crypsoft_map(unsigned int minor, addr_t addr, size_t sz, int mode, addr_t memaddr, size_t memsz, int memmode, addr_t *a)
+{
+	int res = devs_map(DEV_STORAGE, minor, addr, sz, mode, memaddr, memsz, memmode, a);
+
+	/* Mapped memory holds the ciphertext, encrypted data has to be copied through read */
+	if ((res == dev_isMappable) && (crypsoft_isEncrypted(minor, addr, sz) != 0)) {
+		if ((mode & memmode) != mode) {
+			return -EINVAL;
+		}
+
+		return dev_isNotMappable;
+	}
+
+	return res;
+}
+
+
+static int crypsoft_control(unsigned int minor, int cmd, void *args)
+{
+	if (minor >= CRYPSOFT_NO) {
+		return -EINVAL;
+	}
+
+	if (cmd == DEV_CONTROL_MEMCRYPT) {
+		return crypsoft_memcrypt(minor, (const dev_memcrypt_args_t *)args);
+	}
+
+	return devs_control(DEV_STORAGE, minor, cmd, args);
+}
+
+
+static int crypsoft_done(unsigned int minor)
+{
+	if (minor >= CRYPSOFT_NO) {
+		return -EINVAL;
+	}
+
+	/* Don't leave keys in memory */
+	hal_memset(crypsoft_common.region[minor], 0, sizeof(crypsoft_common.region[minor]));
+
+	return EOK;
+}
+
+
+static int crypsoft_init(unsigned int minor)
+{
+	if (minor >= CRYPSOFT_NO) {
+		return -EINVAL;
+	}
+
+	if (minor == 0) {
+		aes_init();
+	}
+
+	return devs_check(DEV_STORAGE, minor);
+}
+
+
+__attribute__((constructor)) static void crypsoft_reg(void)
+{
+	static const dev_ops_t opsCrypSoft = {
+		.read = crypsoft_read,
+		.write = crypsoft_write,
+		.erase = crypsoft_erase,
+		.sync = crypsoft_sync,
+		.map = crypsoft_map,
+		.control = crypsoft_control,
+	};
+
+	static const dev_t devCrypSoft = {
+		.name = "cryp-soft",
+		.init = crypsoft_init,
+		.done = crypsoft_done,
+		.ops = &opsCrypSoft,
+	};
+
+	hal_memset(&crypsoft_common, 0, sizeof(crypsoft_common));
+
+	devs_register(DEV_CRYP_STORAGE, CRYPSOFT_NO, &devCrypSoft);
+}
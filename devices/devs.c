@@ -16,6 +16,8 @@
 #include "devs.h"
 
 #include <lib/errno.h>
+#include <lib/perf.h>
+#include <phfs/phfs.h>
 
 #define SIZE_MAJOR 11
 #define SIZE_MINOR 16
@@ -25,6 +27,36 @@ struct {
 } devs_common;
 
 
+static int devs_available(const char *compatible)
+{
+	(void)compatible;
+
+	return 1;
+}
+
+
+int hal_devAvailable(const char *compatible) __attribute__((weak, alias("devs_available")));
+
+
+/* Device is available if any of its compatible strings is present */
+static int devs_isAvailable(const dev_t *dev)
+{
+	const char *const *compatible = dev->compatible;
+
+	if (compatible == NULL) {
+		return 1;
+	}
+
+	for (; *compatible != NULL; compatible++) {
+		if (hal_devAvailable(*compatible) != 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
 void devs_register(unsigned int major, unsigned int nb, const dev_t *dev)
 {
 	unsigned int minor;
@@ -53,7 +85,11 @@ void devs_init(void)
 		for (minor = 0; minor < SIZE_MINOR; ++minor) {
 			dev = devs_common.devs[major][minor];
 			if ((dev != NULL) && (dev->init != NULL)) {
-				/* TODO: check in dtb the availability of a device in the current platform */
+				if (devs_isAvailable(dev) == 0) {
+					/* Device is absent or disabled in the current platform, don't probe it */
+					devs_common.devs[major][minor] = NULL;
+					continue;
+				}
 				/* TODO: check initialization */
 				dev->init(minor);
 			}
@@ -120,33 +156,118 @@ int devs_check(unsigned int major, unsigned int minor)
 }
 
 
+unsigned int devs_flags(unsigned int major, unsigned int minor)
+{
+	const dev_t *dev = devs_get(major, minor);
+
+	return (dev != NULL) ?
+		dev->flags :
+		0;
+}
+
+
+/* Content of the device changed, drop its blocks cached by phfs */
+static void devs_modified(unsigned int major, unsigned int minor)
+{
+	if ((devs_flags(major, minor) & DEV_FLAG_RDCACHE) != 0) {
+		phfs_cacheInval(major, minor);
+	}
+}
+
+
+static int devs_traced(unsigned int major)
+{
+	/* Console and pipe traffic would flood the event stream */
+	return (lib_perfEnabled() != 0) && (major != DEV_UART) && (major != DEV_TTY) && (major != DEV_PIPE);
+}
+
+
+static void devs_trace(unsigned int type, unsigned int major, unsigned int minor, addr_t offs, ssize_t res, time_t start)
+{
+	lib_perfEvent(type, (major << 8) | minor, start, (u32)offs, (u32)res, (u32)(hal_timerGet() - start), NULL);
+}
+
+
 ssize_t devs_read(unsigned int major, unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
 	const dev_ops_t *ops = devs_ops(major, minor);
+	time_t start;
+	ssize_t res;
 
-	return ((ops != NULL) && (ops->read != NULL)) ?
-		ops->read(minor, offs, buff, len, timeout) :
-		-ENOSYS;
+	if ((ops == NULL) || (ops->read == NULL)) {
+		return -ENOSYS;
+	}
+
+	if (devs_traced(major) == 0) {
+		return ops->read(minor, offs, buff, len, timeout);
+	}
+
+	start = hal_timerGet();
+	res = ops->read(minor, offs, buff, len, timeout);
+	devs_trace(PERF_EV_DEV_READ, major, minor, offs, res, start);
+
+	return res;
 }
 
 
 ssize_t devs_write(unsigned int major, unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
 	const dev_ops_t *ops = devs_ops(major, minor);
+	time_t start;
+	ssize_t res;
 
-	return ((ops != NULL) && (ops->write != NULL)) ?
-		ops->write(minor, offs, buff, len) :
-		-ENOSYS;
+	if ((ops == NULL) || (ops->write == NULL)) {
+		return -ENOSYS;
+	}
+
+	devs_modified(major, minor);
+
+	if (devs_traced(major) == 0) {
+		return ops->write(minor, offs, buff, len);
+	}
+
+	start = hal_timerGet();
+	res = ops->write(minor, offs, buff, len);
+	devs_trace(PERF_EV_DEV_WRITE, major, minor, offs, res, start);
+
+	return res;
+}
+
+
+ssize_t devs_program(unsigned int major, unsigned int minor, addr_t offs, const void *buff, size_t len)
+{
+	const dev_ops_t *ops = devs_ops(major, minor);
+
+	if ((ops != NULL) && (ops->program != NULL)) {
+		devs_modified(major, minor);
+		return ops->program(minor, offs, buff, len);
+	}
+
+	return devs_write(major, minor, offs, buff, len);
 }
 
 
 ssize_t devs_erase(unsigned int major, unsigned int minor, addr_t offs, size_t len, unsigned int flags)
 {
 	const dev_ops_t *ops = devs_ops(major, minor);
+	time_t start;
+	ssize_t res;
 
-	return ((ops != NULL) && (ops->erase != NULL)) ?
-		ops->erase(minor, offs, len, flags) :
-		-ENOSYS;
+	if ((ops == NULL) || (ops->erase == NULL)) {
+		return -ENOSYS;
+	}
+
+	devs_modified(major, minor);
+
+	if (devs_traced(major) == 0) {
+		return ops->erase(minor, offs, len, flags);
+	}
+
+	start = hal_timerGet();
+	res = ops->erase(minor, offs, len, flags);
+	devs_trace(PERF_EV_DEV_ERASE, major, minor, offs, res, start);
+
+	return res;
 }
 
 
@@ -44,6 +44,12 @@
 #define DEV_MEMCRYPT_ALGO_NOEKEON 2UL
 #define DEV_MEMCRYPT_ALGO_AES256  3UL
 
+/* Erase flags */
+#define DEV_ERASE_SKIPBLANK (1U << 0) /* Don't erase blocks which are already in erased state */
+
+/* Device flags */
+#define DEV_FLAG_RDCACHE (1U << 0) /* Reads can be cached by phfs, content changes only through write and erase */
+
 
 typedef struct {
 	addr_t start;  /* Start offset of encryption region */
@@ -78,18 +84,26 @@ typedef struct {
 	ssize_t (*read)(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout);
 	ssize_t (*write)(unsigned int minor, addr_t offs, const void *buff, size_t len);
 	ssize_t (*erase)(unsigned int minor, addr_t offs, size_t len, unsigned int flags);
+	ssize_t (*program)(unsigned int minor, addr_t offs, const void *buff, size_t len); /* Optional, no read-modify-write */
 } dev_ops_t;
 
 
 /* Device enclosure */
 typedef struct _dev_t {
 	const char *name;
+	const char *const *compatible; /* NULL terminated list of device tree compatible strings, NULL if the device is always present */
+	unsigned int flags;            /* DEV_FLAG_* */
 	int (*init)(unsigned int minor);
 	int (*done)(unsigned int minor);
 	const dev_ops_t *ops;
 } dev_t;
 
 
+/* Checks whether device is present and enabled in the platform description (e.g. device tree).
+ * Provided by HALs with a device tree, by default all devices are present. */
+extern int hal_devAvailable(const char *compatible);
+
+
 /* This function should be called only before devs_init(),
  * preferably from device drivers constructors */
 extern void devs_register(unsigned int major, unsigned int nb, const dev_t *dev);
@@ -107,6 +121,10 @@ const dev_t *devs_iterNext(unsigned int *ctx, unsigned int *major, unsigned int
 extern int devs_check(unsigned int major, unsigned int minor);
 
 
+/* Get device flags */
+extern unsigned int devs_flags(unsigned int major, unsigned int minor);
+
+
 /* Make synchronization on device. Preferred usage after write function */
 extern int devs_sync(unsigned int major, unsigned int minor);
 
@@ -127,6 +145,11 @@ extern ssize_t devs_read(unsigned int major, unsigned int minor, addr_t offs, vo
 extern ssize_t devs_write(unsigned int major, unsigned int minor, addr_t offs, const void *buff, size_t len);
 
 
+/* Write data to the erased region of device, without read-modify-write of the surrounding block.
+ * Falls back to devs_write() if device doesn't support direct programming */
+extern ssize_t devs_program(unsigned int major, unsigned int minor, addr_t offs, const void *buff, size_t len);
+
+
 /* Erase data from storage device */
 extern ssize_t devs_erase(unsigned int major, unsigned int minor, addr_t offs, size_t len, unsigned int flags);
 
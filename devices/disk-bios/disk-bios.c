@@ -27,8 +27,8 @@
 #define DISK_READ  0x2
 #define DISK_WRITE 0x3
 
-/* Disk caches size in blocks */
-#define BLOCKS_RCACHE (SIZE_RCACHE / SIZE_BLOCK)
+/* Disk read buffer and write cache size in blocks */
+#define BLOCKS_RBUFF  (SIZE_RBUFF / SIZE_BLOCK)
 #define BLOCKS_WCACHE (SIZE_WCACHE / SIZE_BLOCK)
 
 
@@ -49,8 +49,8 @@ typedef struct {
 } diskbios_t;
 
 
-/* Disk caches */
-static char *const rcache = (char *const)ADDR_RCACHE;
+/* BIOS transfers data through low memory, reads are cached by phfs */
+static char *const rbuff = (char *const)ADDR_RBUFF;
 static char *const wcache = (char *const)ADDR_WCACHE;
 
 
@@ -58,12 +58,6 @@ struct {
 	/* Disks info */
 	diskbios_t disks[DISKBIOS_MAX_CNT];
 
-	/* Read cache handling */
-	unsigned char lrdn; /* Last read disk */
-	unsigned int lrc;   /* Last read cylinder */
-	unsigned int lrh;   /* Last read head */
-	unsigned int lrp;   /* Last read rcache position */
-
 	/* Write cache handling */
 	unsigned char lwdn; /* Last written disk */
 	unsigned int lwc;   /* Last written cylinder */
@@ -250,55 +244,6 @@ static diskbios_t *diskbios_get(unsigned int minor)
 }
 
 
-static ssize_t diskbios_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
-{
-	diskbios_t *disk;
-	unsigned long long sb, eb;
-	unsigned int c, h, s, p;
-	size_t size, n = 0;
-
-	disk = diskbios_get(minor);
-	if (disk == NULL) {
-		return -EINVAL;
-	}
-
-	if (len == 0) {
-		return 0;
-	}
-
-	/* Calculate start and end blocks */
-	sb = offs / SIZE_BLOCK;
-	eb = (offs + len - 1) / SIZE_BLOCK;
-
-	for (; sb <= eb; sb++) {
-		c = (sb / disk->geo.secs) / disk->geo.heads;
-		h = (sb / disk->geo.secs) % disk->geo.heads;
-		s = sb % disk->geo.secs;
-		p = (s / BLOCKS_RCACHE) * BLOCKS_RCACHE;
-
-		/* Read compact track segment from disk to cache */
-		if ((disk->dn != diskbios_common.lrdn) || (c != diskbios_common.lrc) || (h != diskbios_common.lrh) || (p != diskbios_common.lrp)) {
-			if (diskbios_access(disk, DISK_READ, c, h, p + 1, min(BLOCKS_RCACHE, disk->geo.secs - p), rcache)) {
-				return -EIO;
-			}
-
-			diskbios_common.lrdn = disk->dn;
-			diskbios_common.lrc = c;
-			diskbios_common.lrh = h;
-			diskbios_common.lrp = p;
-		}
-
-		/* Read data from cache */
-		size = (sb == eb) ? len - n : SIZE_BLOCK - (offs % SIZE_BLOCK);
-		hal_memcpy((char *)buff + n, rcache + (s % BLOCKS_RCACHE) * SIZE_BLOCK + (offs % SIZE_BLOCK), size);
-		offs += size;
-		n += size;
-	}
-
-	return n;
-}
-
-
 static ssize_t diskbios_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
 	diskbios_t *disk;
@@ -391,6 +336,60 @@ static int diskbios_sync(unsigned int minor)
 }
 
 
+static ssize_t diskbios_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
+{
+	diskbios_t *disk;
+	unsigned long long sb, eb;
+	unsigned int c, h, s, cnt;
+	size_t size, n = 0;
+
+	disk = diskbios_get(minor);
+	if (disk == NULL) {
+		return -EINVAL;
+	}
+
+	if (len == 0) {
+		return 0;
+	}
+
+	/* Data pending in the write cache has to reach the disk first */
+	if (diskbios_sync(minor) < 0) {
+		return -EIO;
+	}
+
+	/* Calculate start and end blocks */
+	sb = offs / SIZE_BLOCK;
+	eb = (offs + len - 1) / SIZE_BLOCK;
+
+	while (sb <= eb) {
+		c = (sb / disk->geo.secs) / disk->geo.heads;
+		h = (sb / disk->geo.secs) % disk->geo.heads;
+		s = sb % disk->geo.secs;
+
+		/* Read consecutive blocks of the track at once */
+		cnt = disk->geo.secs - s;
+		if (cnt > BLOCKS_RBUFF) {
+			cnt = BLOCKS_RBUFF;
+		}
+		if (cnt > eb - sb + 1) {
+			cnt = eb - sb + 1;
+		}
+
+		if (diskbios_access(disk, DISK_READ, c, h, s + 1, cnt, rbuff)) {
+			return -EIO;
+		}
+
+		size = min(len - n, cnt * SIZE_BLOCK - (offs % SIZE_BLOCK));
+		hal_memcpy((char *)buff + n, rbuff + (offs % SIZE_BLOCK), size);
+		offs += size;
+		n += size;
+		sb += cnt;
+	}
+
+	return n;
+}
+
+
 static int diskbios_map(unsigned int minor, addr_t addr, size_t sz, int mode, addr_t memaddr, size_t memsz, int memmode, addr_t *a)
 {
 	diskbios_t *disk;
@@ -456,13 +455,13 @@ __attribute__((constructor)) static void diskbios_register(void)
 
 	static const dev_t devDiskBIOS = {
 		.name = "disk-bios",
+		.flags = DEV_FLAG_RDCACHE,
 		.init = diskbios_init,
 		.done = diskbios_done,
 		.ops = &opsDiskBIOS,
 	};
 
-	/* Mark caches not used */
-	diskbios_common.lrdn = -1;
+	/* Mark write cache not used */
 	diskbios_common.lwdn = -1;
 
 	devs_register(DEV_STORAGE, DISKBIOS_MAX_CNT, &devDiskBIOS);
@@ -86,6 +86,59 @@ static inline addr_t get_sectorAddress(struct nor_device *dev, addr_t addr)
 }
 
 
+static int isSectorErased(struct nor_device *dev, addr_t sectorAddr)
+{
+	ssize_t res;
+	size_t pos;
+
+	/* Sector buffer is free to use, sync state is invalidated by the caller */
+	res = nor_readData(&dev->fspi, dev->port, sectorAddr, dev->sectorBuf, dev->nor->sectorSz, dev->timeout);
+	if (res < 0) {
+		return res;
+	}
+
+	for (pos = 0; pos < dev->nor->sectorSz; ++pos) {
+		if (*(dev->sectorBuf + pos) != NOR_ERASED_STATE) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+
+/* Erases block, with DEV_ERASE_SKIPBLANK only its dirty sectors if there is at most one */
+static int eraseBlock(struct nor_device *dev, addr_t blockAddr, unsigned int flags)
+{
+	int res;
+	addr_t offs, dirtyAddr = 0;
+	unsigned int dirty = 0;
+
+	if ((flags & DEV_ERASE_SKIPBLANK) != 0) {
+		for (offs = 0; (offs < NOR_BLOCKSZ) && (dirty < 2); offs += dev->nor->sectorSz) {
+			res = isSectorErased(dev, blockAddr + offs);
+			if (res < 0) {
+				return res;
+			}
+			if (res == 0) {
+				dirtyAddr = blockAddr + offs;
+				dirty++;
+			}
+		}
+
+		/* Single sector erase is faster than the block erase */
+		if (dirty == 0) {
+			return EOK;
+		}
+		else if (dirty == 1) {
+			return nor_eraseSector(&dev->fspi, dev->port, dirtyAddr, dev->timeout);
+		}
+	}
+
+	return nor_eraseBlock(&dev->fspi, dev->port, blockAddr, dev->timeout);
+}
+
+
 /* Device driver interface */
 
 static int flashdrv_control(unsigned int minor, int cmd, void *args)
@@ -299,6 +352,58 @@ static ssize_t flashdrv_write(unsigned int minor, addr_t dstAddr, const void *da
 }
 
 
+static ssize_t flashdrv_program(unsigned int minor, addr_t dstAddr, const void *data, size_t size)
+{
+	int res;
+	addr_t start = dstAddr;
+	const u8 *srcPtr = data;
+	size_t chunkSz, doneBytes;
+	struct nor_device *dev = minorToDevice(minor);
+
+	if (dev == NULL || dev->active == 0) {
+		return -ENXIO;
+	}
+
+	if (data == NULL || dstAddr + size > dev->fspi.slFlashSz[dev->port]) {
+		return -EINVAL;
+	}
+
+	if (size == 0) {
+		return 0;
+	}
+
+	/* Flush pending write, the sector buffer can't hold stale data of the programmed region */
+	res = flashdrv_sync(minor);
+	if (res < 0) {
+		return res;
+	}
+
+	dev->sectorPrevAddr = (addr_t)-1;
+	dev->sectorSyncAddr = (addr_t)-1;
+
+	doneBytes = 0;
+	while (doneBytes < size) {
+		chunkSz = dev->nor->pageSz - (dstAddr & (dev->nor->pageSz - 1));
+		if (chunkSz > size - doneBytes) {
+			chunkSz = size - doneBytes;
+		}
+
+		res = nor_pageProgram(&dev->fspi, dev->port, dstAddr, srcPtr, chunkSz, dev->timeout);
+		if (res < 0) {
+			return res;
+		}
+
+		dstAddr += chunkSz;
+		srcPtr += chunkSz;
+		doneBytes += chunkSz;
+	}
+
+	hal_cpuInvCache(hal_cpuDCache, start, size);
+
+	return doneBytes;
+}
+
+
 static ssize_t flashdrv_read(unsigned int minor, addr_t addr, void *data, size_t size, time_t timeout)
 {
 	struct nor_device *dev = minorToDevice(minor);
@@ -331,8 +436,6 @@ static ssize_t flashdrv_erase(unsigned int minor, addr_t addr, size_t len, unsig
 
 	struct nor_device *dev = minorToDevice(minor);
 
-	(void)flags;
-
 	if (dev == NULL || dev->active == 0) {
 		return -ENXIO;
 	}
@@ -383,7 +486,22 @@ static ssize_t flashdrv_erase(unsigned int minor, addr_t addr, size_t len, unsig
 
 	len = 0;
 	while (addr < end) {
-		res = nor_eraseSector(&dev->fspi, dev->port, addr, dev->timeout);
+		/* Whole aligned blocks are erased at once */
+		if (((addr & (NOR_BLOCKSZ - 1)) == 0) && ((end - addr) >= NOR_BLOCKSZ)) {
+			res = eraseBlock(dev, addr, flags);
+			if (res < 0) {
+				return res;
+			}
+			addr += NOR_BLOCKSZ;
+			len += NOR_BLOCKSZ;
+			continue;
+		}
+
+		/* Reading a sector is much faster than erasing it */
+		res = ((flags & DEV_ERASE_SKIPBLANK) != 0) ? isSectorErased(dev, addr) : 0;
+		if (res == 0) {
+			res = nor_eraseSector(&dev->fspi, dev->port, addr, dev->timeout);
+		}
 		if (res < 0) {
 			return res;
 		}
@@ -485,6 +603,7 @@ __attribute__((constructor)) static void flashdrv_reg(void)
 		.read = flashdrv_read,
 		.write = flashdrv_write,
 		.erase = flashdrv_erase,
+		.program = flashdrv_program,
 		.sync = flashdrv_sync,
 		.map = flashdrv_map,
 		.control = flashdrv_control,
@@ -156,7 +156,7 @@ __attribute__((section(".noxip"))) int nor_writeEnable(flexspi_t *fspi, u8 port,
 }
 
 
-__attribute__((section(".noxip"))) int nor_eraseSector(flexspi_t *fspi, u8 port, addr_t addr, time_t timeout)
+__attribute__((section(".noxip"))) static int nor_erase(flexspi_t *fspi, u8 port, addr_t addr, int seqCode, time_t timeout)
 {
 	struct xferOp xfer;
 
@@ -169,8 +169,8 @@ __attribute__((section(".noxip"))) int nor_eraseSector(flexspi_t *fspi, u8 port,
 	xfer.port = port;
 	xfer.timeout = timeout;
 	xfer.addr = addr;
-	xfer.seqIdx = LUT_SEQIDX(fspi_eraseSector);
-	xfer.seqNum = LUT_SEQNUM(fspi_eraseSector);
+	xfer.seqIdx = LUT_SEQIDX(seqCode);
+	xfer.seqNum = LUT_SEQNUM(seqCode);
 
 	res = flexspi_xferExec(fspi, &xfer);
 	if (res < EOK) {
@@ -181,6 +181,18 @@ __attribute__((section(".noxip"))) int nor_eraseSector(flexspi_t *fspi, u8 port,
 }
 
 
+__attribute__((section(".noxip"))) int nor_eraseSector(flexspi_t *fspi, u8 port, addr_t addr, time_t timeout)
+{
+	return nor_erase(fspi, port, addr, fspi_eraseSector, timeout);
+}
+
+
+__attribute__((section(".noxip"))) int nor_eraseBlock(flexspi_t *fspi, u8 port, addr_t addr, time_t timeout)
+{
+	return nor_erase(fspi, port, addr, fspi_eraseBlock, timeout);
+}
+
+
 __attribute__((section(".noxip"))) static int nor_mode4ByteAddr(flexspi_t *fspi, u8 port, int en4b, time_t timeout)
 {
 	struct xferOp xfer;
@@ -19,6 +19,7 @@
 #define NOR_ERASED_STATE    0xff
 #define NOR_DEFAULT_TIMEOUT 10000
 #define NOR_SECTORSZ_MAX    0x1000
+#define NOR_BLOCKSZ         0x10000 /* Block erase unit */
 #define NOR_PAGESZ_MAX      0x100
 
 #define NOR_CAPS_GENERIC 0
@@ -76,6 +77,9 @@ extern int nor_writeEnable(flexspi_t *fspi, u8 port, int enable, time_t timeout)
 extern int nor_eraseSector(flexspi_t *fspi, u8 port, addr_t addr, time_t timeout);
 
 
+extern int nor_eraseBlock(flexspi_t *fspi, u8 port, addr_t addr, time_t timeout);
+
+
 extern int nor_eraseChipDie(flexspi_t *fspi, u8 port, u32 capFlags, int dieCount, size_t dieSize, time_t timeout);
 
 
@@ -658,6 +658,7 @@ __attribute__((constructor)) static void flashdrv_reg(void)
 
 	static const dev_t devFlashZYNQ = {
 		.name = "flash-zynq",
+		.flags = DEV_FLAG_RDCACHE,
 		.init = flashdrv_init,
 		.done = flashdrv_done,
 		.ops = &opsFlashZYNQ,
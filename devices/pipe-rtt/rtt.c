@@ -30,6 +30,9 @@
 #define RTT_TXCHANNELS (2 + RTT_TX_PERF_CHANNELS)
 #define RTT_RXCHANNELS 2
 
+#define RTT_CHAN_PERF_META  2
+#define RTT_CHAN_PERF_EVENT 3
+
 /*
  * Note: RTT_TAG needs to be backward written string. This tag is used by
  * the RTT remote side e.g. openocd to find descriptor location during memory
@@ -124,30 +127,35 @@ int rtt_check(int chan)
 
 ssize_t rtt_read(int chan, void *buf, size_t count)
 {
-	if (rtt_check(chan) < 0) {
+	if ((rtt_check(chan) < 0) || (chan >= RTT_RXCHANNELS)) {
 		return -ENODEV;
 	}
 
 	hal_cpuDataMemoryBarrier();
 
-	unsigned char *srcBuf = (unsigned char *)rtt->rxChannel[chan].ptr;
+	const unsigned char *srcBuf = (const unsigned char *)rtt->rxChannel[chan].ptr;
 	unsigned char *dstBuf = (unsigned char *)buf;
 	unsigned int rd = rtt->rxChannel[chan].rd;
 	unsigned int wr = rtt->rxChannel[chan].wr;
 	unsigned int sz = rtt->rxChannel[chan].sz;
-	size_t todo = count;
-
-	while ((todo != 0) && (rd != wr)) {
-		*dstBuf++ = srcBuf[rd];
-		rd = (rd + 1) % sz;
-		todo--;
+	size_t done = 0, span;
+
+	/* At most two spans: up to the end of the buffer and from its beginning */
+	while ((done < count) && (rd != wr)) {
+		span = min(count - done, (size_t)(((wr > rd) ? wr : sz) - rd));
+		hal_memcpy(dstBuf + done, srcBuf + rd, span);
+		done += span;
+		rd += span;
+		if (rd == sz) {
+			rd = 0;
+		}
 	}
 
 	hal_cpuDataMemoryBarrier();
 
 	rtt->rxChannel[chan].rd = rd;
 
-	return count - todo;
+	return done;
 }
 
 
@@ -162,21 +170,37 @@ ssize_t rtt_write(int chan, const void *buf, size_t count)
 	const unsigned char *srcBuf = (const unsigned char *)buf;
 	unsigned char *dstBuf = (unsigned char *)rtt->txChannel[chan].ptr;
 	unsigned int sz = rtt->txChannel[chan].sz;
-	unsigned int rd = (rtt->txChannel[chan].rd + sz - 1) % sz;
+	unsigned int rd = rtt->txChannel[chan].rd;
 	unsigned int wr = rtt->txChannel[chan].wr;
-	size_t todo = count;
+	size_t done = 0, span;
+
+	/* One byte is left free to tell full buffer from the empty one */
+	while (done < count) {
+		if (wr >= rd) {
+			span = sz - wr - ((rd == 0) ? 1 : 0);
+		}
+		else {
+			span = rd - wr - 1;
+		}
+
+		if (span == 0) {
+			break;
+		}
 
-	while ((todo != 0) && (rd != wr)) {
-		dstBuf[wr] = *srcBuf++;
-		wr = (wr + 1) % sz;
-		todo--;
+		span = min(count - done, span);
+		hal_memcpy(dstBuf + wr, srcBuf + done, span);
+		done += span;
+		wr += span;
+		if (wr == sz) {
+			wr = 0;
+		}
 	}
 
 	hal_cpuDataMemoryBarrier();
 
 	rtt->txChannel[chan].wr = wr;
 
-	return count - todo;
+	return done;
 }
 
 
@@ -184,18 +208,27 @@ static ssize_t rtt_writeBlocking(int chan, const void *buf, size_t count)
 {
 	const unsigned char *ptr = buf;
 	size_t todo = count;
-	time_t start = hal_timerGet();
+	time_t start = 0;
 
 	while (todo > 0) {
-		if ((hal_timerGet() - start) >= 100) {
-			rtt->txChannel[chan].wr = rtt->txChannel[chan].rd;
-			return -ETIME;
-		}
-
 		ssize_t len = rtt_write(chan, ptr, todo);
 		if (len < 0) {
 			return len;
 		}
+
+		/* Timer is checked only while the buffer is full */
+		if (len == 0) {
+			if (start == 0) {
+				start = hal_timerGet();
+			}
+			else if ((hal_timerGet() - start) >= 100) {
+				rtt->txChannel[chan].wr = rtt->txChannel[chan].rd;
+				return -ETIME;
+			}
+		}
+		else {
+			start = 0;
+		}
 		todo -= len;
 		ptr += len;
 	}
@@ -204,6 +237,44 @@ static ssize_t rtt_writeBlocking(int chan, const void *buf, size_t count)
 }
 
 
+#if RTT_PERF_BUFFERS
+static unsigned int rtt_txFree(int chan)
+{
+	unsigned int sz = rtt->txChannel[chan].sz;
+
+	return (rtt->txChannel[chan].rd + sz - rtt->txChannel[chan].wr - 1) % sz;
+}
+
+
+/* Events are written as a whole or dropped, the loader never waits for the probe */
+static int rtt_perfWrite(const void *buf, size_t count)
+{
+	hal_cpuDataMemoryBarrier();
+
+	if (rtt_txFree(RTT_CHAN_PERF_EVENT) < count) {
+		return -ENOSPC;
+	}
+
+	return (rtt_write(RTT_CHAN_PERF_EVENT, buf, count) == (ssize_t)count) ? EOK : -EIO;
+}
+
+
+static void rtt_perfInit(void)
+{
+	perf_meta_t meta;
+
+	hal_memset(&meta, 0, sizeof(meta));
+	hal_memcpy(meta.magic, PERF_MAGIC, sizeof(PERF_MAGIC) - 1);
+	meta.version = PERF_VERSION;
+	meta.eventSize = sizeof(perf_event_t);
+	meta.timeUnit = 1000000; /* hal_timerGet() resolution */
+
+	(void)rtt_write(RTT_CHAN_PERF_META, &meta, sizeof(meta));
+	lib_perfSetHook(rtt_perfWrite);
+}
+#endif
+
+
 void rtt_init(void *addr)
 {
 	size_t n, m;
@@ -242,6 +313,10 @@ void rtt_init(void *addr)
 
 	hal_consoleSetHooks(rtt_write);
 	lib_consoleSetHooks(rtt_read, rtt_writeBlocking);
+
+#if RTT_PERF_BUFFERS
+	rtt_perfInit();
+#endif
 }
 
 
@@ -249,6 +324,7 @@ void rtt_done(void)
 {
 	if (rtt != NULL) {
 		lib_consoleSetHooks(NULL, NULL);
+		lib_perfSetHook(NULL);
 		hal_memset((void *)rtt, 0, sizeof(*rtt));
 		rtt = NULL;
 	}
@@ -248,6 +248,7 @@ __attribute__((constructor)) static void sdcarddrv_reg(void)
 
 	static const dev_t devSdCardZYNQ7K = {
 		.name = "sdcard-zynq7000",
+		.flags = DEV_FLAG_RDCACHE,
 		.init = sdcarddrv_init,
 		.done = sdcarddrv_done,
 		.ops = &opsSdCardZYNQ7K,
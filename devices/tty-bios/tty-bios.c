@@ -23,6 +23,10 @@
 #define TTYBIOS_TAB_WIDTH 8u
 #endif
 
+/* Text mode size */
+#define TTYBIOS_ROWS 25
+#define TTYBIOS_COLS 80
+
 
 /* ANSI escape sequence states */
 enum {
@@ -72,6 +76,11 @@ typedef struct {
 	u16 crtc;                /* CRT controller register */
 	unsigned int rows;       /* Terminal height */
 	unsigned int cols;       /* Terminal width */
+	unsigned int pos;        /* Cursor position after the last write */
+	u32 gen;                 /* Screen generation after the last write */
+	unsigned int head;       /* Shadow row displayed as the first screen row */
+	u32 dirty;               /* Screen rows modified since the last flush */
+	u16 shadow[TTYBIOS_ROWS * TTYBIOS_COLS]; /* Screen copy in RAM, video memory is slow to access */
 	unsigned char attr;      /* Character attribute */
 	unsigned char esc;       /* Escape sequence state */
 	unsigned char parmi;     /* Escape sequence parameter index */
@@ -85,27 +94,99 @@ struct {
 } ttybios_common;
 
 
-static void ttybios_memset(volatile u16 *vram, u16 val, unsigned int n)
+/* Returns shadow cell of the screen position */
+static u16 *ttybios_cell(ttybios_t *tty, unsigned int row, unsigned int col)
 {
-	unsigned int i;
+	row += tty->head;
+	if (row >= tty->rows) {
+		row -= tty->rows;
+	}
+
+	return &tty->shadow[row * tty->cols + col];
+}
+
+
+static void ttybios_fill(ttybios_t *tty, unsigned int pos, u16 val, unsigned int n)
+{
+	unsigned int row, col, i, cnt;
+	u16 *cell;
+
+	while (n != 0) {
+		row = pos / tty->cols;
+		col = pos % tty->cols;
+		cnt = tty->cols - col;
+		if (cnt > n) {
+			cnt = n;
+		}
+
+		cell = ttybios_cell(tty, row, col);
+		for (i = 0; i < cnt; i++) {
+			cell[i] = val;
+		}
+		tty->dirty |= 1u << row;
+
+		pos += cnt;
+		n -= cnt;
+	}
+}
+
 
-	for (i = 0; i < n; i++)
-		*(vram + i) = val;
+/* Scrolls by rotating shadow rows, the whole screen is rewritten on the next flush */
+static void ttybios_scroll(ttybios_t *tty)
+{
+	ttybios_fill(tty, 0, (u16)tty->attr << 8 | ' ', tty->cols);
+	tty->head = (tty->head + 1 == tty->rows) ? 0 : tty->head + 1;
+	tty->dirty = (1u << tty->rows) - 1;
 }
 
 
-static void ttybios_memmove(volatile u16 *dst, volatile u16 *src, unsigned int n)
+/* Writes modified rows to video memory and updates cursor */
+static void ttybios_flush(ttybios_t *tty, unsigned int row, unsigned int col)
+{
+	volatile u16 *vram;
+	u16 *cell;
+	unsigned int r, i;
+
+	/* Cursor takes the current attribute */
+	cell = ttybios_cell(tty, row, col);
+	*cell = (*cell & 0xff) | ((u16)tty->attr << 8);
+	tty->dirty |= 1u << row;
+
+	for (r = 0; (tty->dirty != 0) && (r < tty->rows); r++) {
+		if ((tty->dirty & (1u << r)) != 0) {
+			cell = ttybios_cell(tty, r, 0);
+			vram = tty->vram + r * tty->cols;
+			for (i = 0; i < tty->cols; i++) {
+				vram[i] = cell[i];
+			}
+			tty->dirty &= ~(1u << r);
+		}
+	}
+
+	tty->pos = row * tty->cols + col;
+	tty->gen = hal_consoleVgaWritten();
+	hal_outb(tty->crtc, 0x0e);
+	hal_outb(tty->crtc + 1, tty->pos >> 8);
+	hal_outb(tty->crtc, 0x0f);
+	hal_outb(tty->crtc + 1, tty->pos);
+}
+
+
+/* Reloads shadow, if the screen has been written by someone else (e.g. HAL console) */
+static void ttybios_reload(ttybios_t *tty, unsigned int pos)
 {
 	unsigned int i;
 
-	if (dst < src) {
-		for (i = 0; i < n; i++)
-			dst[i] = src[i];
+	/* Cursor check also catches writers not tracking the generation (e.g. BIOS) */
+	if ((pos == tty->pos) && (hal_consoleVgaGen() == tty->gen)) {
+		return;
 	}
-	else {
-		for (i = n; i--;)
-			dst[i] = src[i];
+
+	for (i = 0; i < tty->rows * tty->cols; i++) {
+		tty->shadow[i] = tty->vram[i];
 	}
+	tty->head = 0;
+	tty->dirty = 0;
 }
 
 
@@ -231,6 +312,7 @@ static ssize_t ttybios_write(unsigned int minor, addr_t offs, const void *buff,
 	pos = hal_inb(tty->crtc + 1);
 	hal_outb(tty->crtc, 0x0e);
 	pos |= (u16)hal_inb(tty->crtc + 1) << 8;
+	ttybios_reload(tty, pos);
 	row = pos / tty->cols;
 	col = pos % tty->cols;
 
@@ -272,7 +354,8 @@ static ssize_t ttybios_write(unsigned int minor, addr_t offs, const void *buff,
 		else {
 			switch (tty->esc) {
 				case esc_init:
-					*(tty->vram + row * tty->cols + col) = (u16)tty->attr << 8 | c;
+					*ttybios_cell(tty, row, col) = (u16)tty->attr << 8 | c;
+					tty->dirty |= 1u << row;
 					col++;
 					break;
 
@@ -334,15 +417,15 @@ static ssize_t ttybios_write(unsigned int minor, addr_t offs, const void *buff,
 						case 'J':
 							switch (tty->parms[0]) {
 								case 0:
-									ttybios_memset(tty->vram + row * tty->cols + col, (u16)tty->attr << 8 | ' ', tty->cols * (tty->rows - row) - col);
+									ttybios_fill(tty, row * tty->cols + col, (u16)tty->attr << 8 | ' ', tty->cols * (tty->rows - row) - col);
 									break;
 
 								case 1:
-									ttybios_memset(tty->vram, (u16)tty->attr << 8 | ' ', row * tty->cols + col + 1);
+									ttybios_fill(tty, 0, (u16)tty->attr << 8 | ' ', row * tty->cols + col + 1);
 									break;
 
 								case 2:
-									ttybios_memset(tty->vram, (u16)tty->attr << 8 | ' ', tty->rows * tty->cols);
+									ttybios_fill(tty, 0, (u16)tty->attr << 8 | ' ', tty->rows * tty->cols);
 									break;
 							}
 							tty->esc = esc_init;
@@ -450,22 +533,14 @@ static ssize_t ttybios_write(unsigned int minor, addr_t offs, const void *buff,
 
 		/* Scroll down */
 		if (row == tty->rows) {
-			i = tty->cols * (tty->rows - 1);
-			ttybios_memmove(tty->vram, tty->vram + tty->cols, i);
-			ttybios_memset(tty->vram + i, (u16)tty->attr << 8 | ' ', tty->cols);
+			ttybios_scroll(tty);
 			row--;
 			col = 0;
 		}
-
-		/* Update cursor */
-		i = row * tty->cols + col;
-		hal_outb(tty->crtc, 0x0e);
-		hal_outb(tty->crtc + 1, i >> 8);
-		hal_outb(tty->crtc, 0x0f);
-		hal_outb(tty->crtc + 1, i);
-		*((u8 *)(tty->vram + i) + 1) = tty->attr;
 	}
 
+	ttybios_flush(tty, row, col);
+
 	return len;
 }
 
@@ -518,11 +593,14 @@ static int ttybios_init(unsigned int minor)
 	tty->crtc = (u16)(color ? 0x3d4 : 0x3b4);
 
 	/* Default 80x25 text mode with magenta color attribute */
-	tty->rows = 25;
-	tty->cols = 80;
+	tty->rows = TTYBIOS_ROWS;
+	tty->cols = TTYBIOS_COLS;
 	tty->attr = 0x05;
 	tty->ekey = NULL;
 
+	/* Shadow is loaded from the screen on the first write */
+	tty->pos = (unsigned int)-1;
+
 	return EOK;
 }
 
@@ -134,6 +134,7 @@ __attribute__((constructor)) static void uart_reg(void)
 
 	static const dev_t devSpikeTTY = {
 		.name = "tty-spike",
+		.compatible = NULL, /* I/O goes through SBI calls, always available */
 		.init = uart_init,
 		.done = uart_done,
 		.ops = &opsSpikeTTY,
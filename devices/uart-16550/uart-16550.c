@@ -15,6 +15,7 @@
  */
 
 #include <devices/devs.h>
+#include <devices/uartcore.h>
 #include <hal/hal.h>
 #include <lib/lib.h>
 
@@ -22,20 +23,23 @@
 #include "uart-16550.h"
 
 
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x800
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x800
+#endif
+
+
 typedef struct {
+	uartcore_t core; /* Must be the first member */
 	unsigned char hwctx[SIZE_UARTHW_CTX];
 	unsigned char active;
 
-	/* Receiver */
-	unsigned char rx[SIZE_RX];
-	volatile unsigned int rh;
-	volatile unsigned int rt;
-
-	/* Transmitter */
-	unsigned char tx[SIZE_TX];
-	volatile unsigned int th;
-	volatile unsigned int tt;
-	volatile unsigned char tf;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -88,6 +92,27 @@ static uart_t *uart_get(unsigned int minor)
 }
 
 
+static void uart_txFill(uartcore_t *core)
+{
+	uart_t *uart = (uart_t *)core;
+	unsigned int i;
+	u8 c;
+
+	/* Refill transmitter FIFO once it's empty */
+	if ((uarthw_read(uart->hwctx, lsr) & 0x20) != 0) {
+		for (i = 0; i < SIZE_FIFO; ++i) {
+			if (uartcore_txGet(core, &c) == 0) {
+				break;
+			}
+			uarthw_write(uart->hwctx, thr, c);
+		}
+	}
+
+	/* Keep THR empty interrupt enabled only while there is data to send */
+	uarthw_write(uart->hwctx, ier, (lib_cbufEmpty(&core->tx) != 0) ? 0x01 : 0x03);
+}
+
+
 static int uart_isr(unsigned int irq, void *arg)
 {
 	uart_t *uart = (uart_t *)arg;
@@ -97,25 +122,15 @@ static int uart_isr(unsigned int irq, void *arg)
 		if ((isr = uarthw_read(uart->hwctx, iir)) & 0x01)
 			break;
 
-		/* Receive */
+		/* Receive (FIFO trigger level or character timeout) */
 		if (isr & 0x04) {
-			while (uarthw_read(uart->hwctx, lsr) & 0x01) {
-				uart->rx[uart->rh] = uarthw_read(uart->hwctx, rbr);
-				if ((uart->rh = (++uart->rh % SIZE_RX)) == uart->rt)
-					uart->rt = (++uart->rt % SIZE_RX);
-			}
+			while (uarthw_read(uart->hwctx, lsr) & 0x01)
+				uartcore_rxPut(&uart->core, uarthw_read(uart->hwctx, rbr));
 		}
 
 		/* Transmit */
-		if (isr & 0x02) {
-			if ((uart->th = (++uart->th % SIZE_TX)) != uart->tt)
-				uarthw_write(uart->hwctx, thr, uart->tx[uart->th]);
-			else
-				uarthw_write(uart->hwctx, ier, 0x01);
-
-			/* TX buffer not full */
-			uart->tf = 0;
-		}
+		if (isr & 0x02)
+			uart_txFill(&uart->core);
 	}
 
 	return EOK;
@@ -125,100 +140,29 @@ static int uart_isr(unsigned int irq, void *arg)
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
 	uart_t *uart;
-	time_t start;
-	unsigned int l;
 
 	if ((uart = uart_get(minor)) == NULL)
 		return -EINVAL;
 
-	if (!len)
-		return 0;
-
-	start = hal_timerGet();
-	while (uart->rh == uart->rt) {
-		if (hal_timerGet() - start >= timeout)
-			return -ETIME;
-	}
-
-	hal_interruptsDisableAll();
-
-	l = (uart->rh > uart->rt) ? min(uart->rh - uart->rt, len) : min(SIZE_RX - uart->rt, len);
-	hal_memcpy(buff, &uart->rx[uart->rt], l);
-
-	if ((l < len) && (uart->rh < uart->rt)) {
-		hal_memcpy((char *)buff + l, uart->rx, min(len - l, uart->rh));
-		l += min(len - l, uart->rh);
-	}
-	uart->rt = (uart->rt + l) % SIZE_RX;
-
-	hal_interruptsEnableAll();
-
-	return l;
+	return uartcore_read(&uart->core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
 	uart_t *uart;
-	unsigned int l;
 
 	if ((uart = uart_get(minor)) == NULL)
 		return -EINVAL;
 
-	if (!len)
-		return 0;
-
-	/* Wait while TX buffer is full */
-	while (uart->tf)
-		;
-
-	hal_interruptsDisableAll();
-
-	l = (uart->th > uart->tt) ? min(uart->th - uart->tt, len) : min(SIZE_TX - uart->tt, len);
-	hal_memcpy(&uart->tx[uart->tt], buff, l);
-
-	if ((l < len) && (uart->tt >= uart->th)) {
-		hal_memcpy(uart->tx, (const char *)buff + l, min(len - l, uart->th));
-		l += min(len - l, uart->th);
-	}
-
-	/* Initialize sending process if TX buffer was empty */
-	if (uart->tt == uart->th) {
-		uarthw_write(uart->hwctx, thr, uart->tx[uart->th]);
-		uarthw_write(uart->hwctx, ier, 0x03);
-	}
-
-	/* Check if TX buffer is full */
-	if ((uart->tt = (uart->tt + l) % SIZE_TX) == uart->th)
-		uart->tf = 1;
-
-	hal_interruptsEnableAll();
-
-	return l;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res;
-	size_t l;
-
-	for (l = 0; l < len; l += res) {
-		if ((res = uart_write(minor, (const char *)buff + l, len - l)) < 0)
-			return res;
-	}
-
-	return len;
+	return uartcore_write(&uart->core, buff, len);
 }
 
 
 static int _uart_sync(uart_t *uart)
 {
 	/* Wait until TX buffer is empty */
-	while (uart->tf)
-		;
-	while (uart->tt != uart->th)
-		;
+	uartcore_txDrain(&uart->core);
 
 	/* Wait for transmission to complete */
 	while (!(uarthw_read(uart->hwctx, lsr) & 0x40))
@@ -299,6 +243,8 @@ static int uart_init(unsigned int minor)
 		return -ENODEV;
 	uart->active = 1;
 
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
+
 	/* Disable all interrupts */
 	uarthw_write(uart->hwctx, ier, 0x00);
 
@@ -318,7 +264,7 @@ static int uart_init(unsigned int minor)
 	/* Set data format */
 	uarthw_write(uart->hwctx, lcr, 0x03);
 
-	/* Enable and configure FIFOs */
+	/* Enable FIFOs, RX trigger level at 8 bytes (character timeout interrupt flushes the rest) */
 	uarthw_write(uart->hwctx, fcr, 0xa7);
 
 	/* Enable hardware interrupts */
@@ -335,14 +281,17 @@ __attribute__((constructor)) static void uart_register(void)
 {
 	static const dev_ops_t opsUart16550 = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
 	};
 
+	static const char *const compatUart16550[] = { "ns16550a", "ns16550", NULL };
+
 	static const dev_t devUart16550 = {
 		.name = "uart-16550",
+		.compatible = compatUart16550,
 		.init = uart_init,
 		.done = uart_done,
 		.ops = &opsUart16550,
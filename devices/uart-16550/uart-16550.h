@@ -18,9 +18,8 @@
 #define _DEV_UART16550_H_
 
 
-/* Receiver and transmitter buffer size */
-#define SIZE_RX 0x800
-#define SIZE_TX 0x800
+/* Transmitter FIFO depth */
+#define SIZE_FIFO 16
 
 
 /* UART 16550 registers */
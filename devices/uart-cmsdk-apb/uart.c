@@ -16,9 +16,14 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
 
 
-#define BUFFER_SIZE 0x200
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x200
+#endif
+
 
 #define UART_ACTIVE_CNT (UART0_ACTIVE + UART1_ACTIVE + UART2_ACTIVE + UART3_ACTIVE + UART4_ACTIVE + UART5_ACTIVE)
 
@@ -48,12 +53,12 @@ typedef struct {
 	const unsigned int rxirq;
 	const unsigned int active;
 
-	cbuffer_t cbuffRx;
+	uartcore_t core;
 } uart_t;
 
 
 static struct {
-	u8 dataRx[UART_ACTIVE_CNT][BUFFER_SIZE];
+	u8 dataRx[UART_ACTIVE_CNT][UART_RXBUF_SIZE];
 	uart_t uarts[UART_MAX_CNT];
 } uart_common = {
 	.uarts = {
@@ -69,11 +74,8 @@ static struct {
 
 static inline void uart_rxData(uart_t *uart)
 {
-	u8 c;
-
 	while ((*(uart->base + state) & RX_BUF_FULL) != 0) {
-		c = *(uart->base + data) & 0xff;
-		lib_cbufWrite(&uart->cbuffRx, &c, 1);
+		uartcore_rxPut(&uart->core, *(uart->base + data) & 0xff);
 	}
 	*(uart->base + intstatus) = RX_INT;
 }
@@ -109,7 +111,6 @@ static int uart_irqHandler(unsigned int n, void *data)
 
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
-	ssize_t res;
 	uart_t *uart;
 	time_t start;
 
@@ -123,18 +124,16 @@ static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len
 		return -ENOSYS;
 	}
 
+	/* Sleep until data arrives */
 	start = hal_timerGet();
-	while (lib_cbufEmpty(&uart->cbuffRx) != 0) {
+	while (lib_cbufEmpty(&uart->core.rx) != 0) {
 		if (hal_timerGet() - start > timeout) {
 			return -ETIME;
 		}
 		hal_cpuHalt();
 	}
-	hal_interruptsDisableAll();
-	res = lib_cbufRead(&uart->cbuffRx, buff, len);
-	hal_interruptsEnableAll();
 
-	return res;
+	return uartcore_read(&uart->core, buff, len, 0);
 }
 
 
@@ -270,7 +269,8 @@ static int uart_init(unsigned int minor)
 
 	buf = uart_common.dataRx[uart_getActiveIdx(minor)];
 
-	lib_cbufInit(&uart->cbuffRx, buf, BUFFER_SIZE);
+	/* No hardware FIFO and separate TX irq line - transmit directly */
+	uartcore_init(&uart->core, buf, UART_RXBUF_SIZE, NULL, 0, NULL);
 
 	*(uart->base + bauddiv) = SYSCLK_FREQ / UART_BAUDRATE;
 	hal_cpuDataSyncBarrier();
@@ -16,18 +16,28 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
 
 
-#define BUFFER_SIZE 0x200
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x200
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x40
+#endif
+
 
 /* UART control bits */
-#define RX_FIFO_INT (1 << 10)
-#define TX_FIFO_INT (1 << 9)
-#define PARITY_EN   (1 << 5)
-#define TX_INT      (1 << 3)
-#define RX_INT      (1 << 2)
-#define TX_EN       (1 << 1)
-#define RX_EN       (1 << 0)
+#define RX_DELAY_INT (1 << 13)
+#define RX_FIFO_INT  (1 << 10)
+#define TX_FIFO_INT  (1 << 9)
+#define PARITY_EN    (1 << 5)
+#define TX_INT       (1 << 3)
+#define RX_INT       (1 << 2)
+#define TX_EN        (1 << 1)
+#define RX_EN        (1 << 0)
 
 /* UART status bits */
 #define RX_FIFO_FULL  (1 << 10)
@@ -48,12 +58,14 @@ enum {
 
 
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile u32 *base;
 	unsigned int irq;
 	u16 clk;
 
-	u8 dataRx[BUFFER_SIZE];
-	cbuffer_t cbuffRx;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -180,26 +192,29 @@ static void uart_iomuxCfg(unsigned int minor)
 
 __attribute__((section(".noxip"))) static inline void uart_rxData(uart_t *uart)
 {
-	char c;
 	/* Keep getting data until rx fifo is not empty */
 	while ((*(uart->base + uart_status) & DATA_READY) != 0) {
-		c = *(uart->base + uart_data) & 0xff;
-		lib_cbufWriteByte(&uart->cbuffRx, c);
+		uartcore_rxPut(&uart->core, *(uart->base + uart_data) & 0xff);
 	}
 }
 
 
-static inline void uart_txData(uart_t *uart, const void *buff, size_t len)
+__attribute__((section(".noxip"))) static void uart_txFill(uartcore_t *core)
 {
-	size_t i;
-	const char *c = buff;
-
-	for (i = 0; i < len; i++) {
-		/* Fill until tx fifo is not full */
-		while ((*(uart->base + uart_status) & TX_FIFO_FULL) != 0) {
+	uart_t *uart = (uart_t *)core;
+	u8 c;
+
+	/* Fill until tx fifo is not full */
+	while ((*(uart->base + uart_status) & TX_FIFO_FULL) == 0) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TX interrupt */
+			*(uart->base + uart_ctrl) &= ~TX_INT;
+			return;
 		}
-		*(uart->base + uart_data) = c[i];
+		*(uart->base + uart_data) = c;
 	}
+
+	*(uart->base + uart_ctrl) |= TX_INT;
 }
 
 
@@ -212,6 +227,10 @@ __attribute__((section(".noxip"))) static int uart_irqHandler(unsigned int n, vo
 		uart_rxData(uart);
 	}
 
+	if ((*(uart->base + uart_ctrl) & TX_INT) != 0) {
+		uart_txFill(&uart->core);
+	}
+
 	return 0;
 }
 
@@ -232,10 +251,6 @@ static u32 uart_calcScaler(u32 baud)
 
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
-	ssize_t res;
-	uart_t *uart;
-	time_t start;
-
 	if (minor >= UART_MAX_CNT) {
 		return -EINVAL;
 	}
@@ -244,25 +259,12 @@ static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len
 		return -ENOSYS;
 	}
 
-	uart = &uart_common.uarts[minor];
-	start = hal_timerGet();
-	while (lib_cbufEmpty(&uart->cbuffRx) != 0) {
-		if (hal_timerGet() - start > timeout) {
-			return -ETIME;
-		}
-	}
-	hal_interruptsDisableAll();
-	res = lib_cbufRead(&uart->cbuffRx, buff, len);
-	hal_interruptsEnableAll();
-
-	return res;
+	return uartcore_read(&uart_common.uarts[minor].core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
-	uart_t *uart;
-
 	if (minor >= UART_MAX_CNT) {
 		return -EINVAL;
 	}
@@ -271,28 +273,7 @@ static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
 		return -ENOSYS;
 	}
 
-	uart = &uart_common.uarts[minor];
-
-	uart_txData(uart, buff, len);
-
-	return len;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res = 0;
-	size_t wrote = 0;
-
-	while (wrote < len) {
-		res = uart_write(minor, buff + wrote, len - wrote);
-		if (res < 0) {
-			return -ENXIO;
-		}
-		wrote += res;
-	}
-
-	return len;
+	return uartcore_write(&uart_common.uarts[minor].core, buff, len);
 }
 
 
@@ -310,6 +291,8 @@ static int uart_sync(unsigned int minor)
 
 	uart = &uart_common.uarts[minor];
 
+	uartcore_txDrain(&uart->core);
+
 	/* Wait until Tx shift register is empty */
 	while ((*(uart->base + uart_status) & TX_SR_EMPTY) == 0) {
 	}
@@ -396,15 +379,15 @@ static int uart_init(unsigned int minor)
 
 	uart_iomuxCfg(minor);
 
-	lib_cbufInit(&uart->cbuffRx, uart->dataRx, BUFFER_SIZE);
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 	hal_interruptsSet(uart->irq, uart_irqHandler, (void *)uart);
 
 	*(uart->base + uart_scaler) = uart_calcScaler(UART_BAUDRATE);
 	hal_cpuDataStoreBarrier();
 
 	/* UART control - clear everything and: enable 1 stop bit,
-	 * disable parity, enable RX interrupts, enable TX & RX */
-	*(uart->base + uart_ctrl) = RX_INT | TX_EN | RX_EN;
+	 * disable parity, enable RX FIFO half-full and delayed (idle line) RX interrupts, enable TX & RX */
+	*(uart->base + uart_ctrl) = RX_FIFO_INT | RX_DELAY_INT | RX_INT | TX_EN | RX_EN;
 
 	return EOK;
 }
@@ -414,13 +397,16 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartGRLIB = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.sync = uart_sync,
 		.map = uart_map,
 	};
 
+	static const char *const compatUartGRLIB[] = { "gaisler,apbuart", NULL };
+
 	static const dev_t devUartGRLIB = {
 		.name = "uart-grlib",
+		.compatible = compatUartGRLIB,
 		.init = uart_init,
 		.done = uart_done,
 		.ops = &opsUartGRLIB,
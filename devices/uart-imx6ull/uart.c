@@ -15,23 +15,36 @@
 
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
+
+
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x20
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x20
+#endif
 
 
 #define UARTS_MAX_CNT 8
-#define BUFFER_SIZE   0x20
 #define UART_REF_CLK  20000000
 
+/* RX/TX FIFO trigger levels (FIFOs are 32 characters deep) */
+#define RX_TRIG_LVL 16
+#define TX_TRIG_LVL 16
+
 
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile u32 *base;
 	unsigned int irq;
 	u16 clk;
 
-	u8 dataRx[BUFFER_SIZE];
-	cbuffer_t cbuffRx;
-
-	u8 dataTx[BUFFER_SIZE];
-	cbuffer_t cbuffTx;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -93,48 +106,49 @@ struct {
 
 static inline void uart_rxData(uart_t *uart)
 {
-	char c;
-
 	/* Keep getting data until fifo is not empty */
-	while (*(uart->base + usr2) & 0x1) {
-		c = *(uart->base + urxd);
-		lib_cbufWrite(&uart->cbuffRx, &c, 1);
-	}
+	while (*(uart->base + usr2) & 0x1)
+		uartcore_rxPut(&uart->core, *(uart->base + urxd));
+
+	/* Clear aging timer (idle line) flag */
+	*(uart->base + usr1) = 1 << 8;
 }
 
 
-static inline void uart_txData(uart_t *uart)
+static void uart_txFill(uartcore_t *core)
 {
-	char c;
-
-	while (!lib_cbufEmpty(&uart->cbuffTx)) {
-		if (!(*(uart->base + uts) & (0x1 << 4))) {
-			lib_cbufRead(&uart->cbuffTx, &c, 1);
-			*(uart->base + utxd) = c;
+	uart_t *uart = (uart_t *)core;
+	u8 c;
+
+	/* Keep filling until fifo is not full */
+	while (!(*(uart->base + uts) & (0x1 << 4))) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TX ready irq */
+			*(uart->base + ucr1) &= ~(1 << 13);
+			return;
 		}
+		*(uart->base + utxd) = c;
 	}
 
-	*(uart->base + ucr1) &= ~(1 << 6);
+	/* Enable TX ready irq (TX fifo below trigger level) */
+	*(uart->base + ucr1) |= 1 << 13;
 }
 
 
 static int uart_irqHandler(unsigned int n, void *data)
 {
-	u32 usr;
 	uart_t *uart = (uart_t *)data;
 
 	if (uart == NULL)
 		return 0;
 
-	usr = *(uart->base + usr2);
-
-	/* Rx fifo trigger irq */
-	if (usr & 0x1)
+	/* Rx fifo trigger or aging timer irq */
+	if ((*(uart->base + usr2) & 0x1) || (*(uart->base + usr1) & (1 << 8)))
 		uart_rxData(uart);
 
-	/* Tx fifo is empty */
-	if (usr & (1 << 14) && !lib_cbufEmpty(&uart->cbuffTx))
-		uart_txData(uart);
+	/* Tx fifo below trigger level */
+	if (*(uart->base + ucr1) & (1 << 13))
+		uart_txFill(&uart->core);
 
 	return 0;
 }
@@ -210,64 +224,19 @@ static int uart_calcBaudrate(uart_t *uart, int baudrate)
 
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
-	size_t res;
-	uart_t *uart;
-	time_t start;
-
 	if (minor >= UARTS_MAX_CNT)
 		return -EINVAL;
 
-	uart = &uart_common.uarts[minor];
-
-	start = hal_timerGet();
-	while (lib_cbufEmpty(&uart->cbuffRx)) {
-		if ((hal_timerGet() - start) >= timeout)
-			return -ETIME;
-	}
-
-	hal_interruptsDisable(info[minor].irq);
-	res = lib_cbufRead(&uart->cbuffRx, buff, len);
-	hal_interruptsEnable(info[minor].irq);
-
-	return res;
+	return uartcore_read(&uart_common.uarts[minor].core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
-	size_t res;
-	uart_t *uart;
-
 	if (minor >= UARTS_MAX_CNT)
 		return -EINVAL;
 
-	uart = &uart_common.uarts[minor];
-
-	while (uart->cbuffTx.full)
-		;
-
-	hal_interruptsDisable(info[minor].irq);
-	res = lib_cbufWrite(&uart->cbuffTx, buff, len);
-
-	/* Enable TX FIFO empty irq */
-	*(uart->base + ucr1) |= 1 << 6;
-	hal_interruptsEnable(info[minor].irq);
-
-	return res;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res;
-	size_t l;
-
-	for (l = 0; l < len; l += res) {
-		if ((res = uart_write(minor, (const char *)buff + l, len - l)) < 0)
-			return -ENXIO;
-	}
-
-	return len;
+	return uartcore_write(&uart_common.uarts[minor].core, buff, len);
 }
 
 
@@ -280,8 +249,7 @@ static int uart_sync(unsigned int minor)
 
 	uart = &uart_common.uarts[minor];
 
-	while (!lib_cbufEmpty(&uart->cbuffTx))
-		;
+	uartcore_txDrain(&uart->core);
 
 	/* Wait until TxFIFO is empty */
 	while (!(*(uart->base + uts) & (1 << 6)))
@@ -344,8 +312,7 @@ static int uart_init(unsigned int minor)
 	uart->clk = info[minor].clk;
 	uart->base = info[minor].base;
 
-	lib_cbufInit(&uart->cbuffTx, uart->dataTx, BUFFER_SIZE);
-	lib_cbufInit(&uart->cbuffRx, uart->dataRx, BUFFER_SIZE);
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 
 	if (!(*(uart->base + ucr1) & 0x1)) {
 		imx6ull_setDevClock(uart->clk, 3);
@@ -379,6 +346,12 @@ static int uart_init(unsigned int minor)
 
 	uart_calcBaudrate(uart, 115200);
 
+	/* Set RX & TX FIFO trigger levels */
+	*(uart->base + ufcr) = (*(uart->base + ufcr) & ~((0x3f << 10) | 0x3f)) | (TX_TRIG_LVL << 10) | RX_TRIG_LVL;
+
+	/* Enable aging timer - flushes RX fifo remainder below trigger level when line is idle */
+	*(uart->base + ucr2) |= 1 << 3;
+
 	/* 32 characters in the RxFIFO */
 	*(uart->base + ucr4) = 0x8000;
 	/* Enable uart and rx ready interrupt */
@@ -398,7 +371,7 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartIMX6ULL = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
@@ -18,26 +18,35 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
+
+
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x20
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x20
+#endif
+
 
 #define CONCATENATE(x, y) x##y
 #define PIN2MUX(x)        CONCATENATE(pctl_mux_gpio_, x)
 #define PIN2PAD(x)        CONCATENATE(pctl_pad_gpio_, x)
 
 
-#define BUFFER_SIZE 0x20
-
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile u32 *base;
 	unsigned int irq;
 
 	u16 rxFifoSz;
 	u16 txFifoSz;
 
-	u8 dataRx[BUFFER_SIZE];
-	cbuffer_t cbuffRx;
-
-	u8 dataTx[BUFFER_SIZE];
-	cbuffer_t cbuffTx;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -98,9 +107,26 @@ static uart_t *uart_getInstance(unsigned int minor)
 }
 
 
+__attribute__((section(".noxip"))) static void uart_txFill(uartcore_t *core)
+{
+	uart_t *uart = (uart_t *)core;
+	u8 c;
+
+	while (uart_getTXcount(uart) < uart->txFifoSz) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TX watermark interrupt */
+			*(uart->base + ctrlr) &= ~(1 << 23);
+			return;
+		}
+		*(uart->base + datar) = c;
+	}
+
+	*(uart->base + ctrlr) |= 1 << 23;
+}
+
+
 __attribute__((section(".noxip"))) static int uart_handleIntr(unsigned int irq, void *buff)
 {
-	char c;
 	u32 flags;
 	uart_t *uart = (uart_t *)buff;
 
@@ -117,21 +143,12 @@ __attribute__((section(".noxip"))) static int uart_handleIntr(unsigned int irq,
 	*(uart->base + statr) |= flags;
 
 	/* Receive */
-	while (uart_getRXcount(uart) != 0) {
-		c = *(uart->base + datar);
-		lib_cbufWriteByte(&uart->cbuffRx, c);
-	}
+	while (uart_getRXcount(uart) != 0)
+		uartcore_rxPut(&uart->core, *(uart->base + datar));
 
 	/* Transmit */
-	while (uart_getTXcount(uart) < uart->txFifoSz) {
-		if (lib_cbufReadByte(&uart->cbuffTx, &c) != 0) {
-			*(uart->base + datar) = c;
-		}
-		else {
-			*(uart->base + ctrlr) &= ~(1 << 23);
-			break;
-		}
-	}
+	if ((*(uart->base + ctrlr) & (1 << 23)) != 0)
+		uart_txFill(&uart->core);
 
 	return 0;
 }
@@ -430,59 +447,23 @@ static void uart_initPins(void)
 
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
-	size_t res;
 	uart_t *uart;
-	time_t start;
 
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	start = hal_timerGet();
-	while (lib_cbufEmpty(&uart->cbuffRx)) {
-		if ((hal_timerGet() - start) >= timeout)
-			return -ETIME;
-	}
-
-	hal_interruptsDisable(info[minor].irq);
-	res = lib_cbufRead(&uart->cbuffRx, buff, len);
-	hal_interruptsEnable(info[minor].irq);
-
-	return res;
+	return uartcore_read(&uart->core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
-	size_t res;
 	uart_t *uart;
 
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	while (uart->cbuffTx.full)
-		;
-
-	hal_interruptsDisable(info[minor].irq);
-	res = lib_cbufWrite(&uart->cbuffTx, buff, len);
-	*(uart->base + ctrlr) |= 1 << 23;
-
-	hal_interruptsEnable(info[minor].irq);
-
-	return res;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res;
-	size_t l;
-
-	for (l = 0; l < len; l += res) {
-		if ((res = uart_write(minor, (const char *)buff + l, len - l)) < 0)
-			return -ENXIO;
-	}
-
-	return len;
+	return uartcore_write(&uart->core, buff, len);
 }
 
 
@@ -493,8 +474,7 @@ static int uart_sync(unsigned int minor)
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	while (!lib_cbufEmpty(&uart->cbuffTx))
-		;
+	uartcore_txDrain(&uart->core);
 
 	/* Wait for transmission activity complete */
 	while ((*(uart->base + statr) & (1 << 22)) == 0)
@@ -566,8 +546,7 @@ static int uart_init(unsigned int minor)
 	}
 
 	uart->base = info[minor].base;
-	lib_cbufInit(&uart->cbuffTx, uart->dataTx, BUFFER_SIZE);
-	lib_cbufInit(&uart->cbuffRx, uart->dataRx, BUFFER_SIZE);
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 
 	_imxrt_ccmControlGate(info[minor].dev, clk_state_run_wait);
 
@@ -608,6 +587,12 @@ static int uart_init(unsigned int minor)
 	uart->rxFifoSz = fifoSzLut[*(uart->base + fifor) & 0x7];
 	uart->txFifoSz = fifoSzLut[(*(uart->base + fifor) >> 4) & 0x7];
 
+	/* RX watermark at 1/4 of the FIFO, TX watermark at half of the FIFO */
+	*(uart->base + waterr) = ((uart->rxFifoSz >> 2) << 16) | (uart->txFifoSz >> 1);
+
+	/* Flush RX FIFO remainder below watermark after the line stays idle for 1 character */
+	*(uart->base + fifor) = (*(uart->base + fifor) & ~(0x7 << 10)) | (1 << 10);
+
 	/* Enable overrun, noise, framing error and receiver interrupts */
 	*(uart->base + ctrlr) |= (1 << 27) | (1 << 26) | (1 << 25) | (1 << 21);
 
@@ -658,7 +643,7 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartIMXRT106X = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
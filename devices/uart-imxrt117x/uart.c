@@ -18,29 +18,34 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
+
+
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x200
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x200
+#endif
 
 
 #define CONCATENATE(x, y) x##y
 #define PIN2MUX(x)        CONCATENATE(pctl_mux_gpio_, x)
 #define PIN2PAD(x)        CONCATENATE(pctl_pad_gpio_, x)
 
-#define BUFFER_SIZE 0x200
-
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile u32 *base;
 	unsigned int irq;
 
 	u16 rxFifoSz;
 	u16 txFifoSz;
 
-	u8 rxBuff[BUFFER_SIZE];
-	volatile u16 rxHead;
-	volatile u16 rxTail;
-
-	u8 txBuff[BUFFER_SIZE];
-	volatile u16 txHead;
-	volatile u16 txTail;
-	volatile u8 tFull;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -102,6 +107,24 @@ __attribute__((section(".noxip"))) static int uart_getTXcount(uart_t *uart)
 }
 
 
+__attribute__((section(".noxip"))) static void uart_txFill(uartcore_t *core)
+{
+	uart_t *uart = (uart_t *)core;
+	u8 c;
+
+	while (uart_getTXcount(uart) < uart->txFifoSz) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TX watermark interrupt */
+			*(uart->base + ctrlr) &= ~(1 << 23);
+			return;
+		}
+		*(uart->base + datar) = c;
+	}
+
+	*(uart->base + ctrlr) |= 1 << 23;
+}
+
+
 __attribute__((section(".noxip"))) static int uart_handleIntr(unsigned int irq, void *buff)
 {
 	uart_t *uart = (uart_t *)buff;
@@ -110,26 +133,12 @@ __attribute__((section(".noxip"))) static int uart_handleIntr(unsigned int irq,
 		return 0;
 
 	/* Receive */
-	while (uart_getRXcount(uart)) {
-		uart->rxBuff[uart->rxHead] = *(uart->base + datar);
-		uart->rxHead = (uart->rxHead + 1) % BUFFER_SIZE;
-		if (uart->rxHead == uart->rxTail) {
-			uart->rxTail = (uart->rxTail + 1) % BUFFER_SIZE;
-		}
-	}
+	while (uart_getRXcount(uart))
+		uartcore_rxPut(&uart->core, *(uart->base + datar));
 
 	/* Transmit */
-	while (uart_getTXcount(uart) < uart->txFifoSz) {
-		if ((uart->txHead + 1) % BUFFER_SIZE != uart->txTail) {
-			uart->txHead = (uart->txHead + 1) % BUFFER_SIZE;
-			*(uart->base + datar) = uart->txBuff[uart->txHead];
-			uart->tFull = 0;
-		}
-		else {
-			*(uart->base + ctrlr) &= ~(1 << 23);
-			break;
-		}
-	}
+	if ((*(uart->base + ctrlr) & (1 << 23)) != 0)
+		uart_txFill(&uart->core);
 
 	return 0;
 }
@@ -454,90 +463,22 @@ static void uart_initPins(void)
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
 	uart_t *uart;
-	size_t l, cnt;
-	time_t start;
 
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	start = hal_timerGet();
-	while (uart->rxHead == uart->rxTail) {
-		if ((hal_timerGet() - start) >= timeout)
-			return -ETIME;
-	}
-	hal_interruptsDisable(infoUarts[minor].irq);
-
-	if (uart->rxHead > uart->rxTail)
-		l = min(uart->rxHead - uart->rxTail, len);
-	else
-		l = min(BUFFER_SIZE - uart->rxTail, len);
-
-	hal_memcpy(buff, &uart->rxBuff[uart->rxTail], l);
-	cnt = l;
-	if ((len > l) && (uart->rxHead < uart->rxTail)) {
-		hal_memcpy((char *)buff + l, &uart->rxBuff[0], min(len - l, uart->rxHead));
-		cnt += min(len - l, uart->rxHead);
-	}
-	uart->rxTail = ((uart->rxTail + cnt) % BUFFER_SIZE);
-
-	hal_interruptsEnable(infoUarts[minor].irq);
-
-	return cnt;
+	return uartcore_read(&uart->core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
 	uart_t *uart;
-	size_t l, cnt = 0;
 
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	while (uart->txHead == uart->txTail && uart->tFull)
-		;
-
-	hal_interruptsDisable(infoUarts[minor].irq);
-	if (uart->txHead > uart->txTail)
-		l = min(uart->txHead - uart->txTail, len);
-	else
-		l = min(BUFFER_SIZE - uart->txTail, len);
-
-	hal_memcpy(&uart->txBuff[uart->txTail], buff, l);
-	cnt = l;
-	if ((len > l) && (uart->txTail >= uart->txHead)) {
-		hal_memcpy(uart->txBuff, (const char *)buff + l, min(len - l, uart->txHead));
-		cnt += min(len - l, uart->txHead);
-	}
-
-	/* Initialize sending */
-	if (uart->txTail == uart->txHead)
-		*(uart->base + datar) = uart->txBuff[uart->txHead];
-
-	uart->txTail = ((uart->txTail + cnt) % BUFFER_SIZE);
-
-	if (uart->txTail == uart->txHead)
-		uart->tFull = 1;
-
-	*(uart->base + ctrlr) |= 1 << 23;
-
-	hal_interruptsEnable(infoUarts[minor].irq);
-
-	return cnt;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res;
-	size_t l;
-
-	for (l = 0; l < len; l += res) {
-		if ((res = uart_write(minor, (const char *)buff + l, len - l)) < 0)
-			return -ENXIO;
-	}
-
-	return len;
+	return uartcore_write(&uart->core, buff, len);
 }
 
 
@@ -548,7 +489,11 @@ static int uart_sync(unsigned int minor)
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	/* TBD */
+	uartcore_txDrain(&uart->core);
+
+	/* Wait for transmission activity complete */
+	while ((*(uart->base + statr) & (1 << 22)) == 0)
+		;
 
 	return EOK;
 }
@@ -561,9 +506,7 @@ static int uart_done(unsigned int minor)
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	/* Wait for transmission activity complete */
-	while ((*(uart->base + statr) & (1 << 22)) == 0)
-		;
+	uart_sync(minor);
 
 	/* disable TX and RX */
 	*(uart->base + ctrlr) &= ~((1 << 19) | (1 << 18));
@@ -603,6 +546,7 @@ static int uart_init(unsigned int minor)
 	}
 
 	uart->base = infoUarts[minor].base;
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 
 	_imxrt_setDevClock(infoUarts[minor].dev, 0, 0, 0, 0, 1);
 
@@ -643,6 +587,12 @@ static int uart_init(unsigned int minor)
 	uart->rxFifoSz = fifoSzLut[*(uart->base + fifor) & 0x7];
 	uart->txFifoSz = fifoSzLut[(*(uart->base + fifor) >> 4) & 0x7];
 
+	/* RX watermark at 1/4 of the FIFO, TX watermark at half of the FIFO */
+	*(uart->base + waterr) = ((uart->rxFifoSz >> 2) << 16) | (uart->txFifoSz >> 1);
+
+	/* Flush RX FIFO remainder below watermark after the line stays idle for 1 character */
+	*(uart->base + fifor) = (*(uart->base + fifor) & ~(0x7 << 10)) | (1 << 10);
+
 	/* Enable receiver interrupt */
 	*(uart->base + ctrlr) |= 1 << 21;
 
@@ -690,7 +640,7 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartIMXRT117X = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
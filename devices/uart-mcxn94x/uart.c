@@ -18,24 +18,30 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
+
+
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x200
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x200
+#endif
 
-#define BUFFER_SIZE 0x200
 
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile u32 *base;
 	unsigned int irq;
 
 	u16 rxFifoSz;
 	u16 txFifoSz;
 
-	u8 rxBuff[BUFFER_SIZE];
-	volatile u16 rxHead;
-	volatile u16 rxTail;
-
-	u8 txBuff[BUFFER_SIZE];
-	volatile u16 txHead;
-	volatile u16 txTail;
-	volatile u8 tFull;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -117,6 +123,24 @@ static int uart_getTXcount(uart_t *uart)
 }
 
 
+static void uart_txFill(uartcore_t *core)
+{
+	uart_t *uart = (uart_t *)core;
+	u8 c;
+
+	while (uart_getTXcount(uart) < uart->txFifoSz) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TX watermark interrupt */
+			*(uart->base + ctrlr) &= ~(1 << 23);
+			return;
+		}
+		*(uart->base + datar) = c;
+	}
+
+	*(uart->base + ctrlr) |= 1 << 23;
+}
+
+
 static int uart_handleIntr(unsigned int irq, void *buff)
 {
 	uart_t *uart = (uart_t *)buff;
@@ -127,24 +151,12 @@ static int uart_handleIntr(unsigned int irq, void *buff)
 
 	/* Receive */
 	while (uart_getRXcount(uart) != 0) {
-		uart->rxBuff[uart->rxHead] = *(uart->base + datar);
-		uart->rxHead = (uart->rxHead + 1) % BUFFER_SIZE;
-		if (uart->rxHead == uart->rxTail) {
-			uart->rxTail = (uart->rxTail + 1) % BUFFER_SIZE;
-		}
+		uartcore_rxPut(&uart->core, *(uart->base + datar));
 	}
 
 	/* Transmit */
-	while (uart_getTXcount(uart) < uart->txFifoSz) {
-		if ((uart->txHead + 1) % BUFFER_SIZE != uart->txTail) {
-			uart->txHead = (uart->txHead + 1) % BUFFER_SIZE;
-			*(uart->base + datar) = uart->txBuff[uart->txHead];
-			uart->tFull = 0;
-		}
-		else {
-			*(uart->base + ctrlr) &= ~(1 << 23);
-			break;
-		}
+	if ((*(uart->base + ctrlr) & (1 << 23)) != 0) {
+		uart_txFill(&uart->core);
 	}
 
 	return 0;
@@ -199,103 +211,26 @@ static void uart_initPins(unsigned int minor)
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
 	uart_t *uart;
-	size_t l, cnt;
-	time_t start;
 
 	uart = uart_getInstance(minor);
 	if (uart == NULL) {
 		return -EINVAL;
 	}
 
-	start = hal_timerGet();
-	while (uart->rxHead == uart->rxTail) {
-		if ((hal_timerGet() - start) >= timeout) {
-			return -ETIME;
-		}
-	}
-	hal_interruptsDisable(info[minor].irq);
-
-	if (uart->rxHead > uart->rxTail) {
-		l = min(uart->rxHead - uart->rxTail, len);
-	}
-	else {
-		l = min(BUFFER_SIZE - uart->rxTail, len);
-	}
-
-	hal_memcpy(buff, &uart->rxBuff[uart->rxTail], l);
-	cnt = l;
-	if ((len > l) && (uart->rxHead < uart->rxTail)) {
-		hal_memcpy((char *)buff + l, &uart->rxBuff[0], min(len - l, uart->rxHead));
-		cnt += min(len - l, uart->rxHead);
-	}
-	uart->rxTail = ((uart->rxTail + cnt) % BUFFER_SIZE);
-
-	hal_interruptsEnable(info[minor].irq);
-
-	return cnt;
+	return uartcore_read(&uart->core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
 	uart_t *uart;
-	size_t l, cnt = 0;
 
 	uart = uart_getInstance(minor);
 	if (uart == NULL) {
 		return -EINVAL;
 	}
 
-	while (uart->txHead == uart->txTail && uart->tFull) {
-	}
-
-	hal_interruptsDisable(info[minor].irq);
-	if (uart->txHead > uart->txTail) {
-		l = min(uart->txHead - uart->txTail, len);
-	}
-	else {
-		l = min(BUFFER_SIZE - uart->txTail, len);
-	}
-
-	hal_memcpy(&uart->txBuff[uart->txTail], buff, l);
-	cnt = l;
-	if ((len > l) && (uart->txTail >= uart->txHead)) {
-		hal_memcpy(uart->txBuff, (const char *)buff + l, min(len - l, uart->txHead));
-		cnt += min(len - l, uart->txHead);
-	}
-
-	/* Initialize sending */
-	if (uart->txTail == uart->txHead) {
-		*(uart->base + datar) = uart->txBuff[uart->txHead];
-	}
-
-	uart->txTail = ((uart->txTail + cnt) % BUFFER_SIZE);
-
-	if (uart->txTail == uart->txHead) {
-		uart->tFull = 1;
-	}
-
-	*(uart->base + ctrlr) |= 1 << 23;
-
-	hal_interruptsEnable(info[minor].irq);
-
-	return cnt;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res;
-	size_t l;
-
-	for (l = 0; l < len; l += res) {
-		res = uart_write(minor, (const char *)buff + l, len - l);
-		if (res < 0) {
-			return -ENXIO;
-		}
-	}
-
-	return len;
+	return uartcore_write(&uart->core, buff, len);
 }
 
 
@@ -308,6 +243,8 @@ static int uart_sync(unsigned int minor)
 		return -EINVAL;
 	}
 
+	uartcore_txDrain(&uart->core);
+
 	/* Wait for transmission activity complete */
 	while ((*(uart->base + statr) & (1 << 22)) == 0) {
 	}
@@ -372,6 +309,7 @@ static int uart_init(unsigned int minor)
 	}
 
 	uart->base = info[minor].base;
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 
 	/* Disable TX and RX */
 	*(uart->base + ctrlr) &= ~((1 << 19) | (1 << 18));
@@ -407,6 +345,12 @@ static int uart_init(unsigned int minor)
 	uart->rxFifoSz = fifoSzLut[*(uart->base + fifor) & 0x7];
 	uart->txFifoSz = fifoSzLut[(*(uart->base + fifor) >> 4) & 0x7];
 
+	/* RX watermark at 1/4 of the FIFO, TX watermark at half of the FIFO */
+	*(uart->base + waterr) = ((uart->rxFifoSz >> 2) << 16) | (uart->txFifoSz >> 1);
+
+	/* Flush RX FIFO remainder below watermark after the line stays idle for 1 character */
+	*(uart->base + fifor) = (*(uart->base + fifor) & ~(0x7 << 10)) | (1 << 10);
+
 	/* Enable receiver interrupt */
 	*(uart->base + ctrlr) |= 1 << 21;
 
@@ -423,7 +367,7 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartMCXN94X = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
@@ -17,13 +17,19 @@
 #include <lib/errno.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
 
 #include <board_config.h>
 
 
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x20
+#endif
+
+
 /* max value for uarte_txd_maxcnt register */
 #define TX_DMA_SIZE_MAX 8191
-#define BUFFER_SIZE     0x20
 
 
 typedef struct {
@@ -34,11 +40,8 @@ typedef struct {
 	volatile char *tx_dma;
 	volatile char *rx_dma;
 
-	u8 dataRx[BUFFER_SIZE];
-	cbuffer_t cbuffRx;
-
-	u8 dataTx[BUFFER_SIZE];
-	cbuffer_t cbuffTx;
+	uartcore_t core;
+	u8 rxBuf[UART_RXBUF_SIZE];
 } uart_t;
 
 
@@ -98,7 +101,6 @@ static uart_t *uart_getInstance(unsigned int minor)
 static int uart_handleIntr(unsigned int irq, void *buff)
 {
 	uart_t *uart = (uart_t *)buff;
-	char temp;
 
 	if (uart == NULL) {
 		return -EINVAL;
@@ -109,8 +111,7 @@ static int uart_handleIntr(unsigned int irq, void *buff)
 		*(uart->base + uarte_events_rxdrdy) = 0u;
 
 		if (uart->cnt < UART_RX_DMA_SIZE) {
-			temp = *(uart->rx_dma + uart->cnt);
-			lib_cbufWrite(&uart->cbuffRx, &temp, 1);
+			uartcore_rxPut(&uart->core, *(uart->rx_dma + uart->cnt));
 			uart->cnt++;
 		}
 	}
@@ -129,27 +130,14 @@ static int uart_handleIntr(unsigned int irq, void *buff)
 
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
-	size_t res;
 	uart_t *uart;
-	time_t start;
 
 	uart = uart_getInstance(minor);
 	if (uart == NULL) {
 		return -EINVAL;
 	}
 
-	start = hal_timerGet();
-	while (lib_cbufEmpty(&uart->cbuffRx)) {
-		if ((hal_timerGet() - start) >= timeout) {
-			return -ETIME;
-		}
-	}
-
-	hal_interruptsDisable(uartInfo[minor].irq);
-	res = lib_cbufRead(&uart->cbuffRx, buff, len);
-	hal_interruptsEnable(uartInfo[minor].irq);
-
-	return res;
+	return uartcore_read(&uart->core, buff, len, timeout);
 }
 
 
@@ -201,10 +189,6 @@ static int uart_sync(unsigned int minor)
 		return -EINVAL;
 	}
 
-	while (!lib_cbufEmpty(&uart->cbuffTx)) {
-		;
-	}
-
 	/* endtx flag is asserted in uart_send so mustn't be checked here */
 
 	return EOK;
@@ -351,8 +335,8 @@ static int uart_init(unsigned int minor)
 	*(uart->base + uarte_intenset) = 0x14u;
 	hal_cpuDataMemoryBarrier();
 
-	lib_cbufInit(&uart->cbuffTx, uart->dataTx, BUFFER_SIZE);
-	lib_cbufInit(&uart->cbuffRx, uart->dataRx, BUFFER_SIZE);
+	/* Transmission goes directly through EasyDMA */
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), NULL, 0, NULL);
 
 	/* Enable uarte instance */
 	*(uart->base + uarte_enable) = 0x8u;
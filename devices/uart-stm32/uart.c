@@ -19,14 +19,26 @@
 #include <lib/errno.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
+
+
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x80
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x40
+#endif
 
 
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile unsigned int *base;
-	volatile unsigned char rxdfifo[128];
-	volatile unsigned int rxdr;
-	volatile unsigned int rxdw;
-	volatile int rxflag;
+
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -121,6 +133,24 @@ static uart_t *uart_getInstance(unsigned int minor)
 }
 
 
+static void uart_txFill(uartcore_t *core)
+{
+	uart_t *uart = (uart_t *)core;
+	u8 c;
+
+	while (*(uart->base + isr) & 0x80) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TXE interrupt */
+			*(uart->base + cr1) &= ~(1 << 7);
+			return;
+		}
+		*(uart->base + tdr) = c;
+	}
+
+	*(uart->base + cr1) |= 1 << 7;
+}
+
+
 static int uart_handleIntr(unsigned int irq, void *buff)
 {
 	uart_t *uart = (uart_t *)buff;
@@ -130,15 +160,13 @@ static int uart_handleIntr(unsigned int irq, void *buff)
 		*(uart->base + icr) |= (1 << 3);
 
 		/* Rxd buffer not empty */
-		uart->rxdfifo[uart->rxdw++] = *(uart->base + rdr);
-		uart->rxdw %= sizeof(uart->rxdfifo);
-
-		if (uart->rxdr == uart->rxdw)
-			uart->rxdr = (uart->rxdr + 1) % sizeof(uart->rxdfifo);
-
-		uart->rxflag = 1;
+		uartcore_rxPut(&uart->core, *(uart->base + rdr));
 	}
 
+	/* Txd buffer empty */
+	if (*(uart->base + cr1) & (1 << 7))
+		uart_txFill(&uart->core);
+
 	return 0;
 }
 
@@ -147,58 +175,22 @@ static int uart_handleIntr(unsigned int irq, void *buff)
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
 	uart_t *uart;
-	size_t cnt;
-	time_t start;
 
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	if (len == 0)
-		return 0;
-
-	hal_interruptsDisable(uartInfo[minor].irq);
-	for (cnt = 0; cnt < len; ++cnt) {
-		uart->rxflag = 0;
-		if (uart->rxdr == uart->rxdw) {
-			hal_interruptsEnable(uartInfo[minor].irq);
-			start = hal_timerGet();
-			while (!uart->rxflag) {
-				if ((hal_timerGet() - start) >= timeout)
-					return -ETIME;
-			}
-			hal_interruptsDisable(uartInfo[minor].irq);
-		}
-		((unsigned char *)buff)[cnt] = uart->rxdfifo[uart->rxdr++];
-		uart->rxdr %= sizeof(uart->rxdfifo);
-	}
-	hal_interruptsEnable(uartInfo[minor].irq);
-
-	return (ssize_t)cnt;
+	return uartcore_read(&uart->core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
 	uart_t *uart;
-	size_t cnt;
 
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
-	for (cnt = 0; cnt < len; ++cnt) {
-		while (!(*(uart->base + isr) & 0x80))
-			;
-
-		*(uart->base + tdr) = ((const unsigned char *)buff)[cnt];
-	}
-
-	return (ssize_t)cnt;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	return uart_write(minor, buff, len);
+	return uartcore_write(&uart->core, buff, len);
 }
 
 
@@ -209,6 +201,8 @@ static int uart_sync(unsigned int minor)
 	if ((uart = uart_getInstance(minor)) == NULL)
 		return -EINVAL;
 
+	uartcore_txDrain(&uart->core);
+
 	while (!(*(uart->base + isr) & 0x40))
 		;
 
@@ -292,9 +286,7 @@ static int uart_init(unsigned int minor)
 	br_divider = uart_configureRefclk(minor) / UART_BAUDRATE;
 	_stm32_rccSetDevClock(uartInfo[minor].dev, 1);
 
-	uart->rxdr = 0;
-	uart->rxdw = 0;
-	uart->rxflag = 0;
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 
 	*(uart->base + cr1) = 0;
 	hal_cpuDataMemoryBarrier();
@@ -320,7 +312,7 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartSTM32 = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
@@ -16,27 +16,40 @@
 #include <hal/hal.h>
 #include <lib/lib.h>
 #include <devices/devs.h>
+#include <devices/uartcore.h>
 
 #include <board_config.h>
 
+
+/* Ring sizes, can be overridden per board */
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE 0x200
+#endif
+
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE 0x200
+#endif
+
+
 #ifndef UART_CONSOLE_ROUTED_VIA_PL
 #define UART_CONSOLE_ROUTED_VIA_PL 0
 #endif
 
 #define MAX_TXRX_FIFO_SIZE 0x40
-#define BUFFER_SIZE        0x200
+
+/* RX timeout in 4 x bit periods (~4 characters) */
+#define RX_TIMEOUT 10
 
 typedef struct {
+	uartcore_t core; /* Must be the first member */
+
 	volatile u32 *base;
 	unsigned int irq;
 	int reset;
 	u16 clk;
 
-	u8 dataRx[BUFFER_SIZE];
-	cbuffer_t cbuffRx;
-
-	u8 dataTx[BUFFER_SIZE];
-	cbuffer_t cbuffTx;
+	u8 rxBuf[UART_RXBUF_SIZE];
+	u8 txBuf[UART_TXBUF_SIZE];
 } uart_t;
 
 
@@ -84,28 +97,32 @@ const struct {
 
 static inline void uart_rxData(uart_t *uart)
 {
-	char c;
 	/* Keep getting data until fifo is not empty */
-	while (!(*(uart->base + sr) & (0x1 << 1))) {
-		c = *(uart->base + fifo) & 0xff;
-		lib_cbufWrite(&uart->cbuffRx, &c, 1);
-	}
+	while (!(*(uart->base + sr) & (0x1 << 1)))
+		uartcore_rxPut(&uart->core, *(uart->base + fifo) & 0xff);
 
-	*(uart->base + isr) = 0x1;
+	*(uart->base + isr) = (1 << 8) | 0x1;
 }
 
 
-static inline void uart_txData(uart_t *uart)
+static void uart_txFill(uartcore_t *core)
 {
-	char c;
+	uart_t *uart = (uart_t *)core;
+	u8 c;
 
 	/* Keep filling until fifo is not full */
-	while (!lib_cbufEmpty(&uart->cbuffTx)) {
-		if (!(*(uart->base + sr) & (0x1 << 4))) {
-			lib_cbufRead(&uart->cbuffTx, &c, 1);
-			*(uart->base + fifo) = c;
+	while (!(*(uart->base + sr) & (0x1 << 4))) {
+		if (uartcore_txGet(core, &c) == 0) {
+			/* Nothing left to send, disable TX FIFO empty irq */
+			*(uart->base + idr) = 1 << 3;
+			return;
 		}
+		*(uart->base + fifo) = c;
 	}
+
+	/* Enable TX FIFO empty irq */
+	*(uart->base + isr) = 1 << 3;
+	*(uart->base + ier) = 1 << 3;
 }
 
 
@@ -117,12 +134,18 @@ static int uart_irqHandler(unsigned int n, void *data)
 	if (uart == NULL)
 		return 0;
 
-	st = *(uart->base + isr);
+	st = *(uart->base + isr) & *(uart->base + imr);
 
-	/* RX FIFO trigger irq */
-	if (st & 0x1)
+	/* RX FIFO trigger or RX timeout irq */
+	if (st & ((1 << 8) | 0x1))
 		uart_rxData(uart);
 
+	/* TX FIFO empty irq */
+	if (st & (1 << 3)) {
+		*(uart->base + isr) = 1 << 3;
+		uart_txFill(&uart->core);
+	}
+
 	return 0;
 }
 
@@ -268,65 +291,19 @@ static void uart_initCtrlClock(void)
 
 static ssize_t uart_read(unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
 {
-	size_t res;
-	uart_t *uart;
-	time_t start;
-
 	if (minor >= UARTS_MAX_CNT)
 		return -EINVAL;
 
-	uart = &uart_common.uarts[minor];
-
-	start = hal_timerGet();
-	while (lib_cbufEmpty(&uart->cbuffRx)) {
-		if ((hal_timerGet() - start) >= timeout)
-			return -ETIME;
-	}
-
-	hal_interruptsDisable(info[minor].irq);
-	res = lib_cbufRead(&uart->cbuffRx, buff, len);
-	hal_interruptsEnable(info[minor].irq);
-
-	return res;
+	return uartcore_read(&uart_common.uarts[minor].core, buff, len, timeout);
 }
 
 
-static ssize_t uart_write(unsigned int minor, const void *buff, size_t len)
+static ssize_t uart_write(unsigned int minor, addr_t offs, const void *buff, size_t len)
 {
-	size_t res;
-	uart_t *uart;
-
 	if (minor >= UARTS_MAX_CNT)
 		return -EINVAL;
 
-	uart = &uart_common.uarts[minor];
-
-	while (uart->cbuffTx.full)
-		;
-
-	hal_interruptsDisable(info[minor].irq);
-	res = lib_cbufWrite(&uart->cbuffTx, buff, len);
-	hal_interruptsEnable(info[minor].irq);
-
-	if (res > 0) {
-		uart_txData(uart);
-	}
-
-	return res;
-}
-
-
-static ssize_t uart_safeWrite(unsigned int minor, addr_t offs, const void *buff, size_t len)
-{
-	ssize_t res;
-	size_t l;
-
-	for (l = 0; l < len; l += res) {
-		if ((res = uart_write(minor, (const char *)buff + l, len - l)) < 0)
-			return -ENXIO;
-	}
-
-	return len;
+	return uartcore_write(&uart_common.uarts[minor].core, buff, len);
 }
 
 
@@ -340,8 +317,7 @@ static int uart_sync(unsigned int minor)
 
 	uart = &uart_common.uarts[minor];
 
-	while (!lib_cbufEmpty(&uart->cbuffTx))
-		;
+	uartcore_txDrain(&uart->core);
 
 	/* Wait until TxFIFO is empty */
 	while (!(*(uart->base + sr) & (0x1 << 3)))
@@ -429,8 +405,7 @@ static int uart_init(unsigned int minor)
 #endif
 	uart->base = info[minor].base;
 
-	lib_cbufInit(&uart->cbuffTx, uart->dataTx, BUFFER_SIZE);
-	lib_cbufInit(&uart->cbuffRx, uart->dataRx, BUFFER_SIZE);
+	uartcore_init(&uart->core, uart->rxBuf, sizeof(uart->rxBuf), uart->txBuf, sizeof(uart->txBuf), uart_txFill);
 
 	/* Skip controller initialization if it has been already done by hal */
 	if (!(*(uart->base + cr) & (1 << 4 | 1 << 2))) {
@@ -476,10 +451,12 @@ static int uart_init(unsigned int minor)
 	};
 #endif
 
-	/* Enable RX FIFO trigger */
-	*(uart->base + ier) |= 0x1;
-	/* Set trigger level, range: 1-63 */
-	*(uart->base + rxwm) = 1;
+	/* Set trigger level at half of the FIFO, range: 1-63 */
+	*(uart->base + rxwm) = MAX_TXRX_FIFO_SIZE / 2;
+	/* Flush FIFO remainder below trigger level after the line stays idle */
+	*(uart->base + rxtout) = RX_TIMEOUT;
+	/* Enable RX FIFO trigger and RX timeout */
+	*(uart->base + ier) = (1 << 8) | 0x1;
 
 	lib_printf("\ndev/uart: Initializing uart(%d.%d)", DEV_UART, minor);
 	hal_interruptsSet(info[minor].irq, uart_irqHandler, (void *)uart);
@@ -492,7 +469,7 @@ __attribute__((constructor)) static void uart_reg(void)
 {
 	static const dev_ops_t opsUartZynq = {
 		.read = uart_read,
-		.write = uart_safeWrite,
+		.write = uart_write,
 		.erase = NULL,
 		.sync = uart_sync,
 		.map = uart_map,
@@ -0,0 +1,96 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * UART common core
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "uartcore.h"
+
+#include <lib/errno.h>
+
+
+__attribute__((section(".noxip"))) int uartcore_rxPut(uartcore_t *core, u8 c)
+{
+	if (lib_cbufWriteByte(&core->rx, (char)c) == 0) {
+		core->rxOverrun++;
+		return 0;
+	}
+
+	return 1;
+}
+
+
+__attribute__((section(".noxip"))) int uartcore_txGet(uartcore_t *core, u8 *c)
+{
+	return lib_cbufReadByte(&core->tx, (char *)c);
+}
+
+
+ssize_t uartcore_read(uartcore_t *core, void *buff, size_t len, time_t timeout)
+{
+	size_t res;
+	time_t start;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	start = hal_timerGet();
+	while (lib_cbufEmpty(&core->rx) != 0) {
+		if ((hal_timerGet() - start) >= timeout) {
+			return -ETIME;
+		}
+	}
+
+	/* RX ring is filled only by the interrupt handler - no locking needed */
+	res = lib_cbufRead(&core->rx, buff, len);
+
+	return (ssize_t)res;
+}
+
+
+ssize_t uartcore_write(uartcore_t *core, const void *buff, size_t len)
+{
+	size_t res, l = 0;
+
+	while (l < len) {
+		/* Wait for free space in the TX ring */
+		while (lib_cbufFull(&core->tx) != 0) {
+		}
+
+		res = lib_cbufWrite(&core->tx, (const u8 *)buff + l, len - l);
+
+		/* TX ring is drained both from here and from the interrupt handler */
+		hal_interruptsDisableAll();
+		core->txFill(core);
+		hal_interruptsEnableAll();
+
+		l += res;
+	}
+
+	return (ssize_t)len;
+}
+
+
+void uartcore_txDrain(uartcore_t *core)
+{
+	while (lib_cbufEmpty(&core->tx) == 0) {
+	}
+}
+
+
+void uartcore_init(uartcore_t *core, void *rxBuf, size_t rxSz, void *txBuf, size_t txSz, void (*txFill)(uartcore_t *))
+{
+	lib_cbufInit(&core->rx, rxBuf, rxSz);
+	lib_cbufInit(&core->tx, txBuf, (txBuf != NULL) ? txSz : 0);
+	core->txFill = txFill;
+	core->rxOverrun = 0;
+}
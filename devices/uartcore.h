@@ -0,0 +1,63 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * UART common core
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _DEV_UARTCORE_H_
+#define _DEV_UARTCORE_H_
+
+#include <hal/hal.h>
+#include <lib/cbuffer.h>
+
+
+typedef struct _uartcore_t {
+	cbuffer_t rx;
+	cbuffer_t tx;
+
+	/* Moves data from the TX ring into the hardware FIFO and (un)masks the TX watermark interrupt.
+	 * Called with interrupts disabled or from the interrupt handler. */
+	void (*txFill)(struct _uartcore_t *core);
+
+	/* Bytes dropped due to RX ring overflow */
+	volatile u32 rxOverrun;
+} uartcore_t;
+
+
+/* Interrupt context helpers */
+
+/* Stores received byte in the RX ring, returns 0 if the byte was dropped */
+extern int uartcore_rxPut(uartcore_t *core, u8 c) __attribute__((section(".noxip")));
+
+
+/* Takes next byte to transmit from the TX ring, returns 0 if the ring is empty */
+extern int uartcore_txGet(uartcore_t *core, u8 *c) __attribute__((section(".noxip")));
+
+
+/* Device interface helpers */
+
+/* Waits up to `timeout` ms for data, then copies out as much as is available (up to `len`) */
+extern ssize_t uartcore_read(uartcore_t *core, void *buff, size_t len, time_t timeout);
+
+
+/* Queues the whole buffer for transmission, waiting for free space in the TX ring if needed */
+extern ssize_t uartcore_write(uartcore_t *core, const void *buff, size_t len);
+
+
+/* Waits until the TX ring is drained into the hardware */
+extern void uartcore_txDrain(uartcore_t *core);
+
+
+/* Initializes core. `txBuf` can be NULL for drivers transmitting directly (polled or DMA) */
+extern void uartcore_init(uartcore_t *core, void *rxBuf, size_t rxSz, void *txBuf, size_t txSz, void (*txFill)(uartcore_t *));
+
+
+#endif
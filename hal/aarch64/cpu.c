@@ -45,3 +45,9 @@ void hal_cpuInvCache(unsigned int type, addr_t addr, size_t sz)
 			break;
 	}
 }
+
+
+void hal_cpuFlushDataCache(addr_t addr, size_t sz)
+{
+	hal_dcacheFlush(addr, addr + sz);
+}
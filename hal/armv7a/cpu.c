@@ -14,6 +14,7 @@
  */
 
 #include <hal/hal.h>
+#include "cache.h"
 
 
 void hal_interruptsDisableAll(void)
@@ -39,3 +40,9 @@ void hal_cpuInvCache(unsigned int type, addr_t addr, size_t sz)
 			break;
 	}
 }
+
+
+void hal_cpuFlushDataCache(addr_t addr, size_t sz)
+{
+	hal_dcacheFlush(addr, addr + sz);
+}
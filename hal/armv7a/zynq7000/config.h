@@ -30,6 +30,10 @@
 
 #define PATH_KERNEL "phoenix-armv7a9-zynq7000.elf"
 
+/* phfs read cache for SD card and QSPI flash, 32 KB */
+#define PHFS_CACHE_SETS 16
+#define PHFS_CACHE_WAYS 4
+
 #endif
 
 
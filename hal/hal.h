@@ -44,6 +44,10 @@ extern const char *hal_cpuInfo(void);
 extern void hal_cpuInvCache(unsigned int type, addr_t addr, size_t sz);
 
 
+/* Function writes back and invalidates data cache, provided by HALs with external memory tests */
+extern void hal_cpuFlushDataCache(addr_t addr, size_t sz);
+
+
 /* Function reboots system (final state may depend on latched bootloader config) */
 extern void hal_cpuReboot(void) __attribute__((noreturn));
 
@@ -30,6 +30,14 @@
 /* Executes BIOS interrupt calls */
 extern void _interrupts_bios(unsigned char intr, unsigned short ds, unsigned short es);
 
+
+/* Returns generation of the VGA text screen content, shared by all its writers */
+extern u32 hal_consoleVgaGen(void);
+
+
+/* Marks the VGA text screen as written, returns the new generation */
+extern u32 hal_consoleVgaWritten(void);
+
 #endif
 
 
@@ -41,6 +49,12 @@ extern void _interrupts_bios(unsigned char intr, unsigned short ds, unsigned sho
 #define HAS_GRAPHICS 1
 
 
+/* phfs read cache for BIOS disks, 32 KB, each miss reads 4 sectors */
+#define PHFS_CACHE_SETS  4
+#define PHFS_CACHE_WAYS  4
+#define PHFS_CACHE_BLKSZ 2048
+
+
 /* Import platform specific definitions */
 #include "ld/ia32-generic.ldt"
 
@@ -18,6 +18,11 @@
 #include "console.h"
 
 
+/* Text mode size */
+#define CONSOLE_ROWS 25
+#define CONSOLE_COLS 80
+
+
 /* ANSI escape sequence states */
 enum {
 	esc_init, /* normal */
@@ -46,6 +51,11 @@ static struct {
 	u16 crtc;                /* CRT controller register */
 	unsigned int rows;       /* Console height */
 	unsigned int cols;       /* Console width */
+	unsigned int pos;        /* Cursor position after the last print */
+	u32 gen;                 /* Screen generation after the last print */
+	unsigned int head;       /* Shadow row displayed as the first console row */
+	u32 dirty;               /* Console rows modified since the last flush */
+	u16 shadow[CONSOLE_ROWS * CONSOLE_COLS]; /* Screen copy in RAM, video memory is slow to access */
 	unsigned char attr;      /* Character attribute */
 	unsigned char esc;       /* Escape sequence state */
 	unsigned char parmi;     /* Escape sequence parameter index */
@@ -54,33 +64,105 @@ static struct {
 } halconsole_common;
 
 
-static void console_memset(volatile u16 *vram, u16 val, unsigned int n)
+static void hal_consoleVgaSetHooks(ssize_t (*writeHook)(int, const void *, size_t))
 {
-	unsigned int i;
+	halconsole_common.writeHook = writeHook;
+}
+
+
+/* Returns shadow cell of the console position */
+static u16 *console_cell(unsigned int row, unsigned int col)
+{
+	row += halconsole_common.head;
+	if (row >= halconsole_common.rows) {
+		row -= halconsole_common.rows;
+	}
 
-	for (i = 0; i < n; i++)
-		*(vram + i) = val;
+	return &halconsole_common.shadow[row * halconsole_common.cols + col];
 }
 
 
-static void hal_consoleVgaSetHooks(ssize_t (*writeHook)(int, const void *, size_t))
+static void console_fill(unsigned int pos, u16 val, unsigned int n)
 {
-	halconsole_common.writeHook = writeHook;
+	unsigned int row, col, i, cnt;
+	u16 *cell;
+
+	while (n != 0) {
+		row = pos / halconsole_common.cols;
+		col = pos % halconsole_common.cols;
+		cnt = halconsole_common.cols - col;
+		if (cnt > n) {
+			cnt = n;
+		}
+
+		cell = console_cell(row, col);
+		for (i = 0; i < cnt; i++) {
+			cell[i] = val;
+		}
+		halconsole_common.dirty |= 1u << row;
+
+		pos += cnt;
+		n -= cnt;
+	}
 }
 
 
-static void console_memmove(volatile u16 *dst, volatile u16 *src, unsigned int n)
+/* Scrolls by rotating shadow rows, the whole console is rewritten on the next flush */
+static void console_scroll(void)
+{
+	console_fill(0, (u16)halconsole_common.attr << 8 | ' ', halconsole_common.cols);
+	halconsole_common.head = (halconsole_common.head + 1 == halconsole_common.rows) ? 0 : halconsole_common.head + 1;
+	halconsole_common.dirty = (1u << halconsole_common.rows) - 1;
+}
+
+
+/* Writes modified rows to video memory and updates cursor */
+static void console_flush(unsigned int row, unsigned int col)
+{
+	volatile u16 *vram;
+	u16 *cell;
+	unsigned int r, i;
+
+	/* Cursor takes the current attribute */
+	cell = console_cell(row, col);
+	*cell = (*cell & 0xff) | ((u16)halconsole_common.attr << 8);
+	halconsole_common.dirty |= 1u << row;
+
+	for (r = 0; (halconsole_common.dirty != 0) && (r < halconsole_common.rows); r++) {
+		if ((halconsole_common.dirty & (1u << r)) != 0) {
+			cell = console_cell(r, 0);
+			vram = halconsole_common.vram + r * halconsole_common.cols;
+			for (i = 0; i < halconsole_common.cols; i++) {
+				vram[i] = cell[i];
+			}
+			halconsole_common.dirty &= ~(1u << r);
+		}
+	}
+
+	halconsole_common.pos = row * halconsole_common.cols + col;
+	halconsole_common.gen = hal_consoleVgaWritten();
+	hal_outb(halconsole_common.crtc, 0x0e);
+	hal_outb(halconsole_common.crtc + 1, halconsole_common.pos >> 8);
+	hal_outb(halconsole_common.crtc, 0x0f);
+	hal_outb(halconsole_common.crtc + 1, halconsole_common.pos);
+}
+
+
+/* Reloads shadow, if the screen has been written by someone else (e.g. tty-bios device) */
+static void console_reload(unsigned int pos)
 {
 	unsigned int i;
 
-	if (dst < src) {
-		for (i = 0; i < n; i++)
-			dst[i] = src[i];
+	/* Cursor check also catches writers not tracking the generation (e.g. BIOS) */
+	if ((pos == halconsole_common.pos) && (hal_consoleVgaGen() == halconsole_common.gen)) {
+		return;
 	}
-	else {
-		for (i = n; i--;)
-			dst[i] = src[i];
+
+	for (i = 0; i < halconsole_common.rows * halconsole_common.cols; i++) {
+		halconsole_common.shadow[i] = halconsole_common.vram[i];
 	}
+	halconsole_common.head = 0;
+	halconsole_common.dirty = 0;
 }
 
 
@@ -95,6 +177,7 @@ static void hal_consoleVgaPrint(const char *s)
 	pos = hal_inb(halconsole_common.crtc + 1);
 	hal_outb(halconsole_common.crtc, 0x0e);
 	pos |= (u16)hal_inb(halconsole_common.crtc + 1) << 8;
+	console_reload(pos);
 	row = pos / halconsole_common.cols;
 	col = pos % halconsole_common.cols;
 
@@ -136,7 +219,8 @@ static void hal_consoleVgaPrint(const char *s)
 		else {
 			switch (halconsole_common.esc) {
 				case esc_init:
-					*(halconsole_common.vram + row * halconsole_common.cols + col) = (u16)halconsole_common.attr << 8 | c;
+					*console_cell(row, col) = (u16)halconsole_common.attr << 8 | c;
+					halconsole_common.dirty |= 1u << row;
 					col++;
 					break;
 
@@ -198,15 +282,15 @@ static void hal_consoleVgaPrint(const char *s)
 						case 'J':
 							switch (halconsole_common.parms[0]) {
 								case 0:
-									console_memset(halconsole_common.vram + row * halconsole_common.cols + col, (u16)halconsole_common.attr << 8 | ' ', halconsole_common.cols * (halconsole_common.rows - row) - col);
+									console_fill(row * halconsole_common.cols + col, (u16)halconsole_common.attr << 8 | ' ', halconsole_common.cols * (halconsole_common.rows - row) - col);
 									break;
 
 								case 1:
-									console_memset(halconsole_common.vram, (u16)halconsole_common.attr << 8 | ' ', row * halconsole_common.cols + col + 1);
+									console_fill(0, (u16)halconsole_common.attr << 8 | ' ', row * halconsole_common.cols + col + 1);
 									break;
 
 								case 2:
-									console_memset(halconsole_common.vram, (u16)halconsole_common.attr << 8 | ' ', halconsole_common.rows * halconsole_common.cols);
+									console_fill(0, (u16)halconsole_common.attr << 8 | ' ', halconsole_common.rows * halconsole_common.cols);
 									break;
 							}
 							halconsole_common.esc = esc_init;
@@ -313,22 +397,14 @@ static void hal_consoleVgaPrint(const char *s)
 
 		/* Scroll down */
 		if (row == halconsole_common.rows) {
-			i = halconsole_common.cols * (halconsole_common.rows - 1);
-			console_memmove(halconsole_common.vram, halconsole_common.vram + halconsole_common.cols, i);
-			console_memset(halconsole_common.vram + i, (u16)halconsole_common.attr << 8 | ' ', halconsole_common.cols);
+			console_scroll();
 			row--;
 			col = 0;
 		}
-
-		/* Update cursor */
-		i = row * halconsole_common.cols + col;
-		hal_outb(halconsole_common.crtc, 0x0e);
-		hal_outb(halconsole_common.crtc + 1, i >> 8);
-		hal_outb(halconsole_common.crtc, 0x0f);
-		hal_outb(halconsole_common.crtc + 1, i);
-		*((u8 *)(halconsole_common.vram + i) + 1) = halconsole_common.attr;
 	}
 
+	console_flush(row, col);
+
 	if (halconsole_common.writeHook != NULL) {
 		(void)halconsole_common.writeHook(0, s, ptr - s);
 	}
@@ -347,10 +423,13 @@ static void hal_consoleVgaInit(void)
 	halconsole_common.crtc = (u16)(color ? 0x3d4 : 0x3b4);
 
 	/* Default 80x25 text mode with magenta color attribute */
-	halconsole_common.rows = 25;
-	halconsole_common.cols = 80;
+	halconsole_common.rows = CONSOLE_ROWS;
+	halconsole_common.cols = CONSOLE_COLS;
 	halconsole_common.attr = 0x05;
 
+	/* Shadow is loaded from the screen on the first print */
+	halconsole_common.pos = (unsigned int)-1;
+
 	/* Clear console */
 	hal_consoleVgaPrint("\033[2J\033[H");
 }
@@ -20,6 +20,22 @@
 static struct halconsole *halconsole_common;
 
 
+/* VGA text screen is written by both the HAL console and tty-bios device */
+static volatile u32 halconsole_vgaGen;
+
+
+u32 hal_consoleVgaGen(void)
+{
+	return halconsole_vgaGen;
+}
+
+
+u32 hal_consoleVgaWritten(void)
+{
+	return ++halconsole_vgaGen;
+}
+
+
 void hal_consoleSetHooks(ssize_t (*writeHook)(int, const void *, size_t))
 {
 	struct halconsole *curr;
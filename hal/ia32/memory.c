@@ -140,7 +140,7 @@ int hal_memoryGetNextEntry(addr_t start, addr_t end, mapent_t *entry)
 		{ .start = ADDR_VBE_INFO, .end = ADDR_VBE_INFO + SIZE_VBE_INFO, .type = hal_entryTemp },
 		{ .start = ADDR_VBE_MODE_INFO, .end = ADDR_VBE_MODE_INFO + SIZE_VBE_MODE_INFO, .type = hal_entryTemp },
 		/* TODO: this entry should be removed after changes in disk-bios */
-		{ .start = ADDR_RCACHE, .end = ADDR_RCACHE + SIZE_RCACHE + SIZE_WCACHE, .type = hal_entryTemp },
+		{ .start = ADDR_RBUFF, .end = ADDR_RBUFF + SIZE_RBUFF + SIZE_WCACHE, .type = hal_entryTemp },
 	};
 
 	if (start == end) {
@@ -18,8 +18,9 @@
 
 /* Unprivileged CSRs */
 
-#define CSR_CYCLE 0xc00u
-#define CSR_TIME  0xc01u
+#define CSR_CYCLE   0xc00u
+#define CSR_TIME    0xc01u
+#define CSR_INSTRET 0xc02u
 
 /* Supervisor CSRs */
 
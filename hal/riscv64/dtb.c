@@ -21,6 +21,10 @@
 extern void _end(void);
 
 
+/* Capacity of the compatible index, larger trees report all devices as available */
+#define DTB_MAX_COMPAT 128
+
+
 struct _fdt_header_t {
 	u32 magic;
 	u32 totalsize;
@@ -35,6 +39,13 @@ struct _fdt_header_t {
 };
 
 
+typedef struct {
+	u32 hash;
+	u32 okay;
+	const char *compatible;
+} dtb_compat_t;
+
+
 static struct {
 	struct _fdt_header_t *fdth;
 
@@ -68,6 +79,10 @@ static struct {
 		} intctl;
 	} soc;
 
+	/* Compatible strings of all nodes sorted by hash */
+	int indexed; /* Index is complete */
+	size_t ncompat;
+	dtb_compat_t compat[DTB_MAX_COMPAT];
 } dtb_common;
 
 
@@ -77,6 +92,71 @@ char *dtb_getString(u32 i)
 }
 
 
+static u32 dtb_hash(const char *s)
+{
+	/* FNV-1a */
+	u32 h = 0x811c9dc5u;
+
+	while (*s != '\0') {
+		h ^= (u8)*s++;
+		h *= 0x01000193u;
+	}
+
+	return h;
+}
+
+
+/* Indexes compatible strings of the current node, its status is applied once all properties are parsed */
+static int dtb_parseIndex(void *dtb, u32 si, u32 l, u32 *okay)
+{
+	const char *str = dtb, *end = (const char *)dtb + l;
+
+	if (hal_strcmp(dtb_getString(si), "compatible") == 0) {
+		while ((str < end) && (*str != '\0')) {
+			if (dtb_common.ncompat == DTB_MAX_COMPAT) {
+				return -1;
+			}
+			dtb_common.compat[dtb_common.ncompat].hash = dtb_hash(str);
+			dtb_common.compat[dtb_common.ncompat].okay = 1;
+			dtb_common.compat[dtb_common.ncompat].compatible = str;
+			dtb_common.ncompat++;
+			str += hal_strlen(str) + 1;
+		}
+	}
+	else if (hal_strcmp(dtb_getString(si), "status") == 0) {
+		*okay = ((hal_strcmp(str, "okay") == 0) || (hal_strcmp(str, "ok") == 0)) ? 1 : 0;
+	}
+
+	return 0;
+}
+
+
+/* Sets status of compatible strings indexed since `first`, properties precede subnodes */
+static void dtb_applyStatus(size_t first, u32 okay)
+{
+	size_t i;
+
+	for (i = first; i < dtb_common.ncompat; i++) {
+		dtb_common.compat[i].okay = okay;
+	}
+}
+
+
+static void dtb_sortIndex(void)
+{
+	size_t i, j;
+	dtb_compat_t e;
+
+	for (i = 1; i < dtb_common.ncompat; i++) {
+		e = dtb_common.compat[i];
+		for (j = i; (j > 0) && (dtb_common.compat[j - 1].hash > e.hash); j--) {
+			dtb_common.compat[j] = dtb_common.compat[j - 1];
+		}
+		dtb_common.compat[j] = e;
+	}
+}
+
+
 void dtb_parseSystem(void *dtb, u32 si, u32 l)
 {
 	if (hal_strcmp(dtb_getString(si), "model") == 0) {
@@ -130,7 +210,9 @@ void dtb_parse(void *dtb)
 	extern char _start;
 	unsigned int d = 0;
 	u32 token, si;
-	size_t l;
+	size_t l, first = 0;
+	u32 okay = 1;
+	int overflow = 0;
 	enum {
 		stateIdle,
 		stateSystem,
@@ -142,6 +224,7 @@ void dtb_parse(void *dtb)
 	} state = stateIdle;
 
 	dtb_common.fdth = (struct _fdt_header_t *)dtb;
+	dtb_common.indexed = 0;
 
 	if (dtb_common.fdth->magic != ntoh32(0xd00dfeed)) {
 		return;
@@ -150,6 +233,7 @@ void dtb_parse(void *dtb)
 	dtb = (void *)dtb_common.fdth + ntoh32(dtb_common.fdth->off_dt_struct);
 	dtb_common.soc.intctl.exist = 0;
 	dtb_common.ncpus = 0;
+	dtb_common.ncompat = 0;
 
 	for (;;) {
 		token = ntoh32(*(u32 *)dtb);
@@ -178,6 +262,11 @@ void dtb_parse(void *dtb)
 
 			dtb += ((hal_strlen(dtb) + 3) & ~3);
 			d++;
+
+			/* Properties of the parent node are complete */
+			dtb_applyStatus(first, okay);
+			first = dtb_common.ncompat;
+			okay = 1;
 		}
 
 		/* FDT_PROP */
@@ -189,6 +278,10 @@ void dtb_parse(void *dtb)
 			si = ntoh32(*(u32 *)dtb);
 			dtb += 4;
 
+			if ((overflow == 0) && (dtb_parseIndex(dtb, si, l, &okay) < 0)) {
+				overflow = 1;
+			}
+
 			switch (state) {
 				case stateSystem:
 					dtb_parseSystem(dtb, si, l);
@@ -219,6 +312,9 @@ void dtb_parse(void *dtb)
 
 		/* FDT_NODE_END */
 		else if (token == 2) {
+			dtb_applyStatus(first, okay);
+			first = dtb_common.ncompat;
+
 			switch (state) {
 				case stateCPU:
 					dtb_common.ncpus++;
@@ -245,10 +341,46 @@ void dtb_parse(void *dtb)
 		}
 	}
 
+	if (overflow == 0) {
+		dtb_sortIndex();
+		dtb_common.indexed = 1;
+	}
+
 	dtb_common.start = &_start;
 }
 
 
+int dtb_isAvailable(const char *compatible)
+{
+	size_t lo = 0, hi = dtb_common.ncompat, mid;
+	u32 hash;
+
+	/* No device tree or index overflow - assume present */
+	if (dtb_common.indexed == 0) {
+		return 1;
+	}
+
+	hash = dtb_hash(compatible);
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (dtb_common.compat[mid].hash < hash) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	for (; (lo < dtb_common.ncompat) && (dtb_common.compat[lo].hash == hash); lo++) {
+		if ((dtb_common.compat[lo].okay != 0) && (hal_strcmp(dtb_common.compat[lo].compatible, compatible) == 0)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
 int dtb_getPLIC(void)
 {
 	return dtb_common.soc.intctl.exist;
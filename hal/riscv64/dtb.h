@@ -28,4 +28,8 @@ extern void dtb_parse(void *dtb);
 extern int dtb_getPLIC(void);
 
 
+/* Returns 1 if a node compatible with `compatible` is present and enabled (or there is no device tree) */
+extern int dtb_isAvailable(const char *compatible);
+
+
 #endif
@@ -57,6 +57,12 @@ void hal_done(void)
 }
 
 
+int hal_devAvailable(const char *compatible)
+{
+	return dtb_isAvailable(compatible);
+}
+
+
 void hal_syspageSet(hal_syspage_t *hs)
 {
 	hs->boothartId = boothartId;
@@ -19,42 +19,90 @@
 
 size_t lib_cbufSize(const cbuffer_t *buf)
 {
-	if (buf->tail == buf->head)
-		return buf->full ? buf->capacity : 0;
+	return buf->tail - buf->head;
+}
+
 
-	return (buf->tail - buf->head + buf->capacity) % buf->capacity;
+size_t lib_cbufFree(const cbuffer_t *buf)
+{
+	return buf->capacity - (buf->tail - buf->head);
 }
 
 
 int lib_cbufEmpty(const cbuffer_t *buf)
 {
-	return buf->head == buf->tail && !buf->full;
+	return buf->head == buf->tail;
 }
 
 
-size_t lib_cbufWrite(cbuffer_t *buf, const void *data, size_t sz)
+int lib_cbufFull(const cbuffer_t *buf)
 {
-	int bytes = 0;
+	return (buf->tail - buf->head) == buf->capacity;
+}
 
-	if (!sz || buf->full)
-		return 0;
 
-	if (buf->head > buf->tail) {
-		hal_memcpy(buf->data + buf->tail, data, bytes = min(sz, buf->head - buf->tail));
-	}
-	else {
-		hal_memcpy(buf->data + buf->tail, data, bytes = min(sz, buf->capacity - buf->tail));
-
-		if (bytes < sz && buf->head) {
-			data += bytes;
-			sz -= bytes;
-			hal_memcpy(buf->data, data, min(sz, buf->head));
-			bytes += min(sz, buf->head);
+size_t lib_cbufPeekRead(const cbuffer_t *buf, void **span)
+{
+	size_t head = buf->head;
+	size_t used = buf->tail - head;
+	size_t offs = head & (buf->capacity - 1);
+
+	/* Data must not be read before tail update is observed */
+	hal_cpuDataMemoryBarrier();
+
+	*span = (u8 *)buf->data + offs;
+
+	return min(used, buf->capacity - offs);
+}
+
+
+void lib_cbufCommitRead(cbuffer_t *buf, size_t sz)
+{
+	/* Finish reading data before the space is handed back to the producer */
+	hal_cpuDataMemoryBarrier();
+	buf->head += sz;
+}
+
+
+size_t lib_cbufPeekWrite(const cbuffer_t *buf, void **span)
+{
+	size_t tail = buf->tail;
+	size_t avail = buf->capacity - (tail - buf->head);
+	size_t offs = tail & (buf->capacity - 1);
+
+	/* Data must not be written before head update is observed */
+	hal_cpuDataMemoryBarrier();
+
+	*span = (u8 *)buf->data + offs;
+
+	return min(avail, buf->capacity - offs);
+}
+
+
+void lib_cbufCommitWrite(cbuffer_t *buf, size_t sz)
+{
+	/* Data has to be visible to the consumer before tail update */
+	hal_cpuDataMemoryBarrier();
+	buf->tail += sz;
+}
+
+
+size_t lib_cbufWrite(cbuffer_t *buf, const void *data, size_t sz)
+{
+	size_t len, bytes = 0;
+	void *span;
+
+	/* Free space spans at most two contiguous regions */
+	while (bytes < sz) {
+		len = min(sz - bytes, lib_cbufPeekWrite(buf, &span));
+		if (len == 0) {
+			break;
 		}
-	}
 
-	buf->tail = (buf->tail + bytes) % buf->capacity;
-	buf->full = buf->tail == buf->head;
+		hal_memcpy(span, (const u8 *)data + bytes, len);
+		lib_cbufCommitWrite(buf, len);
+		bytes += len;
+	}
 
 	return bytes;
 }
@@ -62,14 +110,17 @@ size_t lib_cbufWrite(cbuffer_t *buf, const void *data, size_t sz)
 
 __attribute__((section(".noxip"))) int lib_cbufWriteByte(cbuffer_t *buf, char data)
 {
-	if (buf->full != 0) {
+	size_t tail = buf->tail;
+
+	if ((tail - buf->head) == buf->capacity) {
 		return 0;
 	}
 
-	*((char *)buf->data + buf->tail) = data;
+	hal_cpuDataMemoryBarrier();
+	*((char *)buf->data + (tail & (buf->capacity - 1))) = data;
+	hal_cpuDataMemoryBarrier();
 
-	buf->tail = (buf->tail + 1) % buf->capacity;
-	buf->full = (buf->tail == buf->head);
+	buf->tail = tail + 1;
 
 	return 1;
 }
@@ -77,27 +128,20 @@ __attribute__((section(".noxip"))) int lib_cbufWriteByte(cbuffer_t *buf, char da
 
 size_t lib_cbufRead(cbuffer_t *buf, void *data, size_t sz)
 {
-	int bytes = 0;
-
-	if (!sz || (buf->head == buf->tail && !buf->full))
-		return 0;
-
-	if (buf->tail > buf->head) {
-		hal_memcpy(data, buf->data + buf->head, bytes = min(sz, buf->tail - buf->head));
-	}
-	else {
-		hal_memcpy(data, buf->data + buf->head, bytes = min(sz, buf->capacity - buf->head));
-
-		if (bytes < sz) {
-			data += bytes;
-			sz -= bytes;
-			hal_memcpy(data, buf->data, min(sz, buf->tail));
-			bytes += min(sz, buf->tail);
+	size_t len, bytes = 0;
+	void *span;
+
+	/* Data spans at most two contiguous regions */
+	while (bytes < sz) {
+		len = min(sz - bytes, lib_cbufPeekRead(buf, &span));
+		if (len == 0) {
+			break;
 		}
-	}
 
-	buf->head = (buf->head + bytes) % buf->capacity;
-	buf->full = 0;
+		hal_memcpy((u8 *)data + bytes, span, len);
+		lib_cbufCommitRead(buf, len);
+		bytes += len;
+	}
 
 	return bytes;
 }
@@ -105,14 +149,17 @@ size_t lib_cbufRead(cbuffer_t *buf, void *data, size_t sz)
 
 __attribute__((section(".noxip"))) int lib_cbufReadByte(cbuffer_t *buf, char *data)
 {
-	if ((buf->head == buf->tail) && (buf->full == 0)) {
+	size_t head = buf->head;
+
+	if (head == buf->tail) {
 		return 0;
 	}
 
-	*data = *((char *)buf->data + buf->head);
+	hal_cpuDataMemoryBarrier();
+	*data = *((char *)buf->data + (head & (buf->capacity - 1)));
+	hal_cpuDataMemoryBarrier();
 
-	buf->head = (buf->head + 1) % buf->capacity;
-	buf->full = 0;
+	buf->head = head + 1;
 
 	return 1;
 }
@@ -120,6 +167,11 @@ __attribute__((section(".noxip"))) int lib_cbufReadByte(cbuffer_t *buf, char *da
 
 void lib_cbufInit(cbuffer_t *buf, void *data, size_t capacity)
 {
+	/* Keep only the most significant bit */
+	while ((capacity & (capacity - 1)) != 0) {
+		capacity &= capacity - 1;
+	}
+
 	hal_memset(buf, 0, sizeof(cbuffer_t));
 	buf->capacity = capacity;
 	buf->data = data;
@@ -19,10 +19,17 @@
 #include "lib.h"
 #include <hal/hal.h>
 
+
+/*
+ * Single producer, single consumer ring buffer. Capacity is a power of 2,
+ * head and tail are free-running indices masked on access. The producer only
+ * modifies tail, the consumer only modifies head, so one side can run in an
+ * interrupt handler without disabling interrupts on the other.
+ */
+
 typedef struct {
 	size_t capacity;
 	volatile size_t tail, head;
-	volatile u8 full;
 
 	void *data;
 } cbuffer_t;
@@ -31,9 +38,15 @@ typedef struct {
 extern size_t lib_cbufSize(const cbuffer_t *buf);
 
 
+extern size_t lib_cbufFree(const cbuffer_t *buf);
+
+
 extern int lib_cbufEmpty(const cbuffer_t *buf);
 
 
+extern int lib_cbufFull(const cbuffer_t *buf);
+
+
 extern size_t lib_cbufRead(cbuffer_t *buf, void *data, size_t sz);
 
 
@@ -46,6 +59,23 @@ extern int lib_cbufReadByte(cbuffer_t *buf, char *data) __attribute__((section("
 extern int lib_cbufWriteByte(cbuffer_t *buf, char data) __attribute__((section(".noxip")));
 
 
+/* Zero-copy access - returns length of contiguous data available at *span (consumer side) */
+extern size_t lib_cbufPeekRead(const cbuffer_t *buf, void **span);
+
+
+/* Releases sz bytes obtained by lib_cbufPeekRead */
+extern void lib_cbufCommitRead(cbuffer_t *buf, size_t sz);
+
+
+/* Zero-copy access - returns length of contiguous free space at *span (producer side) */
+extern size_t lib_cbufPeekWrite(const cbuffer_t *buf, void **span);
+
+
+/* Publishes sz bytes stored in the span obtained by lib_cbufPeekWrite */
+extern void lib_cbufCommitWrite(cbuffer_t *buf, size_t sz);
+
+
+/* Capacity is rounded down to a power of 2 */
 extern void lib_cbufInit(cbuffer_t *buf, void *data, size_t capacity);
 
 
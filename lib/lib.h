@@ -27,6 +27,8 @@
 #include "prompt.h"
 #include "crc32.h"
 #include "ptable.h"
+#include "perf.h"
+#include "rand.h"
 
 
 #define min(a, b) ({ \
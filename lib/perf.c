@@ -0,0 +1,82 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Binary event stream for boot tracing
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "lib.h"
+#include "perf.h"
+
+
+static struct {
+	int (*writeHook)(const void *, size_t);
+	u32 lost;
+} perf_common;
+
+
+void lib_perfSetHook(int (*wr)(const void *, size_t))
+{
+	perf_common.writeHook = wr;
+	perf_common.lost = 0;
+}
+
+
+int lib_perfEnabled(void)
+{
+	return (perf_common.writeHook != NULL) ? 1 : 0;
+}
+
+
+void lib_perfEvent(unsigned int type, unsigned int dev, time_t time, u32 arg0, u32 arg1, u32 arg2, const char *name)
+{
+	struct {
+		perf_event_t ev;
+		char name[PERF_NAME_MAX];
+	} rec;
+	size_t len = 0;
+
+	if (perf_common.writeHook == NULL) {
+		return;
+	}
+
+	/* Report events dropped when the probe didn't keep up */
+	if (perf_common.lost != 0) {
+		rec.ev.type = PERF_EV_LOST;
+		rec.ev.size = sizeof(rec.ev);
+		rec.ev.dev = 0;
+		rec.ev.time = (u32)hal_timerGet();
+		rec.ev.arg[0] = perf_common.lost;
+		rec.ev.arg[1] = 0;
+		rec.ev.arg[2] = 0;
+		if (perf_common.writeHook(&rec.ev, sizeof(rec.ev)) < 0) {
+			perf_common.lost++;
+			return;
+		}
+		perf_common.lost = 0;
+	}
+
+	if (name != NULL) {
+		len = min(hal_strlen(name), sizeof(rec.name));
+		hal_memcpy(rec.name, name, len);
+	}
+
+	rec.ev.type = type;
+	rec.ev.size = sizeof(rec.ev) + len;
+	rec.ev.dev = dev;
+	rec.ev.time = (u32)time;
+	rec.ev.arg[0] = arg0;
+	rec.ev.arg[1] = arg1;
+	rec.ev.arg[2] = arg2;
+
+	if (perf_common.writeHook(&rec, sizeof(rec.ev) + len) < 0) {
+		perf_common.lost++;
+	}
+}
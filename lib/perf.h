@@ -0,0 +1,66 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Binary event stream for boot tracing
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _LIB_PERF_H_
+#define _LIB_PERF_H_
+
+#include <hal/hal.h>
+
+
+#define PERF_MAGIC   "PLOPERF"
+#define PERF_VERSION 1
+
+#define PERF_NAME_MAX 32
+
+/* Event types */
+#define PERF_EV_CMD_START 1 /* arg[0] - argc, payload - command name */
+#define PERF_EV_CMD_END   2 /* arg[0] - result, arg[1] - duration, payload - command name */
+#define PERF_EV_DEV_READ  3 /* arg[0] - offset, arg[1] - result, arg[2] - duration */
+#define PERF_EV_DEV_WRITE 4
+#define PERF_EV_DEV_ERASE 5
+#define PERF_EV_LOST      6 /* arg[0] - number of events dropped since the last written one */
+
+
+/* Little endian record, followed by 'size - sizeof(perf_event_t)' bytes of payload */
+typedef struct {
+	u8 type;
+	u8 size; /* Size of the record including payload */
+	u16 dev; /* (major << 8) | minor for device events */
+	u32 time;
+	u32 arg[3];
+} __attribute__((packed)) perf_event_t;
+
+
+/* Stream description written once to the meta channel, times are in 'timeUnit' ns */
+typedef struct {
+	char magic[8];
+	u32 version;
+	u32 eventSize;
+	u32 timeUnit;
+} __attribute__((packed)) perf_meta_t;
+
+
+/* Registers hook writing the whole record or failing (for use with debugger, RTT) */
+extern void lib_perfSetHook(int (*wr)(const void *, size_t));
+
+
+/* Checks whether events are collected */
+extern int lib_perfEnabled(void);
+
+
+/* Writes event, name is optional */
+extern void lib_perfEvent(unsigned int type, unsigned int dev, time_t time, u32 arg0, u32 arg1, u32 arg2, const char *name);
+
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Pseudo-random numbers
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "rand.h"
+
+
+u32 lib_rand(u32 *seed)
+{
+	/* xorshift32 */
+	u32 x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+
+	return x;
+}
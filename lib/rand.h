@@ -0,0 +1,29 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Pseudo-random numbers
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _LIB_RAND_H_
+#define _LIB_RAND_H_
+
+#include <hal/hal.h>
+
+
+/* Default seed, fixed for comparable benchmark runs */
+#define LIB_RAND_SEED 0x2545f491u
+
+
+/* Returns next value of the xorshift32 sequence, seed must not be 0 */
+extern u32 lib_rand(u32 *seed);
+
+
+#endif
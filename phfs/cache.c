@@ -0,0 +1,156 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * phfs read cache
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "cache.h"
+#include "phfs.h"
+
+#include <devices/devs.h>
+#include <lib/lib.h>
+
+
+/* Cache is enabled by defining PHFS_CACHE_SETS in the target configuration */
+#if defined(PHFS_CACHE_SETS) && (PHFS_CACHE_SETS > 0)
+
+#ifndef PHFS_CACHE_BLKSZ
+#define PHFS_CACHE_BLKSZ 512
+#endif
+
+#ifndef PHFS_CACHE_WAYS
+#define PHFS_CACHE_WAYS 4
+#endif
+
+
+typedef struct {
+	addr_t blk; /* Device offset divided by block size */
+	u8 major;
+	u8 minor;
+	u8 valid;
+	u32 used; /* Last access time for LRU replacement */
+} phfs_cacheLine_t;
+
+
+static struct {
+	u8 data[PHFS_CACHE_SETS][PHFS_CACHE_WAYS][PHFS_CACHE_BLKSZ] __attribute__((aligned(sizeof(long long))));
+	phfs_cacheLine_t lines[PHFS_CACHE_SETS][PHFS_CACHE_WAYS];
+	u32 tick;
+} phfs_cache_common;
+
+
+/* Returns cached block, reads it from the device on miss */
+static const u8 *phfs_cacheGet(unsigned int major, unsigned int minor, addr_t blk, time_t timeout)
+{
+	unsigned int set = blk % PHFS_CACHE_SETS, way, victim = 0;
+	phfs_cacheLine_t *line = phfs_cache_common.lines[set];
+	ssize_t res;
+
+	for (way = 0; way < PHFS_CACHE_WAYS; way++) {
+		if ((line[way].valid != 0) && (line[way].blk == blk) && (line[way].major == major) && (line[way].minor == minor)) {
+			line[way].used = ++phfs_cache_common.tick;
+			return phfs_cache_common.data[set][way];
+		}
+
+		if ((line[victim].valid != 0) && ((line[way].valid == 0) || (line[way].used < line[victim].used))) {
+			victim = way;
+		}
+	}
+
+	line[victim].valid = 0;
+	res = devs_read(major, minor, blk * PHFS_CACHE_BLKSZ, phfs_cache_common.data[set][victim], PHFS_CACHE_BLKSZ, timeout);
+	if (res != PHFS_CACHE_BLKSZ) {
+		return NULL;
+	}
+
+	line[victim].blk = blk;
+	line[victim].major = major;
+	line[victim].minor = minor;
+	line[victim].valid = 1;
+	line[victim].used = ++phfs_cache_common.tick;
+
+	return phfs_cache_common.data[set][victim];
+}
+
+
+ssize_t phfs_cacheRead(unsigned int major, unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
+{
+	size_t done = 0, pos, chunk;
+	const u8 *data;
+	ssize_t res;
+
+	if ((devs_flags(major, minor) & DEV_FLAG_RDCACHE) == 0) {
+		return devs_read(major, minor, offs, buff, len, timeout);
+	}
+
+	while (done < len) {
+		pos = (offs + done) % PHFS_CACHE_BLKSZ;
+		chunk = min(len - done, PHFS_CACHE_BLKSZ - pos);
+
+		/* Whole blocks are read directly, so large segments don't evict headers and tables */
+		if ((pos == 0) && ((len - done) >= PHFS_CACHE_BLKSZ)) {
+			chunk = (len - done) - ((len - done) % PHFS_CACHE_BLKSZ);
+			data = NULL;
+		}
+		else {
+			data = phfs_cacheGet(major, minor, (offs + done) / PHFS_CACHE_BLKSZ, timeout);
+		}
+
+		if (data != NULL) {
+			hal_memcpy((u8 *)buff + done, data + pos, chunk);
+		}
+		else {
+			/* Direct read, also when block can't be read as a whole (e.g. at the end of device) */
+			res = devs_read(major, minor, offs + done, (u8 *)buff + done, chunk, timeout);
+			if (res < 0) {
+				return (done != 0) ? (ssize_t)done : res;
+			}
+			if (res == 0) {
+				break;
+			}
+			chunk = res;
+		}
+
+		done += chunk;
+	}
+
+	return done;
+}
+
+
+void phfs_cacheInval(unsigned int major, unsigned int minor)
+{
+	unsigned int set, way;
+
+	for (set = 0; set < PHFS_CACHE_SETS; set++) {
+		for (way = 0; way < PHFS_CACHE_WAYS; way++) {
+			if ((phfs_cache_common.lines[set][way].major == major) && (phfs_cache_common.lines[set][way].minor == minor)) {
+				phfs_cache_common.lines[set][way].valid = 0;
+			}
+		}
+	}
+}
+
+#else
+
+ssize_t phfs_cacheRead(unsigned int major, unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout)
+{
+	return devs_read(major, minor, offs, buff, len, timeout);
+}
+
+
+void phfs_cacheInval(unsigned int major, unsigned int minor)
+{
+	(void)major;
+	(void)minor;
+}
+
+#endif
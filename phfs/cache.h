@@ -0,0 +1,25 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * phfs read cache
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _PHFS_CACHE_H_
+#define _PHFS_CACHE_H_
+
+#include <hal/hal.h>
+
+
+/* Reads data from device through the cache, if the device has DEV_FLAG_RDCACHE set */
+extern ssize_t phfs_cacheRead(unsigned int major, unsigned int minor, addr_t offs, void *buff, size_t len, time_t timeout);
+
+
+#endif
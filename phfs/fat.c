@@ -0,0 +1,622 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Read-only FAT32 file system
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "fat.h"
+#include "cache.h"
+
+#include <hal/hal.h>
+#include <lib/lib.h>
+
+
+#define FAT_SECTOR_SIZE 512
+#define FAT_FILES       4
+#define FAT_TIMEOUT_MS  500
+
+#define FAT_ENTRY_SIZE  32
+#define FAT_ATTR_VOLUME 0x08
+#define FAT_ATTR_DIR    0x10
+#define FAT_ATTR_LFN    0x0f
+#define FAT_LFN_LAST    0x40
+#define FAT_LFN_CHARS   13
+#define FAT_LFN_ENTRIES 20 /* Entries for the longest name of 255 characters */
+#define FAT_DELETED     0xe5
+#define FAT_EOC         0x0ffffff8u
+
+
+typedef struct {
+	unsigned int major;
+	unsigned int minor;
+	u32 fatStart;   /* First sector of FAT */
+	u32 dataStart;  /* Sector of cluster 2 */
+	u32 clusterCnt; /* Number of data clusters */
+	u32 rootCluster;
+	unsigned int spcShift; /* log2 of sectors per cluster */
+} fat_vol_t;
+
+
+typedef struct {
+	fat_vol_t vol;
+	u32 first; /* First cluster, 0 for empty file */
+	u32 size;
+	u32 idx;     /* Position in the cluster chain cached from the last read */
+	u32 cluster; /* Cluster number at idx */
+	u8 used;
+} fat_file_t;
+
+
+typedef struct {
+	u8 data[FAT_SECTOR_SIZE];
+	unsigned int major;
+	unsigned int minor;
+	u32 sector;
+	u8 valid;
+} fat_buf_t;
+
+
+static struct {
+	fat_file_t files[FAT_FILES];
+
+	/* Separate buffers, so following the cluster chain doesn't evict the directory sector */
+	fat_buf_t fat;
+	fat_buf_t dir;
+
+	char lfn[FAT_LFN_ENTRIES * FAT_LFN_CHARS];
+} fat_common;
+
+
+static u16 fat_le16(const u8 *p)
+{
+	return (u16)p[0] | ((u16)p[1] << 8);
+}
+
+
+static u32 fat_le32(const u8 *p)
+{
+	return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+
+static char fat_toLower(char c)
+{
+	return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+}
+
+
+static int fat_nameCmp(const char *name, size_t nameLen, const char *s, size_t len)
+{
+	size_t i;
+
+	if (nameLen != len) {
+		return -1;
+	}
+
+	for (i = 0; i < len; i++) {
+		if (fat_toLower(name[i]) != fat_toLower(s[i])) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+static int fat_devRead(unsigned int major, unsigned int minor, u32 sector, size_t offs, void *buff, size_t len)
+{
+	ssize_t res;
+
+	/* Device offsets are limited by addr_t */
+	if ((sector + ((offs + len + FAT_SECTOR_SIZE - 1) / FAT_SECTOR_SIZE)) > ((addr_t)-1 / FAT_SECTOR_SIZE)) {
+		return -ERANGE;
+	}
+
+	res = phfs_cacheRead(major, minor, (addr_t)sector * FAT_SECTOR_SIZE + offs, buff, len, FAT_TIMEOUT_MS);
+	if (res < 0) {
+		return res;
+	}
+
+	return (res == (ssize_t)len) ? EOK : -EIO;
+}
+
+
+static const u8 *fat_sectorGet(fat_buf_t *buf, unsigned int major, unsigned int minor, u32 sector)
+{
+	if ((buf->valid != 0) && (buf->sector == sector) && (buf->major == major) && (buf->minor == minor)) {
+		return buf->data;
+	}
+
+	buf->valid = 0;
+	if (fat_devRead(major, minor, sector, 0, buf->data, FAT_SECTOR_SIZE) < 0) {
+		return NULL;
+	}
+
+	buf->major = major;
+	buf->minor = minor;
+	buf->sector = sector;
+	buf->valid = 1;
+
+	return buf->data;
+}
+
+
+static int fat_clusterValid(const fat_vol_t *vol, u32 cluster)
+{
+	return (cluster >= 2) && ((cluster - 2) < vol->clusterCnt);
+}
+
+
+static u32 fat_clusterSector(const fat_vol_t *vol, u32 cluster)
+{
+	return vol->dataStart + ((cluster - 2) << vol->spcShift);
+}
+
+
+/* Returns next cluster in the chain or FAT_EOC */
+static int fat_next(const fat_vol_t *vol, u32 cluster, u32 *next)
+{
+	const u32 perSector = FAT_SECTOR_SIZE / sizeof(u32);
+	const u8 *data;
+
+	data = fat_sectorGet(&fat_common.fat, vol->major, vol->minor, vol->fatStart + cluster / perSector);
+	if (data == NULL) {
+		return -EIO;
+	}
+
+	*next = fat_le32(data + (cluster % perSector) * sizeof(u32)) & 0x0fffffffu;
+	if (*next >= FAT_EOC) {
+		*next = FAT_EOC;
+	}
+	else if (fat_clusterValid(vol, *next) == 0) {
+		return -EIO;
+	}
+
+	return EOK;
+}
+
+
+static int fat_bpbCheck(const u8 *b)
+{
+	u8 spc = b[13];
+
+	return ((b[0] == 0xeb) || (b[0] == 0xe9)) &&
+		(fat_le16(b + 11) == FAT_SECTOR_SIZE) &&
+		(spc != 0) && ((spc & (spc - 1)) == 0) &&
+		(fat_le16(b + 14) != 0) && (b[16] != 0) &&
+		(fat_le16(b + 17) == 0) && (fat_le16(b + 22) == 0) && (fat_le32(b + 36) != 0);
+}
+
+
+static int fat_mount(unsigned int major, unsigned int minor, fat_vol_t *vol)
+{
+	const u8 *b, *p;
+	u32 part = 0, total, fatSz, maxClusters;
+	unsigned int i;
+
+	b = fat_sectorGet(&fat_common.dir, major, minor, 0);
+	if (b == NULL) {
+		return -EIO;
+	}
+
+	if ((b[510] != 0x55) || (b[511] != 0xaa)) {
+		return -ENXIO;
+	}
+
+	/* Volume starts at the beginning of the device or in the first FAT32 partition from MBR */
+	if (fat_bpbCheck(b) == 0) {
+		for (i = 0; i < 4; i++) {
+			p = b + 446 + 16 * i;
+			if ((p[4] == 0x0b) || (p[4] == 0x0c) || (p[4] == 0x1b) || (p[4] == 0x1c)) {
+				part = fat_le32(p + 8);
+				break;
+			}
+		}
+
+		if (part == 0) {
+			return -ENXIO;
+		}
+
+		b = fat_sectorGet(&fat_common.dir, major, minor, part);
+		if (b == NULL) {
+			return -EIO;
+		}
+
+		if ((b[510] != 0x55) || (b[511] != 0xaa) || (fat_bpbCheck(b) == 0)) {
+			return -ENXIO;
+		}
+	}
+
+	vol->major = major;
+	vol->minor = minor;
+
+	for (vol->spcShift = 0; (1u << vol->spcShift) < b[13]; vol->spcShift++) {
+	}
+
+	fatSz = fat_le32(b + 36);
+	total = (fat_le16(b + 19) != 0) ? fat_le16(b + 19) : fat_le32(b + 32);
+	vol->fatStart = part + fat_le16(b + 14);
+	vol->dataStart = vol->fatStart + b[16] * fatSz;
+	vol->rootCluster = fat_le32(b + 44);
+
+	if ((part + total) <= vol->dataStart) {
+		return -ENXIO;
+	}
+
+	vol->clusterCnt = (part + total - vol->dataStart) >> vol->spcShift;
+	maxClusters = fatSz * (FAT_SECTOR_SIZE / sizeof(u32)) - 2;
+	if (vol->clusterCnt > maxClusters) {
+		vol->clusterCnt = maxClusters;
+	}
+
+	if (fat_clusterValid(vol, vol->rootCluster) == 0) {
+		return -ENXIO;
+	}
+
+	return EOK;
+}
+
+
+static u8 fat_sfnChecksum(const u8 *e)
+{
+	u8 sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < 11; i++) {
+		sum = (u8)(((sum & 1u) << 7) + (sum >> 1) + e[i]);
+	}
+
+	return sum;
+}
+
+
+/* Stores characters of the long name entry, returns number of characters before terminator */
+static unsigned int fat_lfnStore(const u8 *e, unsigned int pos)
+{
+	static const u8 offs[FAT_LFN_CHARS] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+	unsigned int i;
+	u16 c;
+
+	for (i = 0; i < FAT_LFN_CHARS; i++) {
+		c = fat_le16(e + offs[i]);
+		if (c == 0) {
+			break;
+		}
+		/* Names are compared as ASCII, other characters never match */
+		fat_common.lfn[pos + i] = (c < 0x80) ? (char)c : '\x7f';
+	}
+
+	return i;
+}
+
+
+static size_t fat_sfnGet(const u8 *e, char *name)
+{
+	size_t len = 0, i;
+
+	for (i = 0; (i < 8) && (e[i] != ' '); i++) {
+		name[len++] = ((i == 0) && (e[0] == 0x05)) ? (char)FAT_DELETED : (char)e[i];
+	}
+
+	if (e[8] != ' ') {
+		name[len++] = '.';
+		for (i = 8; (i < 11) && (e[i] != ' '); i++) {
+			name[len++] = (char)e[i];
+		}
+	}
+
+	return len;
+}
+
+
+/* Finds entry named s in the directory, matches long and short names case-insensitively */
+static int fat_dirFind(const fat_vol_t *vol, u32 cluster, const char *s, size_t len, u32 *first, u32 *size, u8 *attr)
+{
+	const u8 *data, *e;
+	char sfn[12];
+	u32 sector, n, steps = 0;
+	unsigned int i, seq, expected = 0, lfnLen = 0;
+	u8 chk = 0;
+	int res;
+
+	for (;;) {
+		for (sector = 0; sector < (1u << vol->spcShift); sector++) {
+			data = fat_sectorGet(&fat_common.dir, vol->major, vol->minor, fat_clusterSector(vol, cluster) + sector);
+			if (data == NULL) {
+				return -EIO;
+			}
+
+			for (i = 0; i < FAT_SECTOR_SIZE; i += FAT_ENTRY_SIZE) {
+				e = data + i;
+
+				if (e[0] == 0) {
+					return -ENOENT;
+				}
+
+				if (e[0] == FAT_DELETED) {
+					expected = 0;
+					continue;
+				}
+
+				if (e[11] == FAT_ATTR_LFN) {
+					seq = e[0] & 0x1fu;
+					if ((e[0] & FAT_LFN_LAST) != 0) {
+						lfnLen = 0;
+						expected = seq;
+						chk = e[13];
+						if ((seq != 0) && (seq <= FAT_LFN_ENTRIES)) {
+							lfnLen = (seq - 1) * FAT_LFN_CHARS;
+							lfnLen += fat_lfnStore(e, lfnLen);
+						}
+						else {
+							expected = 0;
+						}
+					}
+					else if ((expected != 0) && (seq == (expected - 1)) && (seq != 0) && (e[13] == chk)) {
+						(void)fat_lfnStore(e, (seq - 1) * FAT_LFN_CHARS);
+					}
+					else {
+						expected = 0;
+						continue;
+					}
+					expected = seq;
+					continue;
+				}
+
+				if ((e[11] & FAT_ATTR_VOLUME) != 0) {
+					expected = 0;
+					continue;
+				}
+
+				/* Long name is valid, when all its parts preceded the short entry */
+				res = ((expected == 1) && (fat_sfnChecksum(e) == chk)) ? fat_nameCmp(fat_common.lfn, lfnLen, s, len) : -1;
+				if (res != 0) {
+					res = fat_nameCmp(sfn, fat_sfnGet(e, sfn), s, len);
+				}
+				expected = 0;
+
+				if (res == 0) {
+					*first = ((u32)fat_le16(e + 20) << 16) | fat_le16(e + 26);
+					*size = fat_le32(e + 28);
+					*attr = e[11];
+					return EOK;
+				}
+			}
+		}
+
+		res = fat_next(vol, cluster, &n);
+		if (res < 0) {
+			return res;
+		}
+
+		/* Protect against cycles in corrupted FAT */
+		if ((n == FAT_EOC) || (++steps > vol->clusterCnt)) {
+			return -ENOENT;
+		}
+		cluster = n;
+	}
+}
+
+
+static int fat_lookup(const fat_vol_t *vol, const char *path, u32 *first, u32 *size)
+{
+	u32 cluster = vol->rootCluster;
+	u8 attr = FAT_ATTR_DIR;
+	size_t len;
+	int res;
+
+	for (;;) {
+		while (*path == '/') {
+			path++;
+		}
+
+		if (*path == '\0') {
+			break;
+		}
+
+		if ((attr & FAT_ATTR_DIR) == 0) {
+			return -ENOTDIR;
+		}
+
+		for (len = 0; (path[len] != '\0') && (path[len] != '/'); len++) {
+		}
+
+		res = fat_dirFind(vol, cluster, path, len, first, size, &attr);
+		if (res < 0) {
+			return res;
+		}
+
+		/* ".." pointing to the root directory */
+		cluster = (*first != 0) ? *first : vol->rootCluster;
+		path += len;
+	}
+
+	if ((attr & FAT_ATTR_DIR) != 0) {
+		return -EISDIR;
+	}
+
+	if ((*first != 0) && (fat_clusterValid(vol, *first) == 0)) {
+		return -EIO;
+	}
+
+	return EOK;
+}
+
+
+static fat_file_t *fat_fileGet(unsigned int fd, unsigned int major, unsigned int minor)
+{
+	fat_file_t *file;
+
+	if (fd >= FAT_FILES) {
+		return NULL;
+	}
+
+	file = &fat_common.files[fd];
+
+	return ((file->used != 0) && (file->vol.major == major) && (file->vol.minor == minor)) ? file : NULL;
+}
+
+
+int fat_open(const char *file, unsigned int major, unsigned int minor, unsigned int flags)
+{
+	fat_file_t *f = NULL;
+	unsigned int fd;
+	int res;
+
+	if (file == NULL) {
+		return -EINVAL;
+	}
+
+	if ((flags & (PHFS_OPEN_RDWR | PHFS_OPEN_CREATE)) != 0) {
+		return -EROFS;
+	}
+
+	for (fd = 0; fd < FAT_FILES; fd++) {
+		if (fat_common.files[fd].used == 0) {
+			f = &fat_common.files[fd];
+			break;
+		}
+	}
+
+	if (f == NULL) {
+		return -EMFILE;
+	}
+
+	/* Device could have been modified since the last open */
+	fat_common.fat.valid = 0;
+	fat_common.dir.valid = 0;
+
+	res = fat_mount(major, minor, &f->vol);
+	if (res < 0) {
+		log_error("\nfat: %d.%d - no FAT32 volume", major, minor);
+		return res;
+	}
+
+	res = fat_lookup(&f->vol, file, &f->first, &f->size);
+	if (res < 0) {
+		return res;
+	}
+
+	f->idx = 0;
+	f->cluster = f->first;
+	f->used = 1;
+
+	return fd;
+}
+
+
+/* Moves cached chain position to cluster with the given index */
+static int fat_seek(fat_file_t *file, u32 idx)
+{
+	u32 next;
+	int res;
+
+	if (idx < file->idx) {
+		file->idx = 0;
+		file->cluster = file->first;
+	}
+
+	while (file->idx < idx) {
+		res = fat_next(&file->vol, file->cluster, &next);
+		if (res < 0) {
+			return res;
+		}
+
+		if (next == FAT_EOC) {
+			return -EIO;
+		}
+
+		file->cluster = next;
+		file->idx++;
+	}
+
+	return EOK;
+}
+
+
+ssize_t fat_read(unsigned int fd, unsigned int major, unsigned int minor, addr_t offs, void *buff, size_t len)
+{
+	fat_file_t *file = fat_fileGet(fd, major, minor);
+	size_t done = 0, csz, pos, run, chunk;
+	u32 start, next;
+	int res;
+
+	if (file == NULL) {
+		return -EBADF;
+	}
+
+	csz = (size_t)FAT_SECTOR_SIZE << file->vol.spcShift;
+
+	if (offs >= file->size) {
+		return 0;
+	}
+
+	len = min(len, file->size - offs);
+
+	while (done < len) {
+		res = fat_seek(file, (offs + done) / csz);
+		if (res < 0) {
+			return res;
+		}
+
+		/* Consecutive clusters are read at once */
+		start = file->cluster;
+		pos = (offs + done) % csz;
+		run = csz - pos;
+		while (run < (len - done)) {
+			res = fat_next(&file->vol, file->cluster, &next);
+			if ((res < 0) || (next != (file->cluster + 1))) {
+				break;
+			}
+			file->cluster = next;
+			file->idx++;
+			run += csz;
+		}
+
+		chunk = min(run, len - done);
+		res = fat_devRead(major, minor, fat_clusterSector(&file->vol, start), pos, (u8 *)buff + done, chunk);
+		if (res < 0) {
+			return res;
+		}
+
+		done += chunk;
+	}
+
+	return done;
+}
+
+
+int fat_stat(unsigned int fd, unsigned int major, unsigned int minor, phfs_stat_t *stat)
+{
+	const fat_file_t *file = fat_fileGet(fd, major, minor);
+
+	if (file == NULL) {
+		return -EBADF;
+	}
+
+	stat->size = file->size;
+
+	return EOK;
+}
+
+
+int fat_close(unsigned int fd, unsigned int major, unsigned int minor)
+{
+	fat_file_t *file = fat_fileGet(fd, major, minor);
+
+	if (file == NULL) {
+		return -EBADF;
+	}
+
+	file->used = 0;
+
+	return EOK;
+}
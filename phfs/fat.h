@@ -0,0 +1,35 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Operating system loader
+ *
+ * Read-only FAT32 file system
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#ifndef _FAT_H_
+#define _FAT_H_
+
+
+#include "phfs.h"
+#include <hal/hal.h>
+
+
+extern int fat_open(const char *file, unsigned int major, unsigned int minor, unsigned int flags);
+
+
+extern ssize_t fat_read(unsigned int fd, unsigned int major, unsigned int minor, addr_t offs, void *buff, size_t len);
+
+
+extern int fat_stat(unsigned int fd, unsigned int major, unsigned int minor, phfs_stat_t *stat);
+
+
+extern int fat_close(unsigned int fd, unsigned int major, unsigned int minor);
+
+
+#endif
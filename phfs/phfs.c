@@ -15,11 +15,23 @@
 
 #include "phfs.h"
 #include "phoenixd.h"
+#include "cache.h"
+#include "fat.h"
 
 #include <lib/lib.h>
 
 #define SIZE_PHFS_HANDLERS 8
 #define SIZE_PHFS_ALIASES  32
+#define SIZE_PHFS_PTABLES  2  /* Devices with cached partition table */
+#define SIZE_PHFS_PARTS    16 /* Partitions per table */
+#define SIZE_PHFS_VIEWS    4  /* Simultaneously opened views at an offset inside partitions */
+
+/* Handler ids of partitions and views follow aliases */
+#define PHFS_ID_PARTS SIZE_PHFS_ALIASES
+#define PHFS_ID_VIEWS (PHFS_ID_PARTS + SIZE_PHFS_PTABLES * SIZE_PHFS_PARTS)
+
+/* Partition table buffer size for SIZE_PHFS_PARTS partitions */
+#define SIZE_PHFS_PTABLE (sizeof(ptable_t) + SIZE_PHFS_PARTS * sizeof(ptable_part_t) + sizeof(ptable_magic))
 
 #define PHFS_TIMEOUT_MS 500
 
@@ -29,6 +41,7 @@ typedef struct {
 	unsigned int major;
 	unsigned int minor;
 	unsigned int prot;
+	u8 ptable; /* Index of the cached partition table + 1, 0 if not loaded */
 } phfs_device_t;
 
 
@@ -39,12 +52,29 @@ typedef struct {
 } phfs_file_t;
 
 
+typedef struct {
+	phfs_file_t parts[SIZE_PHFS_PARTS];
+	unsigned int count; /* Table is free if 0 */
+} phfs_ptable_t;
+
+
+typedef struct {
+	phfs_file_t file; /* Alias is not used */
+	unsigned int pd;
+	unsigned int refs; /* View is free if 0 */
+} phfs_view_t;
+
+
 struct {
 	phfs_device_t devices[SIZE_PHFS_HANDLERS];
 	unsigned int dCnt;
 
 	phfs_file_t files[SIZE_PHFS_ALIASES];
 	unsigned int fCnt;
+
+	/* Partitions cached from partition tables */
+	phfs_ptable_t ptables[SIZE_PHFS_PTABLES];
+	phfs_view_t views[SIZE_PHFS_VIEWS];
 } phfs_common;
 
 
@@ -57,6 +87,9 @@ static const char *phfs_getProtName(unsigned int id)
 		case phfs_prot_phoenixd:
 			return "phoenixd";
 
+		case phfs_prot_fat:
+			return "fat";
+
 		default:
 			return "";
 	}
@@ -69,6 +102,8 @@ static int phfs_setProt(phfs_device_t *pd, const char *prot)
 		pd->prot = phfs_prot_raw;
 	else if (hal_strcmp(prot, "phoenixd") == 0)
 		pd->prot = phfs_prot_phoenixd;
+	else if (hal_strcmp(prot, "fat") == 0)
+		pd->prot = phfs_prot_fat;
 	else
 		return -EINVAL;
 
@@ -91,6 +126,35 @@ static int phfs_getHandlerId(const char *alias)
 }
 
 
+/* Returns file referenced by the raw protocol handler - alias, partition or view */
+static phfs_file_t *phfs_getFile(handler_t h)
+{
+	unsigned int id;
+	phfs_ptable_t *ptable;
+	phfs_view_t *view;
+
+	if (h.id < phfs_common.fCnt) {
+		return &phfs_common.files[h.id];
+	}
+
+	if ((h.id >= PHFS_ID_PARTS) && (h.id < PHFS_ID_VIEWS)) {
+		id = h.id - PHFS_ID_PARTS;
+		ptable = &phfs_common.ptables[id / SIZE_PHFS_PARTS];
+		if ((phfs_common.devices[h.pd].ptable == (id / SIZE_PHFS_PARTS) + 1) && ((id % SIZE_PHFS_PARTS) < ptable->count)) {
+			return &ptable->parts[id % SIZE_PHFS_PARTS];
+		}
+	}
+	else if ((h.id >= PHFS_ID_VIEWS) && (h.id < (PHFS_ID_VIEWS + SIZE_PHFS_VIEWS))) {
+		view = &phfs_common.views[h.id - PHFS_ID_VIEWS];
+		if ((view->pd == h.pd) && (view->refs != 0)) {
+			return &view->file;
+		}
+	}
+
+	return NULL;
+}
+
+
 int phfs_devReg(const char *alias, unsigned int major, unsigned int minor, const char *prot)
 {
 	size_t sz;
@@ -117,8 +181,8 @@ int phfs_devReg(const char *alias, unsigned int major, unsigned int minor, const
 
 	pd = &phfs_common.devices[phfs_common.dCnt];
 	if (phfs_setProt(pd, prot) < 0) {
-		log_error("\nphfs: %s - wrong protocol name\n\t use: \"%s\", \"%s\"", prot,
-			phfs_getProtName(phfs_prot_raw), phfs_getProtName(phfs_prot_phoenixd));
+		log_error("\nphfs: %s - wrong protocol name\n\t use: \"%s\", \"%s\", \"%s\"", prot,
+			phfs_getProtName(phfs_prot_raw), phfs_getProtName(phfs_prot_phoenixd), phfs_getProtName(phfs_prot_fat));
 		return -EINVAL;
 	}
 
@@ -166,10 +230,12 @@ int phfs_devGet(const char *alias, unsigned int *retMajor, unsigned int *retMino
 
 int phfs_aliasAddrResolve(handler_t h, addr_t *addr)
 {
-	if (h.id >= SIZE_PHFS_ALIASES || h.id >= phfs_common.fCnt)
+	const phfs_file_t *file = phfs_getFile(h);
+
+	if (file == NULL)
 		return -EINVAL;
 
-	*addr = phfs_common.files[h.id].addr;
+	*addr = file->addr;
 
 	return EOK;
 }
@@ -195,10 +261,18 @@ void phfs_devsShow(void)
 
 void phfs_aliasesShow(void)
 {
-	int i;
+	int i, j;
 	phfs_file_t *f;
+	phfs_device_t *pd;
+	phfs_ptable_t *ptable;
 
-	if (phfs_common.fCnt == 0) {
+	for (i = 0; i < phfs_common.dCnt; ++i) {
+		if (phfs_common.devices[i].ptable != 0) {
+			break;
+		}
+	}
+
+	if ((phfs_common.fCnt == 0) && (i == phfs_common.dCnt)) {
 		log_error("\nphfs: None of the files have been registered\n");
 		return;
 	}
@@ -208,6 +282,19 @@ void phfs_aliasesShow(void)
 		f = &phfs_common.files[i];
 		lib_printf("%-32s 0x%08x 0x%08x\n", f->alias, f->addr, f->size);
 	}
+
+	for (i = 0; i < phfs_common.dCnt; ++i) {
+		pd = &phfs_common.devices[i];
+		if (pd->ptable == 0) {
+			continue;
+		}
+
+		ptable = &phfs_common.ptables[pd->ptable - 1];
+		for (j = 0; j < ptable->count; ++j) {
+			f = &ptable->parts[j];
+			lib_printf("%s:%-*s 0x%08x 0x%08x\n", pd->alias, 31 - (int)hal_strlen(pd->alias), f->alias, f->addr, f->size);
+		}
+	}
 }
 
 
@@ -261,10 +348,197 @@ int phfs_aliasReg(const char *alias, addr_t addr, size_t size)
 }
 
 
+/* Reads partition table from the last block of the device and caches its partitions */
+static int phfs_ptableLoad(unsigned int pdId)
+{
+	int res;
+	unsigned int i, t;
+	size_t memsz, blksz, len, nameSz;
+	addr_t offs;
+	ptable_t *ptable;
+	phfs_file_t *part;
+	phfs_device_t *pd = &phfs_common.devices[pdId];
+	u32 buff[(SIZE_PHFS_PTABLE + sizeof(u32) - 1) / sizeof(u32)];
+
+	if (pd->ptable != 0) {
+		return EOK;
+	}
+
+	/* Table slot is taken only after all partitions have been read and validated */
+	for (t = 0; t < SIZE_PHFS_PTABLES; t++) {
+		if (phfs_common.ptables[t].count == 0) {
+			break;
+		}
+	}
+
+	if (t == SIZE_PHFS_PTABLES) {
+		log_error("\nphfs: Exceeded max number of partition tables");
+		return -ENOMEM;
+	}
+
+	if ((devs_control(pd->major, pd->minor, DEV_CONTROL_GETPROP_TOTALSZ, &memsz) != EOK) ||
+			(devs_control(pd->major, pd->minor, DEV_CONTROL_GETPROP_BLOCKSZ, &blksz) != EOK)) {
+		return -ENXIO;
+	}
+
+	ptable = (ptable_t *)buff;
+	offs = memsz - blksz;
+
+	res = phfs_cacheRead(pd->major, pd->minor, offs, ptable, sizeof(ptable->count), PHFS_TIMEOUT_MS);
+	if (res < 0) {
+		return res;
+	}
+
+	if ((ptable->count == 0) || (ptable->count > SIZE_PHFS_PARTS)) {
+		log_error("\nphfs: %s - no partition table or too many partitions", pd->alias);
+		return -EINVAL;
+	}
+
+	len = sizeof(ptable_t) + ptable->count * sizeof(ptable_part_t) + sizeof(ptable_magic);
+	res = phfs_cacheRead(pd->major, pd->minor, offs, ptable, len, PHFS_TIMEOUT_MS);
+	if (res < 0) {
+		return res;
+	}
+
+	res = ptable_deserialize(ptable, memsz, blksz);
+	if (res < 0) {
+		log_error("\nphfs: %s - invalid partition table", pd->alias);
+		return res;
+	}
+
+	for (i = 0; i < ptable->count; i++) {
+		part = &phfs_common.ptables[t].parts[i];
+		nameSz = min(sizeof(ptable->parts[i].name), sizeof(part->alias) - 1);
+		hal_memcpy(part->alias, ptable->parts[i].name, nameSz);
+		part->alias[nameSz] = '\0';
+		part->addr = ptable->parts[i].offset;
+		part->size = ptable->parts[i].size;
+	}
+
+	phfs_common.ptables[t].count = ptable->count;
+	pd->ptable = t + 1;
+
+	return EOK;
+}
+
+
+/* Drops cached partition table, if the range modified on the device overlaps its block */
+static void phfs_ptableDrop(phfs_device_t *pd, addr_t offs, size_t len)
+{
+	size_t memsz, blksz;
+
+	if (pd->ptable == 0) {
+		return;
+	}
+
+	if ((devs_control(pd->major, pd->minor, DEV_CONTROL_GETPROP_TOTALSZ, &memsz) == EOK) &&
+			(devs_control(pd->major, pd->minor, DEV_CONTROL_GETPROP_BLOCKSZ, &blksz) == EOK) &&
+			((offs + len) >= offs) && ((offs + len) <= (memsz - blksz))) {
+		return;
+	}
+
+	/* Table is read again on the next partition open */
+	phfs_common.ptables[pd->ptable - 1].count = 0;
+	pd->ptable = 0;
+}
+
+
+/* Resolves partname[/offset] on the device, returns handler id */
+static int phfs_partOpen(unsigned int pdId, const char *file)
+{
+	int res;
+	unsigned int i;
+	size_t nameSz;
+	addr_t offs = 0, addr;
+	char *endptr;
+	const char *sep;
+	phfs_ptable_t *ptable;
+	phfs_file_t *part = NULL;
+	phfs_view_t *view, *unused = NULL;
+
+	sep = hal_strchr(file, '/');
+	if (sep != NULL) {
+		nameSz = sep - file;
+		offs = lib_strtoul((char *)sep + 1, &endptr, 0);
+		if ((*endptr != '\0') || (endptr == (sep + 1))) {
+			return -EINVAL;
+		}
+	}
+	else {
+		nameSz = hal_strlen(file);
+	}
+
+	res = phfs_ptableLoad(pdId);
+	if (res < 0) {
+		return res;
+	}
+
+	ptable = &phfs_common.ptables[phfs_common.devices[pdId].ptable - 1];
+	for (i = 0; i < ptable->count; i++) {
+		if ((hal_strncmp(ptable->parts[i].alias, file, nameSz) == 0) && (ptable->parts[i].alias[nameSz] == '\0')) {
+			part = &ptable->parts[i];
+			break;
+		}
+	}
+
+	if (part == NULL) {
+		return -ENOENT;
+	}
+
+	if (offs == 0) {
+		return PHFS_ID_PARTS + (phfs_common.devices[pdId].ptable - 1) * SIZE_PHFS_PARTS + i;
+	}
+
+	if (offs >= part->size) {
+		return -EINVAL;
+	}
+
+	/* Share view at the same location, if already opened */
+	addr = part->addr + offs;
+	for (i = 0; i < SIZE_PHFS_VIEWS; i++) {
+		view = &phfs_common.views[i];
+		if (view->refs == 0) {
+			if (unused == NULL) {
+				unused = view;
+			}
+		}
+		else if ((view->pd == pdId) && (view->file.addr == addr)) {
+			view->refs++;
+			return PHFS_ID_VIEWS + i;
+		}
+	}
+
+	if (unused == NULL) {
+		log_error("\nphfs: Exceeded max number of opened views");
+		return -ENOMEM;
+	}
+
+	unused->file.alias[0] = '\0';
+	unused->file.addr = addr;
+	unused->file.size = part->size - offs;
+	unused->pd = pdId;
+	unused->refs = 1;
+
+	return PHFS_ID_VIEWS + (unused - phfs_common.views);
+}
+
+
 int phfs_open(const char *alias, const char *file, unsigned int flags, handler_t *handler)
 {
 	int res;
+	size_t sz;
 	phfs_device_t *pd;
+	char dev[sizeof(pd->alias)];
+	const char *sep = hal_strchr(alias, ':');
+
+	/* dev:partname[/offset] */
+	if ((sep != NULL) && (file == NULL)) {
+		sz = min((size_t)(sep - alias), sizeof(dev) - 1);
+		hal_memcpy(dev, alias, sz);
+		dev[sz] = '\0';
+		alias = dev;
+		file = sep + 1;
+	}
 
 	res = phfs_getHandlerId(alias);
 	if (res < 0) {
@@ -288,6 +562,15 @@ int phfs_open(const char *alias, const char *file, unsigned int flags, handler_t
 			handler->id = res;
 			break;
 
+		case phfs_prot_fat:
+			res = fat_open(file, pd->major, pd->minor, flags);
+			if (res < 0) {
+				return res;
+			}
+
+			handler->id = res;
+			break;
+
 		case phfs_prot_raw:
 			/* NULL file means that phfs refers to raw device data */
 			handler->id = -1;
@@ -297,7 +580,10 @@ int phfs_open(const char *alias, const char *file, unsigned int flags, handler_t
 
 			res = phfs_getAliasId(file);
 			if (res < 0) {
-				return res;
+				res = phfs_partOpen(handler->pd, file);
+				if (res < 0) {
+					return res;
+				}
 			}
 
 			handler->id = res;
@@ -325,17 +611,20 @@ ssize_t phfs_read(handler_t handler, addr_t offs, void *buff, size_t len)
 		case phfs_prot_phoenixd:
 			return phoenixd_read(handler.id, pd->major, pd->minor, offs, buff, len);
 
+		case phfs_prot_fat:
+			return fat_read(handler.id, pd->major, pd->minor, offs, buff, len);
+
 		case phfs_prot_raw:
 			/* Reading raw data from device */
 			if (handler.id == -1)
-				return devs_read(pd->major, pd->minor, offs, buff, len, PHFS_TIMEOUT_MS);
+				return phfs_cacheRead(pd->major, pd->minor, offs, buff, len, PHFS_TIMEOUT_MS);
 
-			/* Reading file defined by alias */
-			if (handler.id >= SIZE_PHFS_ALIASES)
+			/* Reading file defined by alias or partition */
+			file = phfs_getFile(handler);
+			if (file == NULL || offs > file->size)
 				return -EINVAL;
-			file = &phfs_common.files[handler.id];
 
-			return devs_read(pd->major, pd->minor, file->addr + offs, buff, min(len, file->size - offs), PHFS_TIMEOUT_MS);
+			return phfs_cacheRead(pd->major, pd->minor, file->addr + offs, buff, min(len, file->size - offs), PHFS_TIMEOUT_MS);
 
 		default:
 			break;
@@ -359,17 +648,25 @@ ssize_t phfs_write(handler_t handler, addr_t offs, const void *buff, size_t len)
 		case phfs_prot_phoenixd:
 			return phoenixd_write(handler.id, pd->major, pd->minor, offs, buff, len);
 
+		case phfs_prot_fat:
+			return -EROFS;
+
 		case phfs_prot_raw:
 			/* Writing raw data to device */
-			if (handler.id == -1)
+			if (handler.id == -1) {
+				phfs_ptableDrop(pd, offs, len);
 				return devs_write(pd->major, pd->minor, offs, buff, len);
+			}
 
-			/* Writing data to file defined by alias */
-			if (handler.id >= SIZE_PHFS_ALIASES)
+			/* Writing data to file defined by alias or partition */
+			file = phfs_getFile(handler);
+			if (file == NULL || offs > file->size)
 				return -EINVAL;
-			file = &phfs_common.files[handler.id];
 
-			return devs_write(pd->major, pd->minor, file->addr + offs, buff, min(len, file->size - offs));
+			len = min(len, file->size - offs);
+			phfs_ptableDrop(pd, file->addr + offs, len);
+
+			return devs_write(pd->major, pd->minor, file->addr + offs, buff, len);
 
 		default:
 			break;
@@ -382,6 +679,7 @@ ssize_t phfs_write(handler_t handler, addr_t offs, const void *buff, size_t len)
 ssize_t phfs_erase(handler_t handler, addr_t offs, size_t len, unsigned int flags)
 {
 	phfs_device_t *pd;
+	phfs_file_t *file;
 
 	if (handler.pd >= SIZE_PHFS_HANDLERS) {
 		return -EINVAL;
@@ -389,10 +687,23 @@ ssize_t phfs_erase(handler_t handler, addr_t offs, size_t len, unsigned int flag
 
 	pd = &phfs_common.devices[handler.pd];
 
-	if (pd->minor != DEV_STORAGE && pd->prot != phfs_prot_raw) {
+	if ((pd->minor != DEV_STORAGE && pd->prot != phfs_prot_raw) || (pd->prot == phfs_prot_fat)) {
 		return -EINVAL;
 	}
 
+	/* Erasing data of file defined by alias, partition or view */
+	if ((pd->prot == phfs_prot_raw) && (handler.id != -1)) {
+		file = phfs_getFile(handler);
+		if ((file == NULL) || (offs > file->size)) {
+			return -EINVAL;
+		}
+
+		len = min(len, file->size - offs);
+		offs += file->addr;
+	}
+
+	phfs_ptableDrop(pd, offs, len);
+
 	return devs_erase(pd->major, pd->minor, offs, len, flags);
 }
 
@@ -401,6 +712,7 @@ int phfs_close(handler_t handler)
 {
 	int res;
 	phfs_device_t *pd;
+	phfs_view_t *view;
 
 	if (handler.pd >= SIZE_PHFS_HANDLERS)
 		return -EINVAL;
@@ -413,7 +725,23 @@ int phfs_close(handler_t handler)
 				return res;
 			break;
 
+		case phfs_prot_fat:
+			res = fat_close(handler.id, pd->major, pd->minor);
+			if (res < 0) {
+				return res;
+			}
+			break;
+
 		case phfs_prot_raw:
+			/* Release view at an offset inside partition */
+			if ((handler.id >= PHFS_ID_VIEWS) && (handler.id < (PHFS_ID_VIEWS + SIZE_PHFS_VIEWS))) {
+				view = &phfs_common.views[handler.id - PHFS_ID_VIEWS];
+				if ((view->pd == handler.pd) && (view->refs != 0)) {
+					view->refs--;
+				}
+			}
+			break;
+
 		default:
 			break;
 	}
@@ -434,6 +762,11 @@ int phfs_map(handler_t handler, addr_t addr, size_t sz, int mode, addr_t memaddr
 
 	pd = &phfs_common.devices[handler.pd];
 
+	/* File data isn't contiguous on the device */
+	if (pd->prot == phfs_prot_fat) {
+		return dev_isNotMappable;
+	}
+
 	return devs_map(pd->major, pd->minor, addr, sz, mode, memaddr, memsz, memmode, a);
 }
 
@@ -455,11 +788,18 @@ int phfs_stat(handler_t handler, phfs_stat_t *stat)
 				return res;
 			break;
 
+		case phfs_prot_fat:
+			res = fat_stat(handler.id, pd->major, pd->minor, stat);
+			if (res < 0) {
+				return res;
+			}
+			break;
+
 		case phfs_prot_raw:
-			if (handler.id == -1 || handler.id >= SIZE_PHFS_ALIASES)
+			file = phfs_getFile(handler);
+			if (file == NULL)
 				return -EINVAL;
 
-			file = &phfs_common.files[handler.id];
 			stat->size = file->size;
 		default:
 			break;
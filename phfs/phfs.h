@@ -27,7 +27,7 @@
 
 
 /* clang-format off */
-enum { phfs_prot_raw = 0, phfs_prot_phoenixd };
+enum { phfs_prot_raw = 0, phfs_prot_phoenixd, phfs_prot_fat };
 /* clang-format on */
 
 
@@ -70,7 +70,9 @@ extern void phfs_aliasesShow(void);
 /* Operations on files */
 
 /* Open files based on alias to device and file name.
- * If file abstraction does not exist on device, the NULL value should be passed to file argument. */
+ * If file abstraction does not exist on device, the NULL value should be passed to file argument.
+ * On raw devices file can name a partition from the device's partition table as partname[/offset],
+ * the same can be passed as alias in form dev:partname[/offset] with NULL file. */
 extern int phfs_open(const char *alias, const char *file, unsigned int flags, handler_t *handler);
 
 
@@ -97,4 +99,8 @@ extern int phfs_map(handler_t handler, addr_t addr, size_t sz, int mode, addr_t
 extern int phfs_stat(handler_t handler, phfs_stat_t *stat);
 
 
+/* Invalidate data cached by phfs, called by devs on every write and erase of a cached device */
+extern void phfs_cacheInval(unsigned int major, unsigned int minor);
+
+
 #endif
@@ -19,6 +19,7 @@
 #include "types.h"
 
 #include "devices/console.h"
+#include "extensions/pmu.h"
 
 
 typedef struct _exc_context_t {
@@ -205,6 +206,250 @@ static void exceptions_setRegval(unsigned int regNum, u64 regVal, exc_context_t
 }
 
 
+/* Fetches trapped instruction from S/U-mode */
+static u64 exceptions_fetchInsn(exc_context_t *ctx)
+{
+	u64 insn;
+	unsigned long unpriv_insn;
+
+	/* mepc has virtual address, have to load using MPRV */
+	MPRV_LOAD(lhu, insn, ctx->mepc);
+	/* Check lowest to bits to determine if we are dealing with compressed insn
+	 * Noncompressed RV instructions have bits [1:0] = 11.
+	 */
+	if ((insn & 3) == 3) {
+		/* Noncompressed, load 2nd part */
+		MPRV_LOAD(lhu, unpriv_insn, ctx->mepc + 2);
+		insn = (unpriv_insn << 16) | insn;
+	}
+
+	return insn;
+}
+
+
+/* Loads `len` bytes from S/U-mode virtual address byte by byte.
+ * Faults are caught by a local trap vector, returns their mcause (0 on success) and sets `tval` */
+static u64 exceptions_mprvLoadBytes(addr_t addr, unsigned long len, u64 *val, u64 *tval)
+{
+	u64 res = 0, cause = 0, tvec;
+	addr_t tmp;
+
+	/* No memory accesses other than the target ones while MPRV is set */
+	/* clang-format off */
+	__asm__ volatile (
+		"la %[tvec], 3f\n\t"
+		"csrrw %[tvec], mtvec, %[tvec]\n\t"
+		"li a6, (1 << 17)\n\t"
+		"csrs mstatus, a6\n\t"
+		"1:\n\t"
+		"addi %[len], %[len], -1\n\t"
+		"add %[tmp], %[addr], %[len]\n\t"
+		"lbu %[tmp], (%[tmp])\n\t"
+		"slli %[res], %[res], 8\n\t"
+		"or %[res], %[res], %[tmp]\n\t"
+		"bnez %[len], 1b\n\t"
+		"j 4f\n\t"
+		".align 2\n\t"
+		"3:\n\t"
+		"csrr %[cause], mcause\n\t"
+		"csrr %[tval], mtval\n\t"
+		"4:\n\t"
+		"csrc mstatus, a6\n\t"
+		"csrw mtvec, %[tvec]"
+		: [res] "+r"(res), [addr] "+r"(addr), [len] "+r"(len), [tmp] "=&r"(tmp), [cause] "+r"(cause), [tval] "=&r"(*tval), [tvec] "=&r"(tvec)
+		:
+		: "a6", "memory"
+	);
+	/* clang-format on */
+
+	*val = res;
+
+	return cause;
+}
+
+
+/* Stores `len` bytes to S/U-mode virtual address byte by byte, faults are handled as in exceptions_mprvLoadBytes */
+static u64 exceptions_mprvStoreBytes(addr_t addr, u64 val, unsigned long len, u64 *tval)
+{
+	u64 cause = 0, tvec;
+
+	/* clang-format off */
+	__asm__ volatile (
+		"la %[tvec], 3f\n\t"
+		"csrrw %[tvec], mtvec, %[tvec]\n\t"
+		"li a6, (1 << 17)\n\t"
+		"csrs mstatus, a6\n\t"
+		"1:\n\t"
+		"sb %[val], (%[addr])\n\t"
+		"srli %[val], %[val], 8\n\t"
+		"addi %[addr], %[addr], 1\n\t"
+		"addi %[len], %[len], -1\n\t"
+		"bnez %[len], 1b\n\t"
+		"j 4f\n\t"
+		".align 2\n\t"
+		"3:\n\t"
+		"csrr %[cause], mcause\n\t"
+		"csrr %[tval], mtval\n\t"
+		"4:\n\t"
+		"csrc mstatus, a6\n\t"
+		"csrw mtvec, %[tvec]"
+		: [val] "+r"(val), [addr] "+r"(addr), [len] "+r"(len), [cause] "+r"(cause), [tval] "=&r"(*tval), [tvec] "=&r"(tvec)
+		:
+		: "a6", "memory"
+	);
+	/* clang-format on */
+
+	return cause;
+}
+
+
+static void exceptions_misalignedHandler(unsigned int n, exc_context_t *ctx)
+{
+	u64 prevMode = (ctx->mstatus & MSTATUS_MPP) >> MSTATUS_MPP_SHIFT;
+	u64 insn, val, cause, tval;
+	unsigned int reg = 0, len = 0, insnLen = 4;
+	int load = 0, sign = 0;
+
+	if (prevMode == PRV_M) {
+		/* Misaligned access in M-mode */
+		exceptions_defaultHandler(n, ctx);
+	}
+
+	insn = exceptions_fetchInsn(ctx);
+
+	if ((insn & 3) == 3) {
+		/* Check opcode and funct3 */
+		switch (insn & 0x707fu) {
+			case 0x1003u: /* LH */
+				len = 2;
+				sign = 1;
+				break;
+
+			case 0x2003u: /* LW */
+				len = 4;
+				sign = 1;
+				break;
+
+			case 0x3003u: /* LD */
+				len = 8;
+				break;
+
+			case 0x5003u: /* LHU */
+				len = 2;
+				break;
+
+			case 0x6003u: /* LWU */
+				len = 4;
+				break;
+
+			case 0x1023u: /* SH */
+				len = 2;
+				break;
+
+			case 0x2023u: /* SW */
+				len = 4;
+				break;
+
+			case 0x3023u: /* SD */
+				len = 8;
+				break;
+
+			default:
+				break;
+		}
+
+		load = ((insn & 0x7fu) == 0x03u) ? 1 : 0;
+		reg = (load != 0) ? ((insn >> 7) & 0x1fu) : ((insn >> 20) & 0x1fu);
+	}
+	else {
+		insnLen = 2;
+
+		/* Check quadrant and funct3 */
+		switch (insn & 0xe003u) {
+			case 0x4000u: /* C.LW */
+				len = 4;
+				sign = 1;
+				reg = ((insn >> 2) & 0x7u) + 8;
+				break;
+
+			case 0x6000u: /* C.LD */
+				len = 8;
+				reg = ((insn >> 2) & 0x7u) + 8;
+				break;
+
+			case 0xc000u: /* C.SW */
+				len = 4;
+				reg = ((insn >> 2) & 0x7u) + 8;
+				break;
+
+			case 0xe000u: /* C.SD */
+				len = 8;
+				reg = ((insn >> 2) & 0x7u) + 8;
+				break;
+
+			case 0x4002u: /* C.LWSP */
+				len = 4;
+				sign = 1;
+				reg = (insn >> 7) & 0x1fu;
+				break;
+
+			case 0x6002u: /* C.LDSP */
+				len = 8;
+				reg = (insn >> 7) & 0x1fu;
+				break;
+
+			case 0xc002u: /* C.SWSP */
+				len = 4;
+				reg = (insn >> 2) & 0x1fu;
+				break;
+
+			case 0xe002u: /* C.SDSP */
+				len = 8;
+				reg = (insn >> 2) & 0x1fu;
+				break;
+
+			default:
+				break;
+		}
+
+		load = ((insn & 0x8000u) == 0) ? 1 : 0;
+	}
+
+	if ((len == 0) || (load != ((n == MCAUSE_LOAD_MISALIGNED) ? 1 : 0))) {
+		/* FP, AMO or unknown access - let S-Mode handle it */
+		exceptions_redirect(n, ctx->mtval, ctx);
+		return;
+	}
+
+	if (load != 0) {
+		pmu_fwEvent(PMU_FW_MISALIGNED_LOAD);
+
+		cause = exceptions_mprvLoadBytes(ctx->mtval, len, &val, &tval);
+		if (cause == 0) {
+			if ((sign != 0) && (len < 8)) {
+				val = (u64)(((s64)(val << (64 - 8 * len))) >> (64 - 8 * len));
+			}
+			exceptions_setRegval(reg, val, ctx);
+		}
+	}
+	else {
+		pmu_fwEvent(PMU_FW_MISALIGNED_STORE);
+
+		cause = exceptions_mprvStoreBytes(ctx->mtval, exceptions_getRegval(reg, ctx), len, &tval);
+	}
+
+	if (cause != 0) {
+		/* Page or access fault on the emulated access - let S-Mode handle it as if raised by the instruction */
+		ctx->mcause = cause;
+		exceptions_redirect(cause, tval, ctx);
+		return;
+	}
+
+	/* Skip instruction */
+	ctx->mepc += insnLen;
+}
+
+
 static int exceptions_illSystem(unsigned int n, exc_context_t *ctx)
 {
 	/* Assuming we trapped on CSR instruction (not checked) */
@@ -287,9 +532,11 @@ static void exceptions_illegalHandler(unsigned int n, exc_context_t *ctx)
 {
 	u64 insn = ctx->mtval;
 	u64 prevMode = (ctx->mstatus & MSTATUS_MPP) >> MSTATUS_MPP_SHIFT;
-	unsigned long unpriv_insn;
 
 	int handled = 0;
+
+	pmu_fwEvent(PMU_FW_ILLEGAL_INSN);
+
 	/* Check failing instruction */
 	if (((insn & 3) == 3) && (((insn & 0x7c) >> 2) == 0x1c)) {
 		/* Non-compressed, SYSTEM opcode */
@@ -303,16 +550,7 @@ static void exceptions_illegalHandler(unsigned int n, exc_context_t *ctx)
 		}
 		else {
 			if (insn == 0) {
-				/* mepc has virtual address, have to load using MPRV */
-				MPRV_LOAD(lhu, insn, ctx->mepc);
-				/* Check lowest to bits to determine if we are dealing with compressed insn
-				 * Noncompressed RV instructions have bits [1:0] = 11.
-				 */
-				if ((insn & 3) == 3) {
-					/* Noncompressed, load 2nd part */
-					MPRV_LOAD(lhu, unpriv_insn, ctx->mepc + 2);
-					insn = (unpriv_insn << 16) | insn;
-				}
+				insn = exceptions_fetchInsn(ctx);
 			}
 			exceptions_redirect(n, insn, ctx);
 		}
@@ -322,9 +560,14 @@ static void exceptions_illegalHandler(unsigned int n, exc_context_t *ctx)
 
 void exceptions_dispatch(unsigned int n, exc_context_t *ctx)
 {
+	pmu_fwEvent(PMU_FW_PLATFORM_TRAP);
+
 	if (n == MCAUSE_ILLEGAL) {
 		exceptions_illegalHandler(n, ctx);
 	}
+	else if ((n == MCAUSE_LOAD_MISALIGNED) || (n == MCAUSE_STORE_MISALIGNED)) {
+		exceptions_misalignedHandler(n, ctx);
+	}
 	else {
 		exceptions_defaultHandler(n, ctx);
 	}
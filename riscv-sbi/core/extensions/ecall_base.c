@@ -28,11 +28,6 @@
 #define PHOENIX_SBI_VERSION 1
 
 
-/* Anchors for section which contains extension entries */
-extern const sbi_ext_t __ext_start[];
-extern const sbi_ext_t __ext_end[];
-
-
 enum {
 	BASE_GET_SPEC_VERSION = 0,
 	BASE_GET_IMPL_ID,
@@ -46,14 +41,11 @@ enum {
 
 static long ecall_base_probeExt(unsigned long extid)
 {
-	const sbi_ext_t *ext;
-	for (ext = __ext_start; ext < __ext_end; ext++) {
-		if (ext->eid == extid) {
-			return SBI_SUCCESS;
-		}
+	if ((extid > 0x7fffffffUL) || (sbi_extFind((int)extid) == NULL)) {
+		return SBI_ERR_NOT_SUPPORTED;
 	}
 
-	return SBI_ERR_NOT_SUPPORTED;
+	return SBI_SUCCESS;
 }
 
 
@@ -0,0 +1,92 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Phoenix SBI
+ *
+ * SBI Debug Console handler
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "sbi.h"
+#include "devices/console.h"
+
+#if defined(__CPU_GR765)
+#include "ld/gr765.ldt"
+#elif defined(__CPU_GRFPGA)
+#include "ld/grfpga.ldt"
+#elif defined(__CPU_GENERIC)
+#include "ld/generic.ldt"
+#else
+#error "Unsupported TARGET"
+#endif
+
+
+enum {
+	DBCN_CONSOLE_WRITE = 0,
+	DBCN_CONSOLE_READ,
+	DBCN_CONSOLE_WRITE_BYTE,
+};
+
+
+/* Checks if the physical buffer passed by S-Mode can be accessed */
+static int ecall_dbcn_bufferValid(sbi_param len, sbi_param addrLo, sbi_param addrHi)
+{
+	addr_t start = addrLo, end = addrLo + len;
+
+	if ((addrHi != 0) || (end < start)) {
+		return 0;
+	}
+
+	/* Don't let S-Mode access SBI memory */
+	if ((start < (ADDR_DDR + SIZE_SBI)) && (end > ADDR_DDR)) {
+		return 0;
+	}
+
+	return 1;
+}
+
+
+static sbiret_t ecall_dbcn_handler(sbi_param a0, sbi_param a1, sbi_param a2, sbi_param a3, sbi_param a4, sbi_param a5, int fid)
+{
+	sbiret_t ret = { 0 };
+
+	switch (fid) {
+		case DBCN_CONSOLE_WRITE:
+			if (ecall_dbcn_bufferValid(a0, a1, a2) == 0) {
+				ret.error = SBI_ERR_INVALID_PARAM;
+				break;
+			}
+			console_write((const char *)a1, a0);
+			ret.value = a0;
+			break;
+
+		case DBCN_CONSOLE_READ:
+			if (ecall_dbcn_bufferValid(a0, a1, a2) == 0) {
+				ret.error = SBI_ERR_INVALID_PARAM;
+				break;
+			}
+			ret.value = console_read((char *)a1, a0);
+			break;
+
+		case DBCN_CONSOLE_WRITE_BYTE:
+			console_putc((char)a0);
+			break;
+
+		default:
+			ret.error = SBI_ERR_NOT_SUPPORTED;
+			break;
+	}
+
+	return ret;
+}
+
+
+static const sbi_ext_t sbi_ext_dbcn __attribute__((section("extensions"), used)) = {
+	.eid = SBI_EXT_DBCN,
+	.handler = ecall_dbcn_handler,
+};
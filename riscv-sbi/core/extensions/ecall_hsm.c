@@ -40,7 +40,13 @@ static sbiret_t ecall_hsm_handler(sbi_param a0, sbi_param a1, sbi_param a2, sbi_
 			break;
 
 		case HSM_HART_STOP:
+			ret.error = hsm_hartStop();
+			break;
+
 		case HSM_HART_SUSPEND:
+			ret.error = hsm_hartSuspend(a0, a1, a2);
+			break;
+
 		default:
 			ret.error = SBI_ERR_NOT_SUPPORTED;
 			break;
@@ -17,6 +17,7 @@
 #include "sbi.h"
 
 #include "extensions/ipi.h"
+#include "extensions/pmu.h"
 
 
 enum {
@@ -28,6 +29,7 @@ static void ecall_ipi_sendIpiHandler(void *data)
 {
 	(void)data;
 
+	pmu_fwEvent(PMU_FW_IPI_RECEIVED);
 	csr_set(CSR_MIP, MIP_SSIP);
 }
 
@@ -38,6 +40,7 @@ static sbiret_t ecall_ipi_handler(sbi_param a0, sbi_param a1, sbi_param a2, sbi_
 
 	switch (fid) {
 		case IPI_SEND_IPI:
+			pmu_fwEvent(PMU_FW_IPI_SENT);
 			ret.error = sbi_ipiSendMany(a0, a1, ecall_ipi_sendIpiHandler, NULL);
 			break;
 
@@ -0,0 +1,80 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Phoenix SBI
+ *
+ * SBI PMU handler
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "sbi.h"
+
+#include "extensions/pmu.h"
+
+
+enum {
+	PMU_NUM_COUNTERS = 0,
+	PMU_COUNTER_GET_INFO,
+	PMU_COUNTER_CONFIG_MATCHING,
+	PMU_COUNTER_START,
+	PMU_COUNTER_STOP,
+	PMU_COUNTER_FW_READ,
+	PMU_COUNTER_FW_READ_HI,
+	PMU_SNAPSHOT_SET_SHMEM,
+};
+
+
+static sbiret_t ecall_pmu_handler(sbi_param a0, sbi_param a1, sbi_param a2, sbi_param a3, sbi_param a4, sbi_param a5, int fid)
+{
+	sbiret_t ret = { 0 };
+
+	switch (fid) {
+		case PMU_NUM_COUNTERS:
+			ret.value = pmu_numCounters();
+			break;
+
+		case PMU_COUNTER_GET_INFO:
+			ret = pmu_counterGetInfo(a0);
+			break;
+
+		case PMU_COUNTER_CONFIG_MATCHING:
+			ret = pmu_counterConfigMatching(a0, a1, a2, a3, a4);
+			break;
+
+		case PMU_COUNTER_START:
+			ret.error = pmu_counterStart(a0, a1, a2, a3);
+			break;
+
+		case PMU_COUNTER_STOP:
+			ret.error = pmu_counterStop(a0, a1, a2);
+			break;
+
+		case PMU_COUNTER_FW_READ:
+			ret = pmu_counterFwRead(a0);
+			break;
+
+		case PMU_COUNTER_FW_READ_HI:
+			/* Counters are 64-bit wide on RV64 */
+			ret = pmu_counterFwRead(a0);
+			ret.value = 0;
+			break;
+
+		case PMU_SNAPSHOT_SET_SHMEM:
+		default:
+			ret.error = SBI_ERR_NOT_SUPPORTED;
+			break;
+	}
+
+	return ret;
+}
+
+
+static const sbi_ext_t sbi_ext_pmu __attribute__((section("extensions"), used)) = {
+	.eid = SBI_EXT_PMU,
+	.handler = ecall_pmu_handler,
+};
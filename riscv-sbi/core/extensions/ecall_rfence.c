@@ -15,10 +15,16 @@
 
 #include "sbi.h"
 #include "extensions/ipi.h"
+#include "extensions/pmu.h"
 
 
 #define SFENCE_VMA_FLUSH_ALL (size_t)(-1)
 
+/* Ranges above the threshold are flushed entirely instead of page by page */
+#ifndef SFENCE_VMA_FLUSH_THRESHOLD
+#define SFENCE_VMA_FLUSH_THRESHOLD (64 * PAGE_SIZE)
+#endif
+
 
 enum {
 	RFENCE_FENCE_I = 0,
@@ -42,6 +48,7 @@ static void ecall_rfence_fenceiHandler(void *data)
 {
 	(void)data;
 
+	pmu_fwEvent(PMU_FW_FENCE_I_RECEIVED);
 	__asm__ volatile("fence.i");
 }
 
@@ -51,6 +58,8 @@ static void ecall_rfence_sfenceVmaHandler(void *data)
 	size_t i;
 	sfenceVmaInfo_t *info = (sfenceVmaInfo_t *)data;
 
+	pmu_fwEvent(PMU_FW_SFENCE_VMA_RECEIVED);
+
 	if (((info->start == 0) && (info->size == 0)) || (info->size == SFENCE_VMA_FLUSH_ALL)) {
 		__asm__ volatile("sfence.vma" ::: "memory");
 
@@ -75,6 +84,8 @@ static void ecall_rfence_sfenceVmaAsidHandler(void *data)
 	size_t i;
 	sfenceVmaInfo_t *info = (sfenceVmaInfo_t *)data;
 
+	pmu_fwEvent(PMU_FW_SFENCE_VMA_ASID_RECEIVED);
+
 	if (((info->start == 0) && (info->size == 0)) || (info->size == SFENCE_VMA_FLUSH_ALL)) {
 		/* clang-format off */
 		__asm__ volatile (
@@ -102,27 +113,40 @@ static void ecall_rfence_sfenceVmaAsidHandler(void *data)
 }
 
 
+static void ecall_rfence_sfenceVmaInfoSet(sfenceVmaInfo_t *info, addr_t start, size_t size, u32 asid)
+{
+	info->start = start;
+	info->size = size;
+	info->asid = asid;
+
+	if ((size > SFENCE_VMA_FLUSH_THRESHOLD) || ((start + size) < start)) {
+		info->size = SFENCE_VMA_FLUSH_ALL;
+	}
+}
+
+
 static sbiret_t ecall_rfence_handler(sbi_param a0, sbi_param a1, sbi_param a2, sbi_param a3, sbi_param a4, sbi_param a5, int fid)
 {
 	sbiret_t ret = { 0 };
 	sfenceVmaInfo_t info;
 
+	/* Remote fences complete before returning, info is shared by all target harts */
 	switch (fid) {
 		case RFENCE_FENCE_I:
-			ret.error = sbi_ipiSendMany(a0, a1, ecall_rfence_fenceiHandler, NULL);
+			pmu_fwEvent(PMU_FW_FENCE_I_SENT);
+			ret.error = sbi_ipiSendManySync(a0, a1, ecall_rfence_fenceiHandler, NULL);
 			break;
 
 		case RFENCE_SFENCE_VMA:
-			info.start = a2;
-			info.size = a3;
-			ret.error = sbi_ipiSendMany(a0, a1, ecall_rfence_sfenceVmaHandler, &info);
+			pmu_fwEvent(PMU_FW_SFENCE_VMA_SENT);
+			ecall_rfence_sfenceVmaInfoSet(&info, a2, a3, 0);
+			ret.error = sbi_ipiSendManySync(a0, a1, ecall_rfence_sfenceVmaHandler, &info);
 			break;
 
 		case RFENCE_SFENCE_VMA_ASID:
-			info.start = a2;
-			info.size = a3;
-			info.asid = a4;
-			ret.error = sbi_ipiSendMany(a0, a1, ecall_rfence_sfenceVmaAsidHandler, &info);
+			pmu_fwEvent(PMU_FW_SFENCE_VMA_ASID_SENT);
+			ecall_rfence_sfenceVmaInfoSet(&info, a2, a3, a4);
+			ret.error = sbi_ipiSendManySync(a0, a1, ecall_rfence_sfenceVmaAsidHandler, &info);
 			break;
 
 		case RFENCE_HFENCE_GVMA_VMID:
@@ -13,9 +13,12 @@
  * %LICENSE%
  */
 
+#include "csr.h"
+#include "hart.h"
 #include "sbi.h"
 
 #include "devices/clint.h"
+#include "extensions/pmu.h"
 
 
 enum {
@@ -32,7 +35,14 @@ static sbiret_t ecall_time_handler(sbi_param a0, sbi_param a1, sbi_param a2, sbi
 
 	switch (fid) {
 		case TIME_SET_TIMER:
-			clint_setTimecmp(a0);
+			pmu_fwEvent(PMU_FW_SET_TIMER);
+			if (hart_hasFeature(HART_FEATURE_SSTC) != 0) {
+				/* For kernels not using stimecmp directly */
+				csr_write(CSR_STIMECMP, a0);
+			}
+			else {
+				clint_setTimecmp(a0);
+			}
 			break;
 
 		default:
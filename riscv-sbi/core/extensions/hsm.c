@@ -21,14 +21,40 @@
 #include "extensions/ipi.h"
 
 
+/* Suspend types */
+#define HSM_SUSPEND_RET_DEFAULT    0x00000000u
+#define HSM_SUSPEND_RET_PLATFORM   0x10000000u
+#define HSM_SUSPEND_NONRET_DEFAULT 0x80000000u
+#define HSM_SUSPEND_NONRET_PLAT    0x90000000u
+
+
 extern u32 bootHartId;
 
+/* SBI image with its data and stacks */
+extern char __init_start[], __stack_top[];
+
 
 static struct {
 	volatile u32 hartsStarted;
 } hsm_common;
 
 
+/* S-mode entry point has to be aligned, outside of SBI and executable according to PMP */
+static int hsm_isValidAddr(sbi_param addr)
+{
+	/* IALIGN is at least 16 bits */
+	if ((addr & 1) != 0) {
+		return 0;
+	}
+
+	if ((addr >= (sbi_param)__init_start) && (addr < (sbi_param)__stack_top)) {
+		return 0;
+	}
+
+	return hart_pmpAllows(addr, PMP_X);
+}
+
+
 long hsm_hartStart(sbi_param hartid, sbi_param startAddr, sbi_param opaque)
 {
 	sbi_perHartData_t *data;
@@ -38,6 +64,10 @@ long hsm_hartStart(sbi_param hartid, sbi_param startAddr, sbi_param opaque)
 		return SBI_ERR_INVALID_PARAM;
 	}
 
+	if (hsm_isValidAddr(startAddr) == 0) {
+		return SBI_ERR_INVALID_ADDRESS;
+	}
+
 	data = sbi_getPerHartData(hartid);
 
 	state = atomic_cas64(&data->state, SBI_HSM_STOPPED, SBI_HSM_START_PENDING);
@@ -52,7 +82,9 @@ long hsm_hartStart(sbi_param hartid, sbi_param startAddr, sbi_param opaque)
 	ATOMIC_WRITE(&data->nextAddr, startAddr);
 	ATOMIC_WRITE(&data->nextArg1, opaque);
 
-	sbi_ipiSend(hartid, NULL, NULL);
+	/* Stopped hart only waits for the state change, no IPI task is needed.
+	 * Starting several harts in a row costs one CLINT write per hart. */
+	sbi_ipiRawSend(hartid);
 
 	return SBI_SUCCESS;
 }
@@ -85,23 +117,88 @@ void __attribute__((noreturn)) hsm_hartStartJump(u32 hartid)
 }
 
 
+/* Waits in WFI until the hart is started, serving IPIs meanwhile */
 static void hsm_hartWait(u32 hartid)
 {
 	sbi_perHartData_t *data = sbi_getPerHartData(hartid);
 	unsigned long mie = csr_read(CSR_MIE);
 
-	csr_set(CSR_MIE, MIP_MSIP | MIP_MEIP);
-
-	atomic_add32(&hsm_common.hartsStarted, 1);
+	/* Only IPI can wake up the hart - S-mode interrupts stay pending */
+	csr_write(CSR_MIE, MIP_MSIP | MIP_MEIP);
 
 	while (ATOMIC_READ(&data->state) != SBI_HSM_START_PENDING) {
 		__WFI();
+		sbi_ipiPoll();
 	}
 
 	csr_write(CSR_MIE, mie);
 }
 
 
+long hsm_hartStop(void)
+{
+	u32 hartid = csr_read(CSR_MHARTID);
+	sbi_perHartData_t *data = sbi_getPerHartData(hartid);
+
+	if (atomic_cas64(&data->state, SBI_HSM_STARTED, SBI_HSM_STOP_PENDING) != SBI_HSM_STARTED) {
+		return SBI_ERR_FAILED;
+	}
+
+	/* Hart state (delegation, counters) is kept, start skips the cold/warm init */
+	csr_write(CSR_SIE, 0);
+	ATOMIC_WRITE(&data->state, SBI_HSM_STOPPED);
+
+	hsm_hartWait(hartid);
+	hsm_hartStartJump(hartid);
+}
+
+
+long hsm_hartSuspend(sbi_param type, sbi_param resumeAddr, sbi_param opaque)
+{
+	u32 hartid = csr_read(CSR_MHARTID);
+	sbi_perHartData_t *data = sbi_getPerHartData(hartid);
+	int nonRetentive;
+
+	if (type > 0xffffffffUL) {
+		return SBI_ERR_INVALID_PARAM;
+	}
+
+	if ((type == HSM_SUSPEND_RET_DEFAULT) || (type == HSM_SUSPEND_NONRET_DEFAULT)) {
+		nonRetentive = (type == HSM_SUSPEND_NONRET_DEFAULT) ? 1 : 0;
+	}
+	else if (((type >= HSM_SUSPEND_RET_PLATFORM) && (type < HSM_SUSPEND_NONRET_DEFAULT)) || (type >= HSM_SUSPEND_NONRET_PLAT)) {
+		return SBI_ERR_NOT_SUPPORTED;
+	}
+	else {
+		return SBI_ERR_INVALID_PARAM;
+	}
+
+	if ((nonRetentive != 0) && (hsm_isValidAddr(resumeAddr) == 0)) {
+		return SBI_ERR_INVALID_ADDRESS;
+	}
+
+	if (atomic_cas64(&data->state, SBI_HSM_STARTED, SBI_HSM_SUSPENDED) != SBI_HSM_STARTED) {
+		return SBI_ERR_FAILED;
+	}
+
+	/* Wake up on any interrupt enabled in mie (including ones delegated to S-mode).
+	 * WFI may return spuriously, which is allowed for the default suspend types. */
+	__WFI();
+
+	if (nonRetentive == 0) {
+		ATOMIC_WRITE(&data->state, SBI_HSM_STARTED);
+		return SBI_SUCCESS;
+	}
+
+	/* Resume in S-mode at resumeAddr, like after hart_start */
+	ATOMIC_WRITE(&data->nextAddr, resumeAddr);
+	ATOMIC_WRITE(&data->nextArg1, opaque);
+	ATOMIC_WRITE(&data->state, SBI_HSM_START_PENDING);
+
+	hsm_hartStartJump(hartid);
+}
+
+
 void hsm_init(u32 hartid)
 {
 	sbi_perHartData_t *data;
@@ -113,6 +210,7 @@ void hsm_init(u32 hartid)
 		while (ATOMIC_READ(&hsm_common.hartsStarted) < sbi_getHartCount()) { }
 	}
 	else {
+		atomic_add32(&hsm_common.hartsStarted, 1);
 		hsm_hartWait(hartid);
 	}
 }
@@ -13,12 +13,10 @@
  * %LICENSE%
  */
 
+#include "atomic.h"
 #include "csr.h"
 #include "hart.h"
-#include "list.h"
 #include "sbi.h"
-#include "spinlock.h"
-#include "string.h"
 
 #include "devices/clint.h"
 #include "extensions/ipi.h"
@@ -34,27 +32,27 @@
 #endif
 
 
-#define MAX_TASK_COUNT 16
+/* Mailbox slots per hart, up to 64 */
+#define MAX_TASK_COUNT 32
 
 #define SBI_IPI_RETRY 1
 
 
-typedef struct _ipi_node_t {
-	ipi_task_t task;
-	struct _ipi_node_t *next;
-	struct _ipi_node_t *prev;
-} ipi_node_t;
+/* Per-hart mailbox, multiple producers (senders) and single consumer (target hart).
+ * Sender claims a free slot, fills it and publishes it in the pending mask. */
+typedef struct {
+	vu64 free;
+	vu64 pending;
+	ipi_task_t slots[MAX_TASK_COUNT];
+} __attribute__((aligned(64))) ipi_mailbox_t;
 
 
 struct {
-	spinlock_t lock[MAX_HART_COUNT];
-	u16 poolMask[MAX_HART_COUNT];
-	ipi_node_t pool[MAX_HART_COUNT][MAX_TASK_COUNT];
-	ipi_node_t *tasks[MAX_HART_COUNT];
+	ipi_mailbox_t mbox[MAX_HART_COUNT];
 } ipi_common;
 
 
-static void sbi_ipiRawSend(u32 hartid)
+void sbi_ipiRawSend(u32 hartid)
 {
 	RISCV_FENCE(ow, ow);
 	clint_sendIpi(hartid);
@@ -70,34 +68,76 @@ static void sbi_ipiRawClear(u32 hartid)
 
 void sbi_ipiHandler(void)
 {
-	spinlock_ctx_t ctx;
 	u32 hartid = csr_read(CSR_MHARTID);
-	ipi_node_t *node;
+	ipi_mailbox_t *mbox = &ipi_common.mbox[hartid];
+	ipi_task_t *task;
+	u64 pending;
+	unsigned int idx;
 
 	sbi_ipiRawClear(hartid);
 
-	spinlock_set(&ipi_common.lock[hartid], &ctx);
+	/* Tasks published after the swap raise the IPI again */
+	pending = atomic_swap64(&mbox->pending, 0);
 
-	node = ipi_common.tasks[hartid];
+	while (pending != 0) {
+		idx = sbi_getFirstBit(pending);
+		pending &= ~(1UL << idx);
 
-	while (node != NULL) {
-		LIST_REMOVE(&ipi_common.tasks[hartid], node);
-		if (node->task.handler != NULL) {
-			node->task.handler(node->task.data);
+		task = &mbox->slots[idx];
+		if (task->handler != NULL) {
+			task->handler(task->data);
 		}
-		ipi_common.poolMask[hartid] |= 1 << (node - ipi_common.pool[hartid]);
-		node = ipi_common.tasks[hartid];
+		if (task->done != NULL) {
+			RISCV_FENCE(rw, w);
+			atomic_add32(task->done, (u32)-1);
+		}
+
+		/* Slot can be reused */
+		atomic_or64(&mbox->free, 1UL << idx);
+	}
+}
+
+
+void sbi_ipiPoll(void)
+{
+	if ((csr_read(CSR_MIP) & MIP_MSIP) != 0) {
+		sbi_ipiHandler();
 	}
+}
+
+
+/* Queues task on the hart without raising the IPI */
+static long sbi_ipiEnqueue(u32 hartid, void (*handler)(void *), void *data, vu32 *done)
+{
+	ipi_mailbox_t *mbox = &ipi_common.mbox[hartid];
+	ipi_task_t *task;
+	unsigned int idx;
+	u64 free;
+
+	/* Claim a free slot */
+	do {
+		free = ATOMIC_READ(&mbox->free);
+		if (free == 0) {
+			return SBI_IPI_RETRY;
+		}
+		idx = sbi_getFirstBit(free);
+	} while (atomic_cas64(&mbox->free, free, free & ~(1UL << idx)) != free);
+
+	task = &mbox->slots[idx];
+	task->handler = handler;
+	task->data = data;
+	task->done = done;
+
+	/* Publish */
+	atomic_or64(&mbox->pending, 1UL << idx);
 
-	spinlock_clear(&ipi_common.lock[hartid], &ctx);
+	return SBI_SUCCESS;
 }
 
 
 long sbi_ipiSend(u32 hartid, void (*handler)(void *), void *data)
 {
-	size_t idx;
-	spinlock_ctx_t ctx;
-	ipi_node_t *node;
+	long ret;
 
 	if (hartid == csr_read(CSR_MHARTID)) {
 		if (handler != NULL) {
@@ -106,39 +146,19 @@ long sbi_ipiSend(u32 hartid, void (*handler)(void *), void *data)
 		return SBI_SUCCESS;
 	}
 
-	spinlock_set(&ipi_common.lock[hartid], &ctx);
-
-	if (ipi_common.poolMask[hartid] == 0) {
-		spinlock_clear(&ipi_common.lock[hartid], &ctx);
-		return SBI_IPI_RETRY;
-	}
-
-	idx = sbi_getFirstBit(ipi_common.poolMask[hartid]);
-	ipi_common.poolMask[hartid] &= ~(1 << idx);
-
-	node = &ipi_common.pool[hartid][idx];
-	node->task.handler = handler;
-	node->task.data = data;
-
-	if (ipi_common.tasks[hartid] == NULL) {
-		LIST_ADD(&ipi_common.tasks[hartid], node);
+	ret = sbi_ipiEnqueue(hartid, handler, data, NULL);
+	if (ret == SBI_SUCCESS) {
+		sbi_ipiRawSend(hartid);
 	}
-	else {
-		LIST_ADD(&ipi_common.tasks[hartid]->prev, node);
-	}
-
-	sbi_ipiRawSend(hartid);
-
-	spinlock_clear(&ipi_common.lock[hartid], &ctx);
 
-	return SBI_SUCCESS;
+	return ret;
 }
 
 
-long sbi_ipiSendMany(unsigned long hartMask, unsigned long hartMaskBase, void (*handler)(void *), void *data)
+static long sbi_ipiSendManyInternal(unsigned long hartMask, unsigned long hartMaskBase, void (*handler)(void *), void *data, vu32 *done)
 {
 	size_t i;
-	long ret;
+	u32 self = csr_read(CSR_MHARTID);
 
 	if (hartMaskBase > sbi_getHartCount()) {
 		return SBI_ERR_INVALID_PARAM;
@@ -151,31 +171,70 @@ long sbi_ipiSendMany(unsigned long hartMask, unsigned long hartMaskBase, void (*
 		return SBI_ERR_INVALID_PARAM;
 	}
 
+	/* Queue tasks on all target harts first */
 	for (i = 0; i < sbi_getHartCount(); i++) {
-		if (hartMask & (1 << i)) {
-			do {
-				ret = sbi_ipiSend(i, handler, data);
-				/* We might run out of IPI slots, retry */
-			} while (ret == SBI_IPI_RETRY);
-
-			if (ret < 0) {
-				return ret;
-			}
+		if ((i == self) || ((hartMask & (1UL << i)) == 0)) {
+			continue;
 		}
+
+		if (done != NULL) {
+			atomic_add32(done, 1);
+		}
+
+		while (sbi_ipiEnqueue(i, handler, data, done) == SBI_IPI_RETRY) {
+			/* Target queue is full - kick the target and serve own queue
+			 * meanwhile, the target might be waiting for us */
+			sbi_ipiRawSend(i);
+			sbi_ipiPoll();
+		}
+	}
+
+	/* Raise all IPIs at once */
+	RISCV_FENCE(ow, ow);
+	for (i = 0; i < sbi_getHartCount(); i++) {
+		if ((i != self) && ((hartMask & (1UL << i)) != 0)) {
+			clint_sendIpi(i);
+		}
+	}
+
+	if (((hartMask & (1UL << self)) != 0) && (handler != NULL)) {
+		handler(data);
 	}
 
 	return SBI_SUCCESS;
 }
 
 
+long sbi_ipiSendMany(unsigned long hartMask, unsigned long hartMaskBase, void (*handler)(void *), void *data)
+{
+	return sbi_ipiSendManyInternal(hartMask, hartMaskBase, handler, data, NULL);
+}
+
+
+long sbi_ipiSendManySync(unsigned long hartMask, unsigned long hartMaskBase, void (*handler)(void *), void *data)
+{
+	long ret;
+	vu32 pending = 0;
+
+	ret = sbi_ipiSendManyInternal(hartMask, hartMaskBase, handler, data, &pending);
+
+	/* Wait for all targets, serving tasks sent to this hart to avoid deadlock */
+	while (ATOMIC_READ(&pending) != 0) {
+		sbi_ipiPoll();
+	}
+
+	return ret;
+}
+
+
 void sbi_ipiInit(void)
 {
 	size_t i;
+
 	for (i = 0; i < sbi_getHartCount(); i++) {
-		spinlock_create(&ipi_common.lock[i], "ipi");
+		ipi_common.mbox[i].free = (MAX_TASK_COUNT == 64) ? (u64)-1 : ((1UL << MAX_TASK_COUNT) - 1);
+		ipi_common.mbox[i].pending = 0;
 	}
 
-	sbi_memset(ipi_common.poolMask, 0xff, sizeof(ipi_common.poolMask));
-
 	RISCV_FENCE(w, rw);
 }
@@ -0,0 +1,580 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Phoenix SBI
+ *
+ * Performance monitoring unit
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "csr.h"
+#include "fdt.h"
+#include "hart.h"
+#include "sbi.h"
+
+#include "extensions/pmu.h"
+
+#if defined(__CPU_GR765)
+#include "ld/gr765.ldt"
+#elif defined(__CPU_GRFPGA)
+#include "ld/grfpga.ldt"
+#elif defined(__CPU_GENERIC)
+#include "ld/generic.ldt"
+#else
+#error "Unsupported TARGET"
+#endif
+
+
+/* HW counter indices: 0 - cycle, 1 - time, 2 - instret, 3..31 - hpmcounter */
+#define PMU_HW_FIXED     ((1u << 0) | (1u << 2))
+#define PMU_HW_PROG_MASK 0xfffffff8u
+
+/* Firmware counters per hart, indices follow HW counters */
+#define PMU_FW_MAX 16
+
+/* Config matching flags */
+#define PMU_CFG_SKIP_MATCH  (1UL << 0)
+#define PMU_CFG_CLEAR_VALUE (1UL << 1)
+#define PMU_CFG_AUTO_START  (1UL << 2)
+#define PMU_CFG_SET_VUINH   (1UL << 3)
+#define PMU_CFG_SET_VSINH   (1UL << 4)
+#define PMU_CFG_SET_UINH    (1UL << 5)
+#define PMU_CFG_SET_SINH    (1UL << 6)
+#define PMU_CFG_SET_MINH    (1UL << 7)
+
+#define PMU_START_SET_INIT_VALUE (1UL << 0)
+#define PMU_STOP_RESET           (1UL << 0)
+
+/* Counter info */
+#define PMU_INFO_FW            (1UL << 63)
+#define PMU_INFO_WIDTH_SHIFT   12
+#define PMU_INFO_WIDTH_DEFAULT 64
+
+/* clang-format off */
+#define PMU_HPM_LIST(X) \
+	X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) X(16) X(17) \
+	X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)
+/* clang-format on */
+
+
+typedef struct {
+	u32 hwUsed;                      /* Configured HW counters */
+	u32 fwUsed;                      /* Configured firmware counters */
+	u32 fwStarted;                   /* Running firmware counters */
+	u8 fwEvent[PMU_FW_MAX];          /* Firmware event of the counter */
+	u64 fwValue[PMU_FW_MAX];         /* Stopped: counter value, running: value - event count */
+	u64 fwCount[PMU_FW_EVENT_COUNT]; /* Firmware events counted on the hart */
+} pmu_hart_t;
+
+
+static struct {
+	pmu_info_t info;
+	u32 hwCounters; /* Available HW counters */
+	u32 hwCount;    /* Number of HW counter indices (0 - firmware counters only) */
+	u32 hpmWidth;
+	pmu_hart_t hart[MAX_HART_COUNT];
+} pmu_common;
+
+
+static void pmu_hwWrite(unsigned int idx, u64 val)
+{
+	switch (idx) {
+		case 0:
+			csr_write(CSR_MCYCLE, val);
+			break;
+
+		case 2:
+			csr_write(CSR_MINSTRET, val);
+			break;
+
+#define PMU_HPM_WRITE(n) \
+	case n: \
+		csr_write(CSR_MHPMCOUNTER3 + (n) - 3, val); \
+		break;
+		PMU_HPM_LIST(PMU_HPM_WRITE)
+#undef PMU_HPM_WRITE
+
+		default:
+			break;
+	}
+}
+
+
+static u64 pmu_hwRead(unsigned int idx)
+{
+	switch (idx) {
+		case 0:
+			return csr_read(CSR_MCYCLE);
+
+		case 2:
+			return csr_read(CSR_MINSTRET);
+
+#define PMU_HPM_READ(n) \
+	case n: \
+		return csr_read(CSR_MHPMCOUNTER3 + (n) - 3);
+		PMU_HPM_LIST(PMU_HPM_READ)
+#undef PMU_HPM_READ
+
+		default:
+			return 0;
+	}
+}
+
+
+static void pmu_eventWrite(unsigned int idx, u64 val)
+{
+	switch (idx) {
+#define PMU_EVENT_WRITE(n) \
+	case n: \
+		csr_write(CSR_MHPMEVENT3 + (n) - 3, val); \
+		break;
+		PMU_HPM_LIST(PMU_EVENT_WRITE)
+#undef PMU_EVENT_WRITE
+
+		default:
+			break;
+	}
+}
+
+
+static void pmu_eventClearOverflow(unsigned int idx)
+{
+	switch (idx) {
+#define PMU_EVENT_CLEAROF(n) \
+	case n: \
+		csr_clear(CSR_MHPMEVENT3 + (n) - 3, MHPMEVENT_OF); \
+		break;
+		PMU_HPM_LIST(PMU_EVENT_CLEAROF)
+#undef PMU_EVENT_CLEAROF
+
+		default:
+			break;
+	}
+}
+
+
+static pmu_hart_t *pmu_getHart(void)
+{
+	return &pmu_common.hart[csr_read(CSR_MHARTID)];
+}
+
+
+void pmu_fwEvent(unsigned int event)
+{
+	pmu_common.hart[csr_read(CSR_MHARTID)].fwCount[event]++;
+}
+
+
+static int pmu_isHw(unsigned long idx)
+{
+	return ((idx < pmu_common.hwCount) && ((pmu_common.hwCounters & (1u << idx)) != 0)) ? 1 : 0;
+}
+
+
+static int pmu_isFw(unsigned long idx)
+{
+	return ((idx >= pmu_common.hwCount) && (idx < (pmu_common.hwCount + PMU_FW_MAX))) ? 1 : 0;
+}
+
+
+/* Returns counter set selected by base and mask, 0 if invalid */
+static u64 pmu_counterSet(unsigned long base, unsigned long mask)
+{
+	u64 all = (1UL << (pmu_common.hwCount + PMU_FW_MAX)) - 1;
+
+	if ((base >= (pmu_common.hwCount + PMU_FW_MAX)) || (((mask << base) >> base) != mask)) {
+		return 0;
+	}
+
+	mask <<= base;
+	if ((mask & ~all) != 0) {
+		return 0;
+	}
+
+	return mask;
+}
+
+
+/* Maps event to the firmware event counted by pmu_fwEvent(), -1 if not supported */
+static int pmu_fwEventMap(unsigned long event, u64 data)
+{
+	u32 code = PMU_EVENT_CODE(event);
+
+	if (code == PMU_FW_PLATFORM) {
+		return (data < (PMU_FW_EVENT_COUNT - PMU_FW_PLATFORM_BASE)) ? (int)(PMU_FW_PLATFORM_BASE + data) : -1;
+	}
+
+	return (code < PMU_FW_PLATFORM_BASE) ? (int)code : -1;
+}
+
+
+/* Returns HW counters able to count event and its mhpmevent selector */
+static u32 pmu_hwEventCounters(unsigned long event, u64 data, u64 *selector)
+{
+	const pmu_info_t *info = &pmu_common.info;
+	u32 counters = 0;
+	size_t i;
+
+	if (PMU_EVENT_TYPE(event) == PMU_EVENT_TYPE_HW_RAW) {
+		*selector = data;
+		return info->rawCounters & pmu_common.hwCounters & PMU_HW_PROG_MASK;
+	}
+
+	if (event == PMU_HW_CPU_CYCLES) {
+		counters |= 1u << 0;
+	}
+	else if (event == PMU_HW_INSTRUCTIONS) {
+		counters |= 1u << 2;
+	}
+
+	*selector = 0;
+	for (i = 0; i < info->eventMapCount; i++) {
+		if (info->eventMap[i].event == event) {
+			*selector = info->eventMap[i].selector;
+			break;
+		}
+	}
+
+	/* Programmable counters need a selector */
+	if (*selector != 0) {
+		for (i = 0; i < info->counterMapCount; i++) {
+			if ((event >= info->counterMap[i].start) && (event <= info->counterMap[i].end)) {
+				counters |= info->counterMap[i].counters & PMU_HW_PROG_MASK;
+			}
+		}
+	}
+
+	return counters & pmu_common.hwCounters;
+}
+
+
+static long pmu_start(pmu_hart_t *hart, unsigned int idx, unsigned long flags, u64 value)
+{
+	unsigned int fw;
+
+	if (pmu_isFw(idx) != 0) {
+		fw = idx - pmu_common.hwCount;
+		if ((hart->fwUsed & (1u << fw)) == 0) {
+			return SBI_ERR_INVALID_PARAM;
+		}
+		if ((hart->fwStarted & (1u << fw)) != 0) {
+			return SBI_ERR_ALREADY_STARTED;
+		}
+		if ((flags & PMU_START_SET_INIT_VALUE) != 0) {
+			hart->fwValue[fw] = value;
+		}
+		hart->fwValue[fw] -= hart->fwCount[hart->fwEvent[fw]];
+		hart->fwStarted |= 1u << fw;
+
+		return SBI_SUCCESS;
+	}
+
+	if ((hart->hwUsed & (1u << idx)) == 0) {
+		return SBI_ERR_INVALID_PARAM;
+	}
+	if ((csr_read(CSR_MCOUNTINHIBIT) & (1UL << idx)) == 0) {
+		return SBI_ERR_ALREADY_STARTED;
+	}
+	if ((flags & PMU_START_SET_INIT_VALUE) != 0) {
+		pmu_hwWrite(idx, value);
+	}
+	if (hart_hasFeature(HART_FEATURE_SSCOFPMF) != 0) {
+		/* Rearm overflow interrupt */
+		pmu_eventClearOverflow(idx);
+	}
+	csr_clear(CSR_MCOUNTINHIBIT, 1UL << idx);
+
+	return SBI_SUCCESS;
+}
+
+
+static long pmu_stop(pmu_hart_t *hart, unsigned int idx, unsigned long flags)
+{
+	unsigned int fw;
+	long err = SBI_SUCCESS;
+
+	if (pmu_isFw(idx) != 0) {
+		fw = idx - pmu_common.hwCount;
+		if ((hart->fwUsed & (1u << fw)) == 0) {
+			return SBI_ERR_INVALID_PARAM;
+		}
+		if ((hart->fwStarted & (1u << fw)) == 0) {
+			err = SBI_ERR_ALREADY_STOPPED;
+		}
+		else {
+			hart->fwValue[fw] += hart->fwCount[hart->fwEvent[fw]];
+			hart->fwStarted &= ~(1u << fw);
+		}
+		if ((flags & PMU_STOP_RESET) != 0) {
+			hart->fwUsed &= ~(1u << fw);
+		}
+
+		return err;
+	}
+
+	if ((hart->hwUsed & (1u << idx)) == 0) {
+		return SBI_ERR_INVALID_PARAM;
+	}
+	if ((csr_read(CSR_MCOUNTINHIBIT) & (1UL << idx)) != 0) {
+		err = SBI_ERR_ALREADY_STOPPED;
+	}
+	else {
+		csr_set(CSR_MCOUNTINHIBIT, 1UL << idx);
+	}
+	if ((flags & PMU_STOP_RESET) != 0) {
+		hart->hwUsed &= ~(1u << idx);
+		pmu_eventWrite(idx, 0);
+	}
+
+	return err;
+}
+
+
+long pmu_numCounters(void)
+{
+	return pmu_common.hwCount + PMU_FW_MAX;
+}
+
+
+sbiret_t pmu_counterGetInfo(unsigned long idx)
+{
+	sbiret_t ret = { .error = SBI_SUCCESS, .value = 0 };
+	unsigned long width;
+
+	if (pmu_isFw(idx) != 0) {
+		ret.value = PMU_INFO_FW;
+	}
+	else if ((pmu_isHw(idx) != 0) || (idx == 1)) {
+		width = (idx < 3) ? PMU_INFO_WIDTH_DEFAULT : pmu_common.hpmWidth;
+		ret.value = (CSR_CYCLE + idx) | ((width - 1) << PMU_INFO_WIDTH_SHIFT);
+	}
+	else {
+		ret.error = SBI_ERR_INVALID_PARAM;
+	}
+
+	return ret;
+}
+
+
+sbiret_t pmu_counterConfigMatching(unsigned long base, unsigned long mask, unsigned long flags, unsigned long event, u64 data)
+{
+	sbiret_t ret = { .error = SBI_SUCCESS, .value = 0 };
+	pmu_hart_t *hart = pmu_getHart();
+	u64 set = pmu_counterSet(base, mask), selector;
+	u32 counters;
+	unsigned int idx, fw;
+	int fwEvent;
+
+	if (set == 0) {
+		ret.error = SBI_ERR_INVALID_PARAM;
+		return ret;
+	}
+
+	if ((flags & PMU_CFG_SKIP_MATCH) != 0) {
+		/* Counter already configured by the caller */
+		idx = sbi_getFirstBit(set);
+		if (((pmu_isFw(idx) != 0) && ((hart->fwUsed & (1u << (idx - pmu_common.hwCount))) == 0)) ||
+				((pmu_isFw(idx) == 0) && ((hart->hwUsed & (1u << idx)) == 0))) {
+			ret.error = SBI_ERR_INVALID_PARAM;
+			return ret;
+		}
+	}
+	else if (PMU_EVENT_TYPE(event) == PMU_EVENT_TYPE_FW) {
+		fwEvent = pmu_fwEventMap(event, data);
+		counters = (u32)(set >> pmu_common.hwCount) & ~hart->fwUsed & ((1u << PMU_FW_MAX) - 1);
+		if ((fwEvent < 0) || (counters == 0)) {
+			ret.error = SBI_ERR_NOT_SUPPORTED;
+			return ret;
+		}
+
+		fw = sbi_getFirstBit(counters);
+		hart->fwUsed |= 1u << fw;
+		hart->fwStarted &= ~(1u << fw);
+		hart->fwEvent[fw] = (u8)fwEvent;
+		hart->fwValue[fw] = 0;
+		idx = pmu_common.hwCount + fw;
+	}
+	else {
+		counters = pmu_hwEventCounters(event, data, &selector) & (u32)set & ~hart->hwUsed;
+		if (counters == 0) {
+			ret.error = SBI_ERR_NOT_SUPPORTED;
+			return ret;
+		}
+
+		idx = sbi_getFirstBit(counters);
+		hart->hwUsed |= 1u << idx;
+		csr_set(CSR_MCOUNTINHIBIT, 1UL << idx);
+
+		if (idx >= 3) {
+			if (hart_hasFeature(HART_FEATURE_SSCOFPMF) != 0) {
+				selector &= ~(MHPMEVENT_OF | MHPMEVENT_MINH | MHPMEVENT_SINH | MHPMEVENT_UINH | MHPMEVENT_VSINH | MHPMEVENT_VUINH);
+				selector |= ((flags & PMU_CFG_SET_MINH) != 0) ? MHPMEVENT_MINH : 0;
+				selector |= ((flags & PMU_CFG_SET_SINH) != 0) ? MHPMEVENT_SINH : 0;
+				selector |= ((flags & PMU_CFG_SET_UINH) != 0) ? MHPMEVENT_UINH : 0;
+				selector |= ((flags & PMU_CFG_SET_VSINH) != 0) ? MHPMEVENT_VSINH : 0;
+				selector |= ((flags & PMU_CFG_SET_VUINH) != 0) ? MHPMEVENT_VUINH : 0;
+			}
+			pmu_eventWrite(idx, selector);
+		}
+	}
+
+	if ((flags & PMU_CFG_CLEAR_VALUE) != 0) {
+		if (pmu_isFw(idx) != 0) {
+			fw = idx - pmu_common.hwCount;
+			hart->fwValue[fw] = ((hart->fwStarted & (1u << fw)) != 0) ? -hart->fwCount[hart->fwEvent[fw]] : 0;
+		}
+		else {
+			pmu_hwWrite(idx, 0);
+		}
+	}
+
+	if ((flags & PMU_CFG_AUTO_START) != 0) {
+		(void)pmu_start(hart, idx, 0, 0);
+	}
+
+	ret.value = idx;
+
+	return ret;
+}
+
+
+long pmu_counterStart(unsigned long base, unsigned long mask, unsigned long flags, u64 value)
+{
+	pmu_hart_t *hart = pmu_getHart();
+	u64 set = pmu_counterSet(base, mask);
+	unsigned int idx;
+	long err, ret = SBI_SUCCESS;
+
+	if (set == 0) {
+		return SBI_ERR_INVALID_PARAM;
+	}
+
+	while (set != 0) {
+		idx = sbi_getFirstBit(set);
+		set &= ~(1UL << idx);
+
+		err = pmu_start(hart, idx, flags, value);
+		if (err != SBI_SUCCESS) {
+			ret = err;
+		}
+	}
+
+	return ret;
+}
+
+
+long pmu_counterStop(unsigned long base, unsigned long mask, unsigned long flags)
+{
+	pmu_hart_t *hart = pmu_getHart();
+	u64 set = pmu_counterSet(base, mask);
+	unsigned int idx;
+	long err, ret = SBI_SUCCESS;
+
+	if (set == 0) {
+		return SBI_ERR_INVALID_PARAM;
+	}
+
+	while (set != 0) {
+		idx = sbi_getFirstBit(set);
+		set &= ~(1UL << idx);
+
+		err = pmu_stop(hart, idx, flags);
+		if (err != SBI_SUCCESS) {
+			ret = err;
+		}
+	}
+
+	return ret;
+}
+
+
+sbiret_t pmu_counterFwRead(unsigned long idx)
+{
+	sbiret_t ret = { .error = SBI_SUCCESS, .value = 0 };
+	pmu_hart_t *hart = pmu_getHart();
+	unsigned int fw;
+
+	if (pmu_isFw(idx) == 0) {
+		ret.error = SBI_ERR_INVALID_PARAM;
+		return ret;
+	}
+
+	fw = idx - pmu_common.hwCount;
+	if ((hart->fwUsed & (1u << fw)) == 0) {
+		ret.error = SBI_ERR_INVALID_PARAM;
+	}
+	else if ((hart->fwStarted & (1u << fw)) != 0) {
+		ret.value = hart->fwValue[fw] + hart->fwCount[hart->fwEvent[fw]];
+	}
+	else {
+		ret.value = hart->fwValue[fw];
+	}
+
+	return ret;
+}
+
+
+void pmu_init(void)
+{
+	const pmu_info_t *info = &pmu_common.info;
+	u32 counters;
+	size_t i;
+	u64 v;
+
+	pmu_common.hwCount = 0;
+	pmu_common.hwCounters = 0;
+	pmu_common.hpmWidth = PMU_INFO_WIDTH_DEFAULT;
+
+	/* Without the platform counter map only firmware counters are provided */
+	if (fdt_getPmuInfo(&pmu_common.info) < 0) {
+		return;
+	}
+
+	counters = info->rawCounters;
+	for (i = 0; i < info->counterMapCount; i++) {
+		counters |= info->counterMap[i].counters;
+	}
+	counters = (counters & PMU_HW_PROG_MASK) | PMU_HW_FIXED;
+
+	pmu_common.hwCounters = counters;
+	pmu_common.hwCount = 32 - __builtin_clz(counters);
+
+	/* Assume the same hpmcounter width on all harts */
+	if ((counters & PMU_HW_PROG_MASK) != 0) {
+		i = sbi_getFirstBit(counters & PMU_HW_PROG_MASK);
+		csr_set(CSR_MCOUNTINHIBIT, 1UL << i);
+		pmu_hwWrite(i, (u64)-1);
+		v = pmu_hwRead(i);
+		pmu_hwWrite(i, 0);
+		pmu_common.hpmWidth = (v != 0) ? (64 - __builtin_clzl(v)) : PMU_INFO_WIDTH_DEFAULT;
+	}
+}
+
+
+void pmu_hartInit(void)
+{
+	pmu_hart_t *hart = pmu_getHart();
+	unsigned int i;
+
+	hart->hwUsed = 0;
+	hart->fwUsed = 0;
+	hart->fwStarted = 0;
+
+	if (pmu_common.hwCount == 0) {
+		return;
+	}
+
+	/* cycle and instret keep running, programmable counters are stopped until configured */
+	for (i = 3; i < pmu_common.hwCount; i++) {
+		if ((pmu_common.hwCounters & (1u << i)) != 0) {
+			csr_set(CSR_MCOUNTINHIBIT, 1UL << i);
+			pmu_eventWrite(i, 0);
+			pmu_hwWrite(i, 0);
+		}
+	}
+}
@@ -83,6 +83,98 @@ int fdt_parseCpus(void)
 }
 
 
+static int fdt_isaTokenMatch(const char *token, size_t len, const char *ext)
+{
+	size_t i;
+	char c;
+
+	for (i = 0; i < len; i++) {
+		c = token[i];
+		if ((c >= 'A') && (c <= 'Z')) {
+			c += 'a' - 'A';
+		}
+
+		if ((ext[i] == '\0') || (c != ext[i])) {
+			return 0;
+		}
+	}
+
+	return ext[len] == '\0';
+}
+
+
+/* Checks multi-letter extension in the cpu node (riscv,isa-extensions or riscv,isa) */
+static int fdt_cpuHasIsaExt(ssize_t offset, const char *ext)
+{
+	const char *str, *end, *token;
+	fdt_prop_t *prop;
+
+	prop = fdt_getProperty(offset, "riscv,isa-extensions");
+	if (prop != NULL) {
+		/* String list */
+		str = (const char *)prop->data;
+		end = str + fdt32_to_cpu(prop->len);
+		while (str < end) {
+			if (fdt_isaTokenMatch(str, sbi_strlen(str), ext) != 0) {
+				return 1;
+			}
+			str += sbi_strlen(str) + 1;
+		}
+
+		return 0;
+	}
+
+	prop = fdt_getProperty(offset, "riscv,isa");
+	if (prop == NULL) {
+		return 0;
+	}
+
+	/* rv64imafdc_zicsr_sstc - multi-letter extensions follow '_' */
+	str = sbi_strchr((const char *)prop->data, '_');
+	while (str != NULL) {
+		token = str + 1;
+		str = sbi_strchr(token, '_');
+		end = (str != NULL) ? str : (token + sbi_strlen(token));
+
+		if (fdt_isaTokenMatch(token, end - token, ext) != 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+int fdt_cpusHaveIsaExt(const char *ext)
+{
+	int cpus = 0;
+	int depth = -1;
+
+	ssize_t offset = fdt_findNodeByName(0, &depth, "cpus", 4, 1);
+	if (offset < 0) {
+		return offset;
+	}
+
+	for (;;) {
+		offset = fdt_findInCurrentNode(offset, &depth, "cpu@", 4, 2);
+		if (offset >= 0) {
+			if (fdt_cpuHasIsaExt(offset, ext) == 0) {
+				return 0;
+			}
+			cpus++;
+		}
+		else if (offset == FDT_ENOTFOUND) {
+			break;
+		}
+		else {
+			return offset;
+		}
+	}
+
+	return (cpus != 0) ? 1 : 0;
+}
+
+
 /* Get #address-cells and #size-cells from node */
 static ssize_t fdt_getPeripheralAddressCells(ssize_t offset, int *depth, fdt_cellInfo_t *info, const char *node)
 {
@@ -223,3 +315,55 @@ int fdt_getClintInfo(clint_info_t *clint)
 
 	return FDT_EOK;
 }
+
+
+int fdt_getPmuInfo(pmu_info_t *pmu)
+{
+	ssize_t offset = 0;
+	int depth = -1;
+	fdt_prop_t *prop;
+	size_t i, n;
+
+	pmu->counterMapCount = 0;
+	pmu->eventMapCount = 0;
+	pmu->rawCounters = 0;
+
+	offset = fdt_findNodeByCompatible(offset, &depth, "riscv,pmu");
+	if (offset < 0) {
+		return offset;
+	}
+
+	/* <event_idx_start event_idx_end counter_bitmap> */
+	prop = fdt_getProperty(offset, "riscv,event-to-mhpmcounters");
+	if (prop != NULL) {
+		n = fdt32_to_cpu(prop->len) / (3 * sizeof(u32));
+		for (i = 0; (i < n) && (i < PMU_MAP_MAX); i++) {
+			pmu->counterMap[i].start = fdt32_to_cpu(prop->data[3 * i]);
+			pmu->counterMap[i].end = fdt32_to_cpu(prop->data[3 * i + 1]);
+			pmu->counterMap[i].counters = fdt32_to_cpu(prop->data[3 * i + 2]);
+		}
+		pmu->counterMapCount = i;
+	}
+
+	/* <event_idx selector_hi selector_lo> */
+	prop = fdt_getProperty(offset, "riscv,event-to-mhpmevent");
+	if (prop != NULL) {
+		n = fdt32_to_cpu(prop->len) / (3 * sizeof(u32));
+		for (i = 0; (i < n) && (i < PMU_MAP_MAX); i++) {
+			pmu->eventMap[i].event = fdt32_to_cpu(prop->data[3 * i]);
+			pmu->eventMap[i].selector = ((u64)fdt32_to_cpu(prop->data[3 * i + 1]) << 32) | fdt32_to_cpu(prop->data[3 * i + 2]);
+		}
+		pmu->eventMapCount = i;
+	}
+
+	/* <event_hi event_lo mask_hi mask_lo counter_bitmap>, only counters are used */
+	prop = fdt_getProperty(offset, "riscv,raw-event-to-mhpmcounters");
+	if (prop != NULL) {
+		n = fdt32_to_cpu(prop->len) / (5 * sizeof(u32));
+		for (i = 0; i < n; i++) {
+			pmu->rawCounters |= fdt32_to_cpu(prop->data[5 * i + 4]);
+		}
+	}
+
+	return FDT_EOK;
+}
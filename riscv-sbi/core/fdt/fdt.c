@@ -19,6 +19,16 @@
 
 #define CEIL(x, y) (((x) + (y) - 1) & ~((y) - 1))
 
+/* Index capacity, larger trees are walked instead */
+#define FDT_MAX_NODES    256
+#define FDT_MAX_COMPAT   384
+#define FDT_MAX_PHANDLES 256
+
+/* Index keys are (value << 32) | node index */
+#define FDT_KEY(v, node) (((u64)(v) << 32) | (u32)(node))
+#define FDT_KEY_VAL(key) ((u32)((key) >> 32))
+#define FDT_KEY_NODE(key) ((u32)(key))
+
 
 typedef struct {
 	u32 magic;
@@ -34,10 +44,25 @@ typedef struct {
 } __attribute__((packed, aligned(4))) fdt_header_t;
 
 
+typedef struct {
+	u32 offset;
+	s32 depth;
+} fdt_node_t;
+
+
 static struct {
 	const void *fdt;
 	const void *dt_struct;
 	const void *dt_strings;
+
+	/* Index built once by fdt_init(), nodes are in structure block order */
+	int indexed;
+	size_t nodeCount;
+	size_t compatCount;
+	size_t phandleCount;
+	fdt_node_t nodes[FDT_MAX_NODES];
+	u64 compat[FDT_MAX_COMPAT];     /* Sorted (compatible string hash, node) */
+	u64 phandle[FDT_MAX_PHANDLES]; /* Sorted (phandle, node) */
 } fdt_common;
 
 
@@ -84,12 +109,90 @@ static const u32 *fdt_tryConsumeNode(const u32 *pos, ssize_t offset, int *depth)
 }
 
 
+static u32 fdt_hash(const char *s)
+{
+	/* FNV-1a */
+	u32 h = 0x811c9dc5u;
+
+	while (*s != '\0') {
+		h ^= (u8)*s++;
+		h *= 0x01000193u;
+	}
+
+	return h;
+}
+
+
+/* Returns index of the first key >= key */
+static size_t fdt_lowerBound(const u64 *keys, size_t n, u64 key)
+{
+	size_t lo = 0, hi = n, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (keys[mid] < key) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+
+static void fdt_sortKeys(u64 *keys, size_t n)
+{
+	size_t i, j;
+	u64 key;
+
+	/* Keys are mostly in order already (node index ascending) */
+	for (i = 1; i < n; i++) {
+		key = keys[i];
+		for (j = i; (j > 0) && (keys[j - 1] > key); j--) {
+			keys[j] = keys[j - 1];
+		}
+		keys[j] = key;
+	}
+}
+
+
+/* Gets index of the node at offset, offset 0 before the root node gives -1 */
+static int fdt_nodeIndex(ssize_t offset, ssize_t *idx)
+{
+	size_t lo = 0, hi = fdt_common.nodeCount, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (fdt_common.nodes[mid].offset == (u32)offset) {
+			*idx = (ssize_t)mid;
+			return FDT_EOK;
+		}
+		else if (fdt_common.nodes[mid].offset < (u32)offset) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	if (offset == 0) {
+		*idx = -1;
+		return FDT_EOK;
+	}
+
+	return FDT_EBADOFFS;
+}
+
+
 /* Returns the offset of the next node in the device tree */
 ssize_t fdt_nextNode(ssize_t offset, int *depth)
 {
 	const u32 *nextPos = (u32 *)((u8 *)fdt_common.dt_struct + offset);
 	const u32 *pos;
 	u32 token;
+	ssize_t i;
 
 	if ((size_t)offset >= (fdt32_to_cpu(((fdt_header_t *)fdt_common.fdt)->size_dt_struct)) || ((offset % sizeof(u32)) != 0)) {
 		return FDT_EBADOFFS;
@@ -99,6 +202,18 @@ ssize_t fdt_nextNode(ssize_t offset, int *depth)
 		return FDT_EBADOFFS;
 	}
 
+	if (fdt_common.indexed != 0) {
+		if (fdt_nodeIndex(offset, &i) < 0) {
+			return FDT_EBADOFFS;
+		}
+		if ((size_t)(i + 1) >= fdt_common.nodeCount) {
+			return FDT_EEND;
+		}
+		*depth = fdt_common.nodes[i + 1].depth;
+
+		return fdt_common.nodes[i + 1].offset;
+	}
+
 	nextPos = fdt_tryConsumeNode(nextPos, offset, depth);
 
 	do {
@@ -192,32 +307,70 @@ fdt_prop_t *fdt_getProperty(ssize_t offset, const char *name)
 }
 
 
-ssize_t fdt_findNodeByCompatible(ssize_t offset, int *depth, const char *compatible)
+static int fdt_isCompatible(ssize_t offset, const char *compatible)
 {
 	fdt_prop_t *prop;
 	ssize_t propOffset;
 	size_t propLen;
 	const char *propData, *currStr;
 
+	propOffset = fdt_getPropertyByName(offset, "compatible");
+	if (propOffset < 0) {
+		return 0;
+	}
+
+	prop = (fdt_prop_t *)((u8 *)fdt_common.dt_struct + propOffset);
+	propData = (const char *)prop->data;
+	propLen = fdt32_to_cpu(prop->len);
+
+	currStr = propData;
+	while (currStr < propData + propLen) {
+		if (sbi_strcmp(currStr, compatible) == 0) {
+			return 1;
+		}
+		currStr += sbi_strlen(currStr) + 1;
+	}
+
+	return 0;
+}
+
+
+ssize_t fdt_findNodeByCompatible(ssize_t offset, int *depth, const char *compatible)
+{
+	ssize_t i;
+	size_t k;
+	u32 hash, node;
+
+	if (fdt_common.indexed != 0) {
+		if (fdt_nodeIndex(offset, &i) < 0) {
+			return FDT_EBADOFFS;
+		}
+
+		/* First node after offset with matching hash, verify the string (hash collisions) */
+		hash = fdt_hash(compatible);
+		for (k = fdt_lowerBound(fdt_common.compat, fdt_common.compatCount, FDT_KEY(hash, i + 1)); k < fdt_common.compatCount; k++) {
+			if (FDT_KEY_VAL(fdt_common.compat[k]) != hash) {
+				break;
+			}
+
+			node = FDT_KEY_NODE(fdt_common.compat[k]);
+			if (fdt_isCompatible(fdt_common.nodes[node].offset, compatible) != 0) {
+				*depth = fdt_common.nodes[node].depth;
+				return fdt_common.nodes[node].offset;
+			}
+		}
+
+		return FDT_ENOTFOUND;
+	}
+
 	offset = fdt_nextNode(offset, depth);
 	if (offset < 0) {
 		return offset;
 	}
 
 	while (offset >= 0) {
-		propOffset = fdt_getPropertyByName(offset, "compatible");
-		if (propOffset >= 0) {
-			prop = (fdt_prop_t *)((u8 *)fdt_common.dt_struct + propOffset);
-			propData = (const char *)prop->data;
-			propLen = fdt32_to_cpu(prop->len);
-
-			currStr = propData;
-			while (currStr < propData + propLen) {
-				if (sbi_strcmp(currStr, compatible) == 0) {
-					return offset;
-				}
-				currStr += sbi_strlen(currStr) + 1;
-			}
+		if (fdt_isCompatible(offset, compatible) != 0) {
+			return offset;
 		}
 		offset = fdt_nextNode(offset, depth);
 	}
@@ -231,7 +384,25 @@ ssize_t fdt_findNodeByPhandle(ssize_t offset, int *depth, u32 phandle)
 	fdt_prop_t *prop;
 	ssize_t propOffset;
 	const u32 *propData;
-	u32 propLen;
+	u32 propLen, node;
+	ssize_t i;
+	size_t k;
+
+	if (fdt_common.indexed != 0) {
+		if (fdt_nodeIndex(offset, &i) < 0) {
+			return FDT_EBADOFFS;
+		}
+
+		k = fdt_lowerBound(fdt_common.phandle, fdt_common.phandleCount, FDT_KEY(phandle, i + 1));
+		if ((k == fdt_common.phandleCount) || (FDT_KEY_VAL(fdt_common.phandle[k]) != phandle)) {
+			return FDT_ENOTFOUND;
+		}
+
+		node = FDT_KEY_NODE(fdt_common.phandle[k]);
+		*depth = fdt_common.nodes[node].depth;
+
+		return fdt_common.nodes[node].offset;
+	}
 
 	offset = fdt_nextNode(offset, depth);
 	if (offset < 0) {
@@ -285,9 +456,82 @@ int fdt_getCellInfo(ssize_t offset, fdt_cellInfo_t *info)
 }
 
 
+/* Single pass over the structure block, indexes nodes, compatible strings and phandles */
+static int fdt_buildIndex(void)
+{
+	const u32 *pos = fdt_common.dt_struct;
+	const u32 *end = (const u32 *)((u8 *)fdt_common.dt_struct + fdt32_to_cpu(((fdt_header_t *)fdt_common.fdt)->size_dt_struct));
+	const fdt_prop_t *prop;
+	const char *name, *str, *strEnd;
+	s32 depth = -1;
+	u32 node = 0;
+
+	fdt_common.nodeCount = 0;
+	fdt_common.compatCount = 0;
+	fdt_common.phandleCount = 0;
+
+	while (pos < end) {
+		switch (fdt32_to_cpu(*pos)) {
+			case FDT_BEGIN_NODE:
+				if (fdt_common.nodeCount == FDT_MAX_NODES) {
+					return FDT_EBADSTRUCT;
+				}
+				node = fdt_common.nodeCount++;
+				fdt_common.nodes[node].offset = (u32)((addr_t)pos - (addr_t)fdt_common.dt_struct);
+				fdt_common.nodes[node].depth = ++depth;
+				pos = fdt_tryConsumeNode(pos, 1, NULL);
+				break;
+
+			case FDT_END_NODE:
+				depth--;
+				pos++;
+				break;
+
+			case FDT_PROP:
+				prop = (const fdt_prop_t *)pos;
+				name = (const char *)fdt_common.dt_strings + fdt32_to_cpu(prop->nameoff);
+				if (sbi_strcmp(name, "compatible") == 0) {
+					str = (const char *)prop->data;
+					strEnd = str + fdt32_to_cpu(prop->len);
+					while (str < strEnd) {
+						if (fdt_common.compatCount == FDT_MAX_COMPAT) {
+							return FDT_EBADSTRUCT;
+						}
+						fdt_common.compat[fdt_common.compatCount++] = FDT_KEY(fdt_hash(str), node);
+						str += sbi_strlen(str) + 1;
+					}
+				}
+				else if ((sbi_strcmp(name, "phandle") == 0) && (fdt32_to_cpu(prop->len) == sizeof(u32))) {
+					if (fdt_common.phandleCount == FDT_MAX_PHANDLES) {
+						return FDT_EBADSTRUCT;
+					}
+					fdt_common.phandle[fdt_common.phandleCount++] = FDT_KEY(fdt32_to_cpu(prop->data[0]), node);
+				}
+				pos = (const u32 *)((addr_t)pos + fdt_consumeProp(pos));
+				break;
+
+			case FDT_END:
+				fdt_sortKeys(fdt_common.compat, fdt_common.compatCount);
+				fdt_sortKeys(fdt_common.phandle, fdt_common.phandleCount);
+				return FDT_EOK;
+
+			case FDT_NOP:
+			default:
+				pos++;
+				break;
+		}
+	}
+
+	return FDT_EBADSTRUCT;
+}
+
+
 void fdt_init(const void *fdt)
 {
 	fdt_common.fdt = fdt;
 	fdt_common.dt_struct = fdt_get_off_dt_struct(fdt);
 	fdt_common.dt_strings = fdt_get_off_dt_strings(fdt);
+
+	/* Queries walk the tree if the index doesn't fit */
+	fdt_common.indexed = (fdt_buildIndex() == FDT_EOK) ? 1 : 0;
 }
@@ -14,9 +14,15 @@
  */
 
 #include "csr.h"
+#include "fdt.h"
 #include "hart.h"
 
 
+static struct {
+	u32 features;
+} hart_common;
+
+
 void __attribute__((noreturn)) hart_halt(void)
 {
 	while (1) {
@@ -54,6 +60,92 @@ void __attribute__((noreturn)) hart_changeMode(sbi_param arg0, sbi_param arg1, a
 }
 
 
+void hart_detectFeatures(void)
+{
+	if (fdt_cpusHaveIsaExt("sstc") > 0) {
+		hart_common.features |= HART_FEATURE_SSTC;
+	}
+
+	if (fdt_cpusHaveIsaExt("sscofpmf") > 0) {
+		hart_common.features |= HART_FEATURE_SSCOFPMF;
+	}
+}
+
+
+int hart_hasFeature(u32 feature)
+{
+	return ((hart_common.features & feature) != 0) ? 1 : 0;
+}
+
+
+/* Returns pmpaddr of the entry, the CSR number has to be a constant */
+static unsigned long hart_pmpAddr(unsigned int i)
+{
+	switch (i) {
+		case 0: return csr_read(CSR_PMPADDR0);
+		case 1: return csr_read(CSR_PMPADDR0 + 1);
+		case 2: return csr_read(CSR_PMPADDR0 + 2);
+		case 3: return csr_read(CSR_PMPADDR0 + 3);
+		case 4: return csr_read(CSR_PMPADDR0 + 4);
+		case 5: return csr_read(CSR_PMPADDR0 + 5);
+		case 6: return csr_read(CSR_PMPADDR0 + 6);
+		case 7: return csr_read(CSR_PMPADDR0 + 7);
+		case 8: return csr_read(CSR_PMPADDR0 + 8);
+		case 9: return csr_read(CSR_PMPADDR0 + 9);
+		case 10: return csr_read(CSR_PMPADDR0 + 10);
+		case 11: return csr_read(CSR_PMPADDR0 + 11);
+		case 12: return csr_read(CSR_PMPADDR0 + 12);
+		case 13: return csr_read(CSR_PMPADDR0 + 13);
+		case 14: return csr_read(CSR_PMPADDR0 + 14);
+		default: return csr_read(CSR_PMPADDR0 + 15);
+	}
+}
+
+
+int hart_pmpAllows(addr_t addr, unsigned long perm)
+{
+	const unsigned long cfgs[2] = { csr_read(CSR_PMPCFG0), csr_read(CSR_PMPCFG2) };
+	unsigned long cfg, pmpaddr, prev = 0, word = addr >> 2, active = 0;
+	unsigned int i;
+	int match;
+
+	/* The lowest numbered matching entry decides */
+	for (i = 0; i < 16; i++) {
+		cfg = (cfgs[i / 8] >> ((i % 8) * 8)) & 0xff;
+		pmpaddr = hart_pmpAddr(i);
+
+		switch (cfg & PMP_A) {
+			case PMP_A_TOR:
+				match = ((word >= prev) && (word < pmpaddr)) ? 1 : 0;
+				break;
+
+			case PMP_A_NA4:
+				match = (word == pmpaddr) ? 1 : 0;
+				break;
+
+			case PMP_A_NAPOT:
+				/* Trailing ones encode the region size */
+				match = (((word ^ pmpaddr) & ~(pmpaddr ^ (pmpaddr + 1))) == 0) ? 1 : 0;
+				break;
+
+			default:
+				match = 0;
+				break;
+		}
+
+		if (match != 0) {
+			return ((cfg & perm) == perm) ? 1 : 0;
+		}
+
+		active |= cfg & PMP_A;
+		prev = pmpaddr;
+	}
+
+	/* S-mode access not matching any entry fails, unless PMP is not used at all */
+	return (active == 0) ? 1 : 0;
+}
+
+
 void hart_init(void)
 {
 	/* Enable counters for supervisor */
@@ -65,11 +157,23 @@ void hart_init(void)
 	/* Delegate supervisor software, timer and external interrupts to S-Mode */
 	csr_write(CSR_MIDELEG, 0x222);
 
+	if (hart_hasFeature(HART_FEATURE_SSCOFPMF) != 0) {
+		/* Counter overflow interrupt is handled by S-Mode */
+		csr_set(CSR_MIDELEG, MIP_LCOFIP);
+	}
+
 	/* Delegate most exceptions to S-Mode
 	 * Change this if we want to emulate some functionality in M-Mode
+	 * Misaligned loads and stores are emulated in M-Mode
 	 */
-	csr_write(CSR_MEDELEG, 0xb1fb);
+	csr_write(CSR_MEDELEG, 0xb1ab);
 
 	/* Enable IPI */
 	csr_set(CSR_MIE, MIP_MSIP);
+
+	if (hart_hasFeature(HART_FEATURE_SSTC) != 0) {
+		/* S-mode programs stimecmp directly, STIP reflects stimecmp */
+		csr_write(CSR_STIMECMP, -1);
+		csr_set(CSR_MENVCFG, MENVCFG_STCE);
+	}
 }
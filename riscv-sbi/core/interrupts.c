@@ -16,10 +16,13 @@
 #include "csr.h"
 #include "devices/clint.h"
 #include "extensions/ipi.h"
+#include "extensions/pmu.h"
 
 
 void interrupts_dispatch(unsigned int irq)
 {
+	pmu_fwEvent(PMU_FW_PLATFORM_IRQ);
+
 	switch (irq) {
 		case IRQ_M_SOFT:
 			sbi_ipiHandler();
@@ -24,6 +24,7 @@
 
 #include "extensions/hsm.h"
 #include "extensions/ipi.h"
+#include "extensions/pmu.h"
 
 #if defined(__CPU_GR765)
 #include "ld/gr765.ldt"
@@ -42,12 +43,25 @@ extern const sbi_ext_t __ext_start[];
 extern const sbi_ext_t __ext_end[];
 
 
+/* Maximum number of extension table entries handled by the lookup table */
+#define SBI_EXT_MAX 32
+
+
 volatile u64 sbi_hartMask;
 
 
 static struct {
 	volatile u32 hartCount;
 	sbi_perHartData_t perHartData[MAX_HART_COUNT] __attribute__((aligned(8)));
+
+	/* Extensions sorted by eid, built once by the boot hart (0 - use linear scan) */
+	const sbi_ext_t *ext[SBI_EXT_MAX];
+	size_t extCount;
+
+	/* Most frequently called extensions */
+	const sbi_ext_t *extTime;
+	const sbi_ext_t *extIpi;
+	const sbi_ext_t *extRfence;
 } sbi_common;
 
 
@@ -87,23 +101,95 @@ unsigned int sbi_getFirstBit(unsigned long v)
 }
 
 
-sbiret_t sbi_dispatchEcall(sbi_param a0, sbi_param a1, sbi_param a2, sbi_param a3, sbi_param a4, sbi_param a5, int fid, int eid)
+static const sbi_ext_t *sbi_extScan(int eid)
 {
 	const sbi_ext_t *ext;
 
-	sbiret_t ret = {
-		.error = SBI_ERR_NOT_SUPPORTED,
-		.value = 0
-	};
-
 	for (ext = __ext_start; ext < __ext_end; ext++) {
 		if (ext->eid == eid) {
-			ret = ext->handler(a0, a1, a2, a3, a4, a5, fid);
+			return ext;
+		}
+	}
+
+	return NULL;
+}
+
+
+const sbi_ext_t *sbi_extFind(int eid)
+{
+	size_t lo, hi, mid;
+
+	switch (eid) {
+		case SBI_EXT_TIME:
+			return sbi_common.extTime;
+
+		case SBI_EXT_IPI:
+			return sbi_common.extIpi;
+
+		case SBI_EXT_RFENCE:
+			return sbi_common.extRfence;
+
+		default:
 			break;
+	}
+
+	if (sbi_common.extCount == 0) {
+		return sbi_extScan(eid);
+	}
+
+	lo = 0;
+	hi = sbi_common.extCount;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (sbi_common.ext[mid]->eid == eid) {
+			return sbi_common.ext[mid];
+		}
+		else if (sbi_common.ext[mid]->eid < eid) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
 		}
 	}
 
-	return ret;
+	return NULL;
+}
+
+
+static void sbi_extInit(void)
+{
+	const sbi_ext_t *ext;
+	size_t i, n = 0;
+
+	if ((size_t)(__ext_end - __ext_start) <= SBI_EXT_MAX) {
+		/* Insertion sort by eid, the table is small */
+		for (ext = __ext_start; ext < __ext_end; ext++) {
+			for (i = n; (i > 0) && (sbi_common.ext[i - 1]->eid > ext->eid); i--) {
+				sbi_common.ext[i] = sbi_common.ext[i - 1];
+			}
+			sbi_common.ext[i] = ext;
+			n++;
+		}
+	}
+
+	sbi_common.extCount = n;
+	sbi_common.extTime = sbi_extScan(SBI_EXT_TIME);
+	sbi_common.extIpi = sbi_extScan(SBI_EXT_IPI);
+	sbi_common.extRfence = sbi_extScan(SBI_EXT_RFENCE);
+}
+
+
+sbiret_t sbi_dispatchEcall(sbi_param a0, sbi_param a1, sbi_param a2, sbi_param a3, sbi_param a4, sbi_param a5, int fid, int eid)
+{
+	const sbi_ext_t *ext = sbi_extFind(eid);
+
+	pmu_fwEvent(PMU_FW_PLATFORM_ECALL);
+
+	if (ext == NULL) {
+		return (sbiret_t) { .error = SBI_ERR_NOT_SUPPORTED, .value = 0 };
+	}
+
+	return ext->handler(a0, a1, a2, a3, a4, a5, fid);
 }
 
 
@@ -137,13 +223,20 @@ void __attribute__((noreturn)) sbi_initCold(u32 hartid, const void *fdt)
 
 	sbi_common.hartCount = fdt_parseCpus();
 
+	sbi_extInit();
+
 	hsm_init(hartid);
 
+	hart_detectFeatures();
+	pmu_init();
 	hart_init();
+	pmu_hartInit();
 	console_init();
 	clint_init();
 	sbi_ipiInit();
 
+	sbi_common.perHartData[hartid].mtime = clint_getTimeAddr();
+
 	console_print("Phoenix SBI\n");
 
 	hsm_hartStartJump(hartid);
@@ -155,6 +248,10 @@ void __attribute__((noreturn)) sbi_initWarm(u32 hartid)
 	hsm_init(hartid);
 
 	hart_init();
+	pmu_hartInit();
+
+	/* CLINT is already initialized by the boot hart */
+	sbi_common.perHartData[hartid].mtime = clint_getTimeAddr();
 
 	hsm_hartStartJump(hartid);
 }
@@ -71,6 +71,12 @@ u64 clint_getTime(void)
 }
 
 
+addr_t clint_getTimeAddr(void)
+{
+	return (clint_common.base != 0) ? (clint_common.base + CLINT_MTIMER) : 0;
+}
+
+
 void clint_init(void)
 {
 	clint_info_t info;
@@ -51,6 +51,50 @@ int console_getc(void)
 }
 
 
+void console_write(const char *buff, size_t len)
+{
+	size_t i;
+
+	if (console_common.drv == NULL) {
+		return;
+	}
+
+	if (console_common.drv->write != NULL) {
+		console_common.drv->write(buff, len);
+	}
+	else {
+		for (i = 0; i < len; i++) {
+			console_common.drv->putc(buff[i]);
+		}
+	}
+}
+
+
+size_t console_read(char *buff, size_t len)
+{
+	size_t i;
+	int c;
+
+	if (console_common.drv == NULL) {
+		return 0;
+	}
+
+	if (console_common.drv->read != NULL) {
+		return console_common.drv->read(buff, len);
+	}
+
+	for (i = 0; i < len; i++) {
+		c = console_common.drv->getc();
+		if (c < 0) {
+			break;
+		}
+		buff[i] = (char)c;
+	}
+
+	return i;
+}
+
+
 void console_init(void)
 {
 	const uart_driver_t *drv;
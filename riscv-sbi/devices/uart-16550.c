@@ -16,6 +16,10 @@
 #include "devices/console.h"
 
 
+/* Transmit FIFO depth */
+#define UART16550_TXFIFO 16
+
+
 typedef struct {
 	unsigned int speed;
 	unsigned int divisor;
@@ -78,6 +82,33 @@ static int uart16550_getc(void)
 }
 
 
+static void uart16550_write(const char *buff, size_t len)
+{
+	size_t i = 0, n;
+
+	while (i < len) {
+		/* Wait until THR (FIFO) is empty, then fill the whole FIFO */
+		while ((readReg(lsr) & 0x20) == 0) { }
+
+		for (n = 0; (n < UART16550_TXFIFO) && (i < len); n++) {
+			setReg(thr, buff[i++]);
+		}
+	}
+}
+
+
+static size_t uart16550_read(char *buff, size_t len)
+{
+	size_t i;
+
+	for (i = 0; (i < len) && ((readReg(lsr) & 0x01) != 0); i++) {
+		buff[i] = readReg(rbr);
+	}
+
+	return i;
+}
+
+
 static int uart16550_init(const char *compatible)
 {
 	u16 bdiv;
@@ -117,6 +148,6 @@ static int uart16550_init(const char *compatible)
 
 
 static const uart_driver_t uart_16550[] __attribute__((section("uart_drivers"), used)) = {
-	{ .compatible = "ns16550a", .init = uart16550_init, .putc = uart16550_putc, .getc = uart16550_getc },
-	{ .compatible = "ns16550", .init = uart16550_init, .putc = uart16550_putc, .getc = uart16550_getc },
+	{ .compatible = "ns16550a", .init = uart16550_init, .putc = uart16550_putc, .getc = uart16550_getc, .write = uart16550_write, .read = uart16550_read },
+	{ .compatible = "ns16550", .init = uart16550_init, .putc = uart16550_putc, .getc = uart16550_getc, .write = uart16550_write, .read = uart16550_read },
 };
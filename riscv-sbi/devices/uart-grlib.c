@@ -60,6 +60,29 @@ static int uart_grlib_getc(void)
 }
 
 
+static void uart_grlib_write(const char *buff, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		while ((*(uart_grlib_common.base + uart_status) & TX_FIFO_FULL) != 0) { }
+		*(uart_grlib_common.base + uart_data) = buff[i];
+	}
+}
+
+
+static size_t uart_grlib_read(char *buff, size_t len)
+{
+	size_t i;
+
+	for (i = 0; (i < len) && ((*(uart_grlib_common.base + uart_status) & DATA_READY) != 0); i++) {
+		buff[i] = *(uart_grlib_common.base + uart_data) & 0xff;
+	}
+
+	return i;
+}
+
+
 static u32 uart_grlib_calcScaler(u32 freq, u32 baud)
 {
 	return (freq / (baud * 8 + 7));
@@ -87,5 +110,7 @@ static const uart_driver_t uart_grlib __attribute__((section("uart_drivers"), us
 	.compatible = "gaisler,apbuart",
 	.init = uart_grlib_init,
 	.putc = uart_grlib_putc,
-	.getc = uart_grlib_getc
+	.getc = uart_grlib_getc,
+	.write = uart_grlib_write,
+	.read = uart_grlib_read
 };
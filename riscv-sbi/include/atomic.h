@@ -69,6 +69,40 @@ static inline void atomic_add64(vu64 *ptr, u64 val)
 }
 
 
+static inline u64 atomic_or64(vu64 *ptr, u64 val)
+{
+	u64 prev;
+
+	/* clang-format off */
+	__asm__ volatile (
+		"amoor.d.aqrl %0, %2, (%1)"
+		: "=r" (prev), "+r" (ptr)
+		: "r" (val)
+		: "memory"
+	);
+	/* clang-format on */
+
+	return prev;
+}
+
+
+static inline u64 atomic_swap64(vu64 *ptr, u64 val)
+{
+	u64 prev;
+
+	/* clang-format off */
+	__asm__ volatile (
+		"amoswap.d.aqrl %0, %2, (%1)"
+		: "=r" (prev), "+r" (ptr)
+		: "r" (val)
+		: "memory"
+	);
+	/* clang-format on */
+
+	return prev;
+}
+
+
 #define ATOMIC_READ(ptr) ({ \
 	typeof(*ptr) ret = *ptr; \
 	RISCV_FENCE(ir, ir); \
@@ -109,6 +109,7 @@ int csr_emulateWrite(u32 csr, u64 val);
 #define CSR_SCOUNTEREN 0x106u
 #define CSR_SSCRATCH   0x140u
 #define CSR_SATP       0x180u
+#define CSR_STIMECMP   0x14du
 
 #define CSR_SEPC   0x141u
 #define CSR_SCAUSE 0x142u
@@ -126,6 +127,9 @@ int csr_emulateWrite(u32 csr, u64 val);
 #define CSR_MCOUNTEREN 0x306u
 #define CSR_MENVCFG    0x30au
 
+#define CSR_MCOUNTINHIBIT 0x320u
+#define CSR_MHPMEVENT3    0x323u
+
 #define CSR_MSCRATCH 0x340u
 #define CSR_MEPC     0x341u
 #define CSR_MCAUSE   0x342u
@@ -136,6 +140,8 @@ int csr_emulateWrite(u32 csr, u64 val);
 #define CSR_MCYCLE   0xb00u
 #define CSR_MINSTRET 0xb02u
 
+#define CSR_MHPMCOUNTER3 0xb03u
+
 #define CSR_MVENDORID 0xf11u
 #define CSR_MARCHID   0xf12u
 #define CSR_MIMPID    0xf13u
@@ -144,6 +150,7 @@ int csr_emulateWrite(u32 csr, u64 val);
 /* Machine memory protection */
 
 #define CSR_PMPCFG0  0x3a0u
+#define CSR_PMPCFG2  0x3a2u
 #define CSR_PMPADDR0 0x3b0u
 
 /* CSR bits */
@@ -159,6 +166,16 @@ int csr_emulateWrite(u32 csr, u64 val);
 
 #define MIE_MSIE (1UL << 3)
 
+#define MENVCFG_STCE (1UL << 63)
+
+/* Sscofpmf mhpmevent bits */
+#define MHPMEVENT_OF    (1UL << 63)
+#define MHPMEVENT_MINH  (1UL << 62)
+#define MHPMEVENT_SINH  (1UL << 61)
+#define MHPMEVENT_UINH  (1UL << 60)
+#define MHPMEVENT_VSINH (1UL << 59)
+#define MHPMEVENT_VUINH (1UL << 58)
+
 #define MIP_SSIP (1UL << IRQ_S_SOFT)
 #define MIP_MSIP (1UL << IRQ_M_SOFT)
 #define MIP_STIP (1UL << IRQ_S_TIMER)
@@ -166,11 +183,24 @@ int csr_emulateWrite(u32 csr, u64 val);
 #define MIP_SEIP (1UL << IRQ_S_EXT)
 #define MIP_MEIP (1UL << IRQ_M_EXT)
 
+#define MIP_LCOFIP (1UL << IRQ_PMU_OVF)
+
+/* PMP entry configuration */
+#define PMP_R       0x01UL
+#define PMP_W       0x02UL
+#define PMP_X       0x04UL
+#define PMP_A       0x18UL
+#define PMP_A_TOR   0x08UL
+#define PMP_A_NA4   0x10UL
+#define PMP_A_NAPOT 0x18UL
+
 #define MCAUSE_IRQ_MSK 0xffUL
 
-#define MCAUSE_ILLEGAL 0x2UL
-#define MCAUSE_S_ECALL 0x9UL
-#define MCAUSE_INTR    (1UL << 63)
+#define MCAUSE_ILLEGAL          0x2UL
+#define MCAUSE_LOAD_MISALIGNED  0x4UL
+#define MCAUSE_STORE_MISALIGNED 0x6UL
+#define MCAUSE_S_ECALL          0x9UL
+#define MCAUSE_INTR             (1UL << 63)
 
 /* Privilege levels */
 
@@ -40,6 +40,10 @@ void clint_setTimecmp(u64 time);
 u64 clint_getTime(void);
 
 
+/* Returns address of the mtime register, 0 if CLINT is not present */
+addr_t clint_getTimeAddr(void);
+
+
 void clint_init(void);
 
 
@@ -25,6 +25,8 @@ typedef struct {
 	int (*init)(const char *compatible);
 	void (*putc)(char c);
 	int (*getc)(void);
+	void (*write)(const char *buff, size_t len); /* Optional, bulk transmit */
+	size_t (*read)(char *buff, size_t len);      /* Optional, reads data available in RX FIFO */
 } uart_driver_t;
 
 
@@ -44,6 +46,14 @@ void console_print(const char *s);
 int console_getc(void);
 
 
+/* Transmits whole buffer */
+void console_write(const char *buff, size_t len);
+
+
+/* Reads up to `len` bytes without waiting, returns number of bytes read */
+size_t console_read(char *buff, size_t len);
+
+
 void console_init(void);
 
 
@@ -27,6 +27,14 @@ long hsm_hartStart(sbi_param hartid, sbi_param startAddr, sbi_param opaque);
 sbiret_t hsm_hartGetStatus(sbi_param hartid);
 
 
+/* Stops the calling hart, returns only on error */
+long hsm_hartStop(void);
+
+
+/* Suspends the calling hart, non-retentive suspend doesn't return on success */
+long hsm_hartSuspend(sbi_param type, sbi_param resumeAddr, sbi_param opaque);
+
+
 void __attribute__((noreturn)) hsm_hartStartJump(u32 hartid);
 
 
@@ -24,18 +24,31 @@
 typedef struct {
 	void (*handler)(void *);
 	void *data;
+	vu32 *done; /* Decremented after handler completes, can be NULL */
 } ipi_task_t;
 
 
 void sbi_ipiHandler(void);
 
 
+/* Serves IPI tasks queued for the current hart, if any */
+void sbi_ipiPoll(void);
+
+
+/* Raises IPI on the hart without queuing a task (e.g. to wake it up) */
+void sbi_ipiRawSend(u32 hartid);
+
+
 long sbi_ipiSend(u32 hartid, void (*handler)(void *), void *data);
 
 
 long sbi_ipiSendMany(unsigned long hartMask, unsigned long hartMaskBase, void (*handler)(void *), void *data);
 
 
+/* Same as sbi_ipiSendMany, but returns after handler completes on all target harts */
+long sbi_ipiSendManySync(unsigned long hartMask, unsigned long hartMaskBase, void (*handler)(void *), void *data);
+
+
 void sbi_ipiInit(void);
 
 
@@ -0,0 +1,116 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Phoenix SBI
+ *
+ * PMU definitions
+ *
+ * Copyright 2026 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+
+#ifndef _SBI_PMU_H_
+#define _SBI_PMU_H_
+
+
+#include "sbi.h"
+#include "types.h"
+
+
+/* Event index: type [19:16], code [15:0] */
+#define PMU_EVENT_TYPE(idx) (((idx) >> 16) & 0xfu)
+#define PMU_EVENT_CODE(idx) ((idx) & 0xffffu)
+
+#define PMU_EVENT_TYPE_HW       0x0u
+#define PMU_EVENT_TYPE_HW_CACHE 0x1u
+#define PMU_EVENT_TYPE_HW_RAW   0x2u
+#define PMU_EVENT_TYPE_FW       0xfu
+
+#define PMU_HW_CPU_CYCLES   1u
+#define PMU_HW_INSTRUCTIONS 2u
+
+/* Firmware events */
+#define PMU_FW_MISALIGNED_LOAD          0u
+#define PMU_FW_MISALIGNED_STORE         1u
+#define PMU_FW_ACCESS_LOAD              2u
+#define PMU_FW_ACCESS_STORE             3u
+#define PMU_FW_ILLEGAL_INSN             4u
+#define PMU_FW_SET_TIMER                5u
+#define PMU_FW_IPI_SENT                 6u
+#define PMU_FW_IPI_RECEIVED             7u
+#define PMU_FW_FENCE_I_SENT             8u
+#define PMU_FW_FENCE_I_RECEIVED         9u
+#define PMU_FW_SFENCE_VMA_SENT          10u
+#define PMU_FW_SFENCE_VMA_RECEIVED      11u
+#define PMU_FW_SFENCE_VMA_ASID_SENT     12u
+#define PMU_FW_SFENCE_VMA_ASID_RECEIVED 13u
+#define PMU_FW_PLATFORM                 0xffffu
+
+/* Platform firmware events (PMU_FW_PLATFORM event_data), counted after the standard ones */
+#define PMU_FW_PLATFORM_BASE  22u
+#define PMU_FW_PLATFORM_ECALL (PMU_FW_PLATFORM_BASE + 0u) /* ecalls handled */
+#define PMU_FW_PLATFORM_TRAP  (PMU_FW_PLATFORM_BASE + 1u) /* M-mode exceptions handled */
+#define PMU_FW_PLATFORM_IRQ   (PMU_FW_PLATFORM_BASE + 2u) /* M-mode interrupts handled */
+#define PMU_FW_EVENT_COUNT    (PMU_FW_PLATFORM_BASE + 3u)
+
+/* Event to counter mapping, from the riscv,pmu FDT node */
+#define PMU_MAP_MAX 32
+
+
+typedef struct {
+	u32 start; /* First event index */
+	u32 end;   /* Last event index */
+	u32 counters;
+} pmu_counterMap_t;
+
+
+typedef struct {
+	u32 event;
+	u64 selector; /* mhpmevent value */
+} pmu_eventMap_t;
+
+
+typedef struct {
+	pmu_counterMap_t counterMap[PMU_MAP_MAX];
+	size_t counterMapCount;
+	pmu_eventMap_t eventMap[PMU_MAP_MAX];
+	size_t eventMapCount;
+	u32 rawCounters; /* Counters accepting raw events */
+} pmu_info_t;
+
+
+/* Counts firmware event on the current hart */
+void pmu_fwEvent(unsigned int event);
+
+
+long pmu_numCounters(void);
+
+
+sbiret_t pmu_counterGetInfo(unsigned long idx);
+
+
+sbiret_t pmu_counterConfigMatching(unsigned long base, unsigned long mask, unsigned long flags, unsigned long event, u64 data);
+
+
+long pmu_counterStart(unsigned long base, unsigned long mask, unsigned long flags, u64 value);
+
+
+long pmu_counterStop(unsigned long base, unsigned long mask, unsigned long flags);
+
+
+sbiret_t pmu_counterFwRead(unsigned long idx);
+
+
+/* Reads platform counter map, called once by the boot hart */
+void pmu_init(void);
+
+
+/* Resets counters of the current hart */
+void pmu_hartInit(void);
+
+
+#endif
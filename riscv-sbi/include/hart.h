@@ -55,12 +55,28 @@
 /* clang-format on */
 
 
+/* Hart features */
+#define HART_FEATURE_SSTC     (1U << 0)
+#define HART_FEATURE_SSCOFPMF (1U << 1)
+
+
 void __attribute__((noreturn)) hart_halt(void);
 
 
 void __attribute__((noreturn)) hart_changeMode(sbi_param ar0, sbi_param arg1, addr_t nextAddr, sbi_param nextMode);
 
 
+/* Detects features common to all harts, called once by the boot hart */
+void hart_detectFeatures(void);
+
+
+int hart_hasFeature(u32 feature);
+
+
+/* Checks whether PMP of the current hart grants S-mode the perm (PMP_R/W/X) access to addr */
+int hart_pmpAllows(addr_t addr, unsigned long perm);
+
+
 void hart_init(void);
 
 
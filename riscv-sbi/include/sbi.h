@@ -38,6 +38,8 @@
 #define SBI_EXT_IPI    0x735049
 #define SBI_EXT_RFENCE 0x52464E43
 #define SBI_EXT_HSM    0x48534D
+#define SBI_EXT_PMU    0x504D55
+#define SBI_EXT_DBCN   0x4442434E
 
 
 /* HSM extension: Hart states */
@@ -50,7 +52,12 @@
 #define SBI_HSM_RESUME_PENDING  6
 
 
-#define SIZEOF_SBI_PERHARTDATA 40
+#define SIZEOF_SBI_PERHARTDATA 64
+
+/* sbi_perHartData_t offsets used by the trap entry */
+#define SBI_PERHART_SCRATCH  8
+#define SBI_PERHART_MTIME    40
+#define SBI_PERHART_FASTSAVE 48
 
 #define PAGE_SIZE 0x1000
 
@@ -82,10 +89,15 @@ typedef struct {
 	volatile addr_t state;    /* current hart state */
 	volatile addr_t nextArg1; /* 'a1' register for next boot stage */
 	volatile addr_t nextAddr; /* address of next boot stage */
+	addr_t mtime;             /* mtime register address for time CSR emulation (0 - none) */
+	addr_t fastSave[2];       /* registers saved by trap fast path */
 } __attribute__((packed, aligned(8))) sbi_perHartData_t;
 
 
 _Static_assert(sizeof(sbi_perHartData_t) == SIZEOF_SBI_PERHARTDATA, "sbi_perHartData_t size changed, update SIZEOF_SBI_PERHARTDATA");
+_Static_assert(__builtin_offsetof(sbi_perHartData_t, scratch) == SBI_PERHART_SCRATCH, "update SBI_PERHART_SCRATCH");
+_Static_assert(__builtin_offsetof(sbi_perHartData_t, mtime) == SBI_PERHART_MTIME, "update SBI_PERHART_MTIME");
+_Static_assert(__builtin_offsetof(sbi_perHartData_t, fastSave) == SBI_PERHART_FASTSAVE, "update SBI_PERHART_FASTSAVE");
 
 
 extern volatile u64 sbi_hartMask;
@@ -94,6 +106,10 @@ extern volatile u64 sbi_hartMask;
 unsigned int sbi_getFirstBit(unsigned long v);
 
 
+/* Returns extension handling `eid` or NULL if not supported */
+const sbi_ext_t *sbi_extFind(int eid);
+
+
 sbi_perHartData_t *sbi_getPerHartData(u32 hartid);
 
 
@@ -399,6 +399,28 @@ mapent_t *syspage_entryAdd(const char *mapName, addr_t start, size_t size, unsig
 }
 
 
+int syspage_mapFreeArea(const char *name, size_t size, unsigned int align, addr_t *start)
+{
+	const syspage_map_t *map = syspage_mapGet(name);
+
+	if (map == NULL) {
+		log_error("\nsyspage: %s does not exist", name);
+		return -EINVAL;
+	}
+
+	if (syspage_bestFit(map, size, align, start) < 0) {
+		return -ENOMEM;
+	}
+
+	/* Map without entries is not checked by best fit */
+	if ((*start < map->start) || ((*start + size) > map->end)) {
+		return -ENOMEM;
+	}
+
+	return EOK;
+}
+
+
 int syspage_mapAttrResolve(const char *name, unsigned int *attr)
 {
 	const syspage_map_t *map = syspage_mapGet(name);
@@ -671,6 +693,148 @@ void *syspage_progAllocateAndAdd(const char *map, size_t size, const char *argv,
 }
 
 
+/* Flat layout */
+
+int syspage_flatten(void)
+{
+	syspage_t *syspage = syspage_common.syspage;
+	const syspage_map_t *map;
+	const syspage_prog_t *prog;
+	const mapent_t *e;
+	syspage_flatHdr_t *hdr;
+	syspage_flatMap_t *fmap;
+	syspage_flatEntry_t *fentry;
+	syspage_flatProg_t *fprog;
+	size_t nmaps = 0, nentries = 0, nprogs = 0, dataSz = 0, len;
+	size_t hdrOffs, mapsOffs, entriesOffs, progsOffs, dataOffs, size, prevSize = syspage->size;
+	char *img;
+
+	map = syspage->maps;
+	if (map != NULL) {
+		do {
+			nmaps++;
+			dataSz += hal_strlen(map->name) + 1;
+			e = map->entries;
+			if (e != NULL) {
+				do {
+					nentries++;
+					e = e->next;
+				} while (e != map->entries);
+			}
+			map = map->next;
+		} while (map != syspage->maps);
+	}
+
+	prog = syspage->progs;
+	if (prog != NULL) {
+		do {
+			nprogs++;
+			dataSz += hal_strlen(prog->argv) + 1 + prog->imapSz + prog->dmapSz;
+			prog = prog->next;
+		} while (prog != syspage->progs);
+	}
+
+	hdrOffs = offsetof(syspage_t, size);
+	mapsOffs = ALIGN_ADDR(hdrOffs + sizeof(syspage_flatHdr_t), sizeof(long long));
+	entriesOffs = ALIGN_ADDR(mapsOffs + nmaps * sizeof(syspage_flatMap_t), sizeof(long long));
+	progsOffs = ALIGN_ADDR(entriesOffs + nentries * sizeof(syspage_flatEntry_t), sizeof(long long));
+	dataOffs = progsOffs + nprogs * sizeof(syspage_flatProg_t);
+	size = ALIGN_ADDR(dataOffs + dataSz, sizeof(long long));
+
+	/* Image is built above the lists and then moved over them, so it can't be larger */
+	if (size > prevSize) {
+		return -ENOMEM;
+	}
+
+	img = syspage_alloc(size);
+	if (img == NULL) {
+		return -ENOMEM;
+	}
+	hal_memset(img, 0, size);
+
+	hdr = (syspage_flatHdr_t *)(img + hdrOffs);
+	hdr->magic = SYSPAGE_FLAT_MAGIC;
+	hdr->version = SYSPAGE_FLAT_VERSION;
+	hdr->size = size;
+	hdr->console = syspage->console;
+	hdr->pkernel = syspage->pkernel;
+	hdr->maps = mapsOffs;
+	hdr->mapCnt = nmaps;
+	hdr->entries = entriesOffs;
+	hdr->entryCnt = nentries;
+	hdr->progs = progsOffs;
+	hdr->progCnt = nprogs;
+
+	fmap = (syspage_flatMap_t *)(img + mapsOffs);
+	fentry = (syspage_flatEntry_t *)(img + entriesOffs);
+	fprog = (syspage_flatProg_t *)(img + progsOffs);
+	nentries = 0;
+
+	map = syspage->maps;
+	if (map != NULL) {
+		do {
+			fmap->start = map->start;
+			fmap->end = map->end;
+			fmap->attr = map->attr;
+			fmap->id = map->id;
+			fmap->entry = nentries;
+
+			len = hal_strlen(map->name) + 1;
+			hal_memcpy(img + dataOffs, map->name, len);
+			fmap->name = dataOffs;
+			dataOffs += len;
+
+			e = map->entries;
+			if (e != NULL) {
+				do {
+					fentry->start = e->start;
+					fentry->end = e->end;
+					fentry->type = e->type;
+					fentry++;
+					nentries++;
+					e = e->next;
+				} while (e != map->entries);
+			}
+			fmap->entryCnt = nentries - fmap->entry;
+			fmap++;
+			map = map->next;
+		} while (map != syspage->maps);
+	}
+
+	prog = syspage->progs;
+	if (prog != NULL) {
+		do {
+			fprog->start = prog->start;
+			fprog->end = prog->end;
+
+			len = hal_strlen(prog->argv) + 1;
+			hal_memcpy(img + dataOffs, prog->argv, len);
+			fprog->argv = dataOffs;
+			dataOffs += len;
+
+			hal_memcpy(img + dataOffs, prog->imaps, prog->imapSz);
+			fprog->imaps = dataOffs;
+			fprog->imapSz = prog->imapSz;
+			dataOffs += prog->imapSz;
+
+			hal_memcpy(img + dataOffs, prog->dmaps, prog->dmapSz);
+			fprog->dmaps = dataOffs;
+			fprog->dmapSz = prog->dmapSz;
+			dataOffs += prog->dmapSz;
+
+			fprog++;
+			prog = prog->next;
+		} while (prog != syspage->progs);
+	}
+
+	/* hal_syspage_t stays in place, the rest is replaced by the image */
+	hal_memcpy((char *)syspage + hdrOffs, img + hdrOffs, size - hdrOffs);
+	syspage_common.heapTop = (char *)syspage + size;
+
+	return EOK;
+}
+
+
 /* TODO: function get value from hal-specific struct, consider move to target-specific code */
 #if defined(HAS_GRAPHICS) && HAS_GRAPHICS != 0
 void syspage_graphmodeSet(graphmode_t graphmode)
@@ -31,6 +31,57 @@ typedef struct {
 } __attribute__((packed)) graphmode_t;
 
 
+/* Flat syspage layout, handed to the kernel instead of the lists on request.
+ * The header replaces syspage_t fields following hal_syspage_t, its magic is placed where
+ * the list layout keeps the syspage size. All references are offsets from the syspage start. */
+#define SYSPAGE_FLAT_MAGIC   0x32737973u /* "sys2" */
+#define SYSPAGE_FLAT_VERSION 2u
+
+
+typedef struct {
+	u32 magic;
+	u32 version;
+	u32 size;    /* Size of the whole image including hal_syspage_t */
+	u32 console;
+	addr_t pkernel;
+	u32 maps;    /* Offset of syspage_flatMap_t array */
+	u32 mapCnt;
+	u32 entries; /* Offset of syspage_flatEntry_t array */
+	u32 entryCnt;
+	u32 progs;   /* Offset of syspage_flatProg_t array */
+	u32 progCnt;
+} syspage_flatHdr_t;
+
+
+typedef struct {
+	addr_t start;
+	addr_t end;
+	u32 attr;
+	u32 name;  /* Offset of the name string */
+	u32 entry; /* Index of the first entry, entries of a map are sorted by address */
+	u32 entryCnt;
+	u32 id;
+} syspage_flatMap_t;
+
+
+typedef struct {
+	addr_t start;
+	addr_t end;
+	u32 type;
+} syspage_flatEntry_t;
+
+
+typedef struct {
+	addr_t start;
+	addr_t end;
+	u32 argv;  /* Offset of the argv string */
+	u32 imaps; /* Offset of u8 array of map ids */
+	u32 imapSz;
+	u32 dmaps;
+	u32 dmapSz;
+} syspage_flatProg_t;
+
+
 /* General functions */
 extern void syspage_init(void);
 
@@ -41,6 +92,10 @@ extern void *syspage_alloc(size_t size);
 extern void syspage_kernelPAddrAdd(addr_t address);
 
 
+/* Converts syspage into the flat layout, has to be called right before jumping to the kernel */
+extern int syspage_flatten(void);
+
+
 /* Map's functions */
 extern int syspage_mapAdd(const char *name, addr_t start, addr_t end, const char *attr);
 
@@ -66,6 +121,10 @@ extern void syspage_mapShow(void);
 extern mapent_t *syspage_entryAdd(const char *mapName, addr_t start, size_t size, unsigned int align);
 
 
+/* Finds free area of the given size in the map, without allocating it */
+extern int syspage_mapFreeArea(const char *name, size_t size, unsigned int align, addr_t *start);
+
+
 /* Program's functions */
 extern syspage_prog_t *syspage_progAdd(const char *argv, u32 flags);
 